@@ -0,0 +1,196 @@
+// Loopback harness for the shared-memory event ring. By default it runs a
+// producer and a consumer thread in this process, each with its own mapping
+// of the region, checks that every event arrives intact and in order, and
+// reports throughput and push-to-pop latency. With --produce it instead
+// plays a metronome into a real sound_server.py --ring consumer.
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "event_ring.h"
+#include "platform.h"
+
+#define LOOPBACK_NAME "/lsdvis_loopback"
+#define THROUGHPUT_EVENTS 5000000
+#define LATENCY_EVENTS 20000
+#define SAMPLE_RATE 44100
+
+typedef struct
+{
+    volatile int32_t ready;
+    int64_t received;
+    int64_t errors;
+    int64_t *latencies; // Nanoseconds, latency phase only
+} Consumer;
+
+static int64_t nowNs(void)
+{
+    return (int64_t)(platformTimeSeconds() * 1e9);
+}
+
+static void consumerMain(void *arg)
+{
+    Consumer *consumer = arg;
+    EventRing ring;
+    if (!eventRingOpen(&ring, LOOPBACK_NAME))
+    {
+        consumer->errors = -1;
+        atomicStore32(&consumer->ready, 1);
+        return;
+    }
+    atomicStore32(&consumer->ready, 1);
+
+    // Throughput phase: frame == sequence, frequency derived from it
+    int64_t total = THROUGHPUT_EVENTS + LATENCY_EVENTS;
+    RingEvent event;
+    while (consumer->received < total)
+    {
+        if (!eventRingPop(&ring, &event))
+        {
+            platformYield();
+            continue;
+        }
+        int64_t index = consumer->received;
+        if (event.sequence != (uint32_t)index)
+            consumer->errors++;
+        if (index < THROUGHPUT_EVENTS)
+        {
+            if (event.frame != index || event.frequency != (float)(index & 1023) ||
+                event.type != RING_EVENT_NOTE_ON)
+                consumer->errors++;
+        }
+        else
+        {
+            // Latency phase: frame carries the push time
+            consumer->latencies[index - THROUGHPUT_EVENTS] = nowNs() - event.frame;
+        }
+        consumer->received++;
+    }
+    eventRingClose(&ring);
+}
+
+static int compareInt64(const void *a, const void *b)
+{
+    int64_t x = *(const int64_t *)a;
+    int64_t y = *(const int64_t *)b;
+    return (x > y) - (x < y);
+}
+
+static int loopback(void)
+{
+    EventRing ring;
+    if (!eventRingCreate(&ring, LOOPBACK_NAME, EVENT_RING_DEFAULT_CAPACITY, SAMPLE_RATE))
+    {
+        fprintf(stderr, "Failed to create shared memory %s\n", LOOPBACK_NAME);
+        return 1;
+    }
+
+    Consumer consumer = {0};
+    consumer.latencies = calloc(LATENCY_EVENTS, sizeof(int64_t));
+    PlatformThread *thread = consumer.latencies ? platformThreadStart(consumerMain, &consumer) : NULL;
+    if (!thread)
+    {
+        fprintf(stderr, "Failed to start consumer\n");
+        eventRingClose(&ring);
+        return 1;
+    }
+    while (!atomicLoad32(&consumer.ready))
+        platformYield();
+
+    double start = platformTimeSeconds();
+    RingEvent event = {0};
+    event.type = RING_EVENT_NOTE_ON;
+    for (int64_t i = 0; i < THROUGHPUT_EVENTS && consumer.errors >= 0; i++)
+    {
+        event.frame = i;
+        event.frequency = (float)(i & 1023);
+        while (!eventRingPush(&ring, &event))
+            platformYield();
+    }
+    double elapsed = platformTimeSeconds() - start;
+
+    // One event at a time into an empty ring, like a sequencer step
+    for (int i = 0; i < LATENCY_EVENTS && consumer.errors >= 0; i++)
+    {
+        int64_t due = nowNs() + 20000;
+        while (nowNs() < due)
+            platformYield();
+        event.frame = nowNs();
+        while (!eventRingPush(&ring, &event))
+            platformYield();
+    }
+    platformThreadJoin(thread);
+    eventRingClose(&ring);
+
+    if (consumer.errors < 0)
+    {
+        fprintf(stderr, "Consumer could not open %s\n", LOOPBACK_NAME);
+        free(consumer.latencies);
+        return 1;
+    }
+    qsort(consumer.latencies, LATENCY_EVENTS, sizeof(int64_t), compareInt64);
+    printf("Throughput: %d events in %.1f ms (%.1f M events/s)\n",
+           THROUGHPUT_EVENTS, elapsed * 1000.0, THROUGHPUT_EVENTS / elapsed / 1e6);
+    printf("Latency:    p50 %lld ns, p99 %lld ns, max %lld ns\n",
+           (long long)consumer.latencies[LATENCY_EVENTS / 2],
+           (long long)consumer.latencies[LATENCY_EVENTS * 99 / 100],
+           (long long)consumer.latencies[LATENCY_EVENTS - 1]);
+    printf("Errors:     %lld\n", (long long)consumer.errors);
+    free(consumer.latencies);
+    return consumer.errors ? 1 : 0;
+}
+
+// Four beats per second for `seconds`, scheduled 50 ms ahead of the
+// consumer's clock the same way the sequencer does it
+static int produce(const char *name, double seconds)
+{
+    EventRing ring;
+    if (!eventRingCreate(&ring, name, EVENT_RING_DEFAULT_CAPACITY, SAMPLE_RATE))
+    {
+        fprintf(stderr, "Failed to create shared memory %s\n", name);
+        return 1;
+    }
+    printf("Waiting for a consumer on %s...\n", name);
+    while (eventRingConsumerFrame(&ring) == 0)
+        platformSleepMs(10);
+
+    const int64_t beatFrames = SAMPLE_RATE / 4;
+    const int64_t lookahead = SAMPLE_RATE / 20;
+    int64_t first = eventRingConsumerFrame(&ring) + lookahead;
+    int64_t end = first + (int64_t)(seconds * SAMPLE_RATE);
+    int64_t next = first;
+    int beat = 0;
+    while (next < end)
+    {
+        while (next < eventRingConsumerFrame(&ring) + lookahead && next < end)
+        {
+            RingEvent event = {0};
+            event.frame = next;
+            event.frequency = beat % 4 == 0 ? 880.0f : 440.0f;
+            event.length = beatFrames / 4;
+            event.type = RING_EVENT_NOTE_ON;
+            event.velocity = 100;
+            if (!eventRingPush(&ring, &event))
+                fprintf(stderr, "Ring full\n");
+            next += beatFrames;
+            beat++;
+        }
+        platformSleepMs(2);
+    }
+    printf("Sent %d beats; consumer at frame %lld\n", beat, (long long)eventRingConsumerFrame(&ring));
+    platformSleepMs(500);
+    eventRingClose(&ring);
+    return 0;
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc >= 2 && strcmp(argv[1], "--produce") == 0)
+        return produce(argc >= 3 ? argv[2] : EVENT_RING_DEFAULT_NAME, argc >= 4 ? atof(argv[3]) : 5.0);
+    if (argc > 1)
+    {
+        fprintf(stderr, "Usage: %s [--produce [name] [seconds]]\n", argv[0]);
+        return 1;
+    }
+    return loopback();
+}
@@ -0,0 +1,195 @@
+// Standard MIDI File throughput: writes synthetic multi-track files of
+// growing size (running status, program changes, tempo changes, text and
+// sysex events, a drum channel), imports each into a pattern, exports the
+// pattern back out and imports that again, checking both imports agree.
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "midi_file.h"
+#include "pattern.h"
+#include "platform.h"
+
+#define BENCH_TRACKS 16
+#define BENCH_DIVISION 480
+#define BENCH_SOURCE "midi_bench.mid"
+#define BENCH_EXPORT "midi_bench_export.mid"
+
+// Note-on/note-off pairs per track for each file
+static const int PAIRS_PER_TRACK[] = {4096, 65536, 262144};
+
+static void putBig(FILE *file, unsigned long value, int bytes)
+{
+    while (bytes-- > 0)
+        putc((int)(value >> (bytes * 8)) & 0xFF, file);
+}
+
+static void putVarLen(FILE *file, unsigned long value)
+{
+    unsigned char bytes[5];
+    int count = 0;
+    bytes[count++] = value & 0x7F;
+    while (value >>= 7)
+        bytes[count++] = 0x80 | (value & 0x7F);
+    while (count > 0)
+        putc(bytes[--count], file);
+}
+
+static unsigned int nextRandom(unsigned int *seed)
+{
+    *seed = *seed * 1103515245u + 12345u;
+    return *seed >> 8;
+}
+
+// A format 1 file: a tempo track, then BENCH_TRACKS note tracks, one per
+// channel. Returns its size in bytes, 0 on failure.
+static long writeSynthetic(const char *path, int pairs)
+{
+    FILE *file = fopen(path, "wb");
+    if (!file)
+        return 0;
+    fwrite("MThd", 1, 4, file);
+    putBig(file, 6, 4);
+    putBig(file, 1, 2);
+    putBig(file, BENCH_TRACKS + 1, 2);
+    putBig(file, BENCH_DIVISION, 2);
+
+    // Tempo track: 120 BPM, then a change every 64 beats
+    long lengthOffset;
+    fwrite("MTrk", 1, 4, file);
+    lengthOffset = ftell(file);
+    putBig(file, 0, 4);
+    long beats = (long)pairs * 120 / BENCH_DIVISION; // Pairs average 120 ticks
+    for (long beat = 0; beat < beats; beat += 64)
+    {
+        putVarLen(file, beat == 0 ? 0 : 64 * BENCH_DIVISION);
+        fwrite("\xFF\x51\x03", 1, 3, file);
+        putBig(file, 500000 - (unsigned long)(beat / 64 % 8) * 10000, 3);
+    }
+    fwrite("\x00\xFF\x2F\x00", 1, 4, file);
+    long end = ftell(file);
+    fseek(file, lengthOffset, SEEK_SET);
+    putBig(file, (unsigned long)(end - lengthOffset - 4), 4);
+    fseek(file, end, SEEK_SET);
+
+    unsigned int seed = 42;
+    for (int track = 0; track < BENCH_TRACKS; track++)
+    {
+        int channel = track;
+        fwrite("MTrk", 1, 4, file);
+        lengthOffset = ftell(file);
+        putBig(file, 0, 4);
+        fwrite("\x00\xFF\x03\x05Track", 1, 9, file);
+        putVarLen(file, 0);
+        putc(0xC0 | channel, file);
+        putc(track * 8 % 128, file);
+
+        int status = 0;
+        for (int i = 0; i < pairs; i++)
+        {
+            // Now and then a sysex or text event, which cancels running status
+            if (i % 1024 == 1023)
+            {
+                fwrite("\x00\xF0\x05\x7E\x7F\x09\x01\xF7", 1, 8, file);
+                fwrite("\x00\xFF\x01\x04text", 1, 8, file);
+                status = 0;
+            }
+            int pitch = 36 + (int)(nextRandom(&seed) % 60);
+            putVarLen(file, nextRandom(&seed) % 120);
+            if (status != (0x90 | channel))
+                putc(status = 0x90 | channel, file);
+            putc(pitch, file);
+            putc(64 + (int)(nextRandom(&seed) % 64), file);
+            putVarLen(file, 1 + nextRandom(&seed) % 119);
+            putc(pitch, file); // Note-off as a zero-velocity note-on
+            putc(0, file);
+        }
+        fwrite("\x00\xFF\x2F\x00", 1, 4, file);
+        end = ftell(file);
+        fseek(file, lengthOffset, SEEK_SET);
+        putBig(file, (unsigned long)(end - lengthOffset - 4), 4);
+        fseek(file, end, SEEK_SET);
+    }
+
+    bool ok = !ferror(file);
+    end = ftell(file);
+    return fclose(file) == 0 && ok ? end : 0;
+}
+
+static long fileSize(const char *path)
+{
+    FILE *file = fopen(path, "rb");
+    if (!file)
+        return 0;
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fclose(file);
+    return size;
+}
+
+static unsigned long long checksum(const Pattern *pattern)
+{
+    unsigned long long sum = 0;
+    for (int col = 0; col < pattern->cols; col++)
+    {
+        PatternColumnIter it;
+        int row;
+        Instrument instrument;
+        patternColumnBegin(pattern, col, &it);
+        while (patternColumnNext(&it, &row, &instrument))
+            sum += (unsigned long long)col * 131 + (unsigned long long)pattern->rowPitch[row] * 7 + instrument;
+    }
+    return sum;
+}
+
+int main(void)
+{
+    printf("%-9s %9s %10s %9s %12s %9s %12s %10s %9s\n", "pairs/trk", "file MiB", "events", "notes",
+           "import MiB/s", "ms", "export MiB/s", "ms", "reimport");
+
+    int failures = 0;
+    for (size_t f = 0; f < sizeof(PAIRS_PER_TRACK) / sizeof(PAIRS_PER_TRACK[0]); f++)
+    {
+        long bytes = writeSynthetic(BENCH_SOURCE, PAIRS_PER_TRACK[f]);
+        if (bytes == 0)
+        {
+            fprintf(stderr, "Failed to write %s\n", BENCH_SOURCE);
+            return 1;
+        }
+
+        Pattern pattern = {0};
+        Pattern reloaded = {0};
+        float tempo = 0.0f;
+        MidiImportStats stats;
+        double start = platformTimeSeconds();
+        bool ok = midiFileImport(BENCH_SOURCE, MIDI_DEFAULT_STEPS_PER_BEAT, &pattern, &tempo, &stats);
+        double import = platformTimeSeconds() - start;
+
+        start = platformTimeSeconds();
+        ok = ok && midiFileExport(BENCH_EXPORT, &pattern, tempo, MIDI_DEFAULT_STEPS_PER_BEAT);
+        double export = platformTimeSeconds() - start;
+        long exportBytes = fileSize(BENCH_EXPORT);
+
+        MidiImportStats again;
+        float reloadedTempo = 0.0f;
+        ok = ok && midiFileImport(BENCH_EXPORT, MIDI_DEFAULT_STEPS_PER_BEAT, &reloaded, &reloadedTempo, &again) &&
+             checksum(&reloaded) == checksum(&pattern) && again.notes == stats.notes;
+        failures += !ok;
+
+        printf("%-9d %9.1f %10lld %9lld %12.1f %9.2f %12.1f %10.2f %9s\n", PAIRS_PER_TRACK[f],
+               bytes / 1048576.0, (long long)stats.events, (long long)stats.notes,
+               bytes / 1048576.0 / import, import * 1e3, exportBytes / 1048576.0 / export, export * 1e3,
+               ok ? "match" : "MISMATCH");
+        printf("          %d tracks, %d steps x %d rows, %lld merged, %lld drums, %d tempo changes, %.1f KiB resident\n",
+               stats.tracks, pattern.cols, pattern.rows, (long long)stats.merged, (long long)stats.drumNotes,
+               stats.tempoChanges, patternResidentBytes(&pattern) / 1024.0);
+
+        patternFree(&pattern);
+        patternFree(&reloaded);
+    }
+
+    remove(BENCH_SOURCE);
+    remove(BENCH_EXPORT);
+    if (failures)
+        fprintf(stderr, "Export round trip differed on %d files\n", failures);
+    return failures ? 1 : 0;
+}
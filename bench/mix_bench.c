@@ -0,0 +1,165 @@
+// Mix kernel microbenchmark: checks each kernel set against the scalar
+// reference, then reports how many voices one core can mix in real time at
+// 44.1 kHz for several block sizes, played as recorded and resampled a
+// whole tone up.
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "mix_kernels.h"
+#include "platform.h"
+#include "resampler.h"
+
+#define SAMPLE_RATE 44100
+#define SOURCE_FRAMES 22050 // One 0.5 s note, like the files in sounds/
+#define SOURCE_COUNT 32
+#define MEASURE_SECONDS 0.25
+#define PITCHED_RATE 1.122462f // Two semitones up
+#define GUARD RESAMPLER_REACH // Source frames kept clear of the filter's reach
+
+static const int BLOCK_SIZES[] = {64, 128, 256};
+static const char *KERNEL_NAMES[] = {"scalar", "sse2", "avx2"};
+
+static float *sources[SOURCE_COUNT];
+
+static void fillSources(void)
+{
+    unsigned int seed = 12345;
+    for (int s = 0; s < SOURCE_COUNT; s++)
+    {
+        sources[s] = platformAlignedAlloc(64, sizeof(float) * SOURCE_FRAMES);
+        for (int i = 0; i < SOURCE_FRAMES; i++)
+        {
+            seed = seed * 1103515245u + 12345u;
+            sources[s][i] = ((float)(seed >> 8) / (float)(1u << 24)) * 2.4f - 1.2f; // Exercises clipping
+        }
+    }
+}
+
+// Returns false if the kernel set disagrees with the scalar reference
+static bool verify(const MixKernels *kernels, const MixKernels *reference)
+{
+    enum { FRAMES = 1027 }; // Odd length covers the scalar tails
+    float expected[FRAMES] = {0};
+    float actual[FRAMES] = {0};
+    int16_t expected16[FRAMES];
+    int16_t actual16[FRAMES];
+
+    for (int v = 0; v < 8; v++)
+    {
+        reference->mixAdd(expected, sources[v] + v, 0.3f, FRAMES);
+        kernels->mixAdd(actual, sources[v] + v, 0.3f, FRAMES);
+    }
+    float maxError = 0.0f;
+    for (int i = 0; i < FRAMES; i++)
+        maxError = fmaxf(maxError, fabsf(expected[i] - actual[i]));
+
+    reference->toS16(expected16, expected, FRAMES);
+    kernels->toS16(actual16, expected, FRAMES);
+    bool ok = maxError <= 1e-5f && memcmp(expected16, actual16, sizeof(expected16)) == 0;
+
+    // Rates either side of 1, from odd starting positions; 12 takes a
+    // multi-segment filter
+    float maxResampleError = 0.0f;
+    static const float RATES[] = {0.5f, 0.943874f, PITCHED_RATE, 2.7f, 12.0f};
+    for (size_t r = 0; r < sizeof(RATES) / sizeof(RATES[0]); r++)
+    {
+        memset(expected, 0, sizeof(expected));
+        memset(actual, 0, sizeof(actual));
+        uint64_t step = resamplerStep(RATES[r]);
+        uint64_t position = ((uint64_t)r << 32) + 0x9E3779B9u;
+        const ResamplerFilter *filter = resamplerFilter(RATES[r]);
+        resamplerMix(reference->mixResample, expected, sources[r] + GUARD, position, step, filter, 0.7f, FRAMES);
+        resamplerMix(kernels->mixResample, actual, sources[r] + GUARD, position, step, filter, 0.7f, FRAMES);
+        for (int i = 0; i < FRAMES; i++)
+            maxResampleError = fmaxf(maxResampleError, fabsf(expected[i] - actual[i]));
+    }
+    ok = ok && maxResampleError <= 1e-5f;
+    if (!ok)
+        fprintf(stderr, "%s: mismatch against scalar (max mix error %g, resample error %g)\n",
+                kernels->name, maxError, maxResampleError);
+    return ok;
+}
+
+// Seconds of CPU per voice per block, with the int16 conversion amortized
+// over a typical 16-voice block. A rate other than 1 resamples.
+static double secondsPerVoiceBlock(const MixKernels *kernels, int blockFrames, float rate)
+{
+    const ResamplerFilter *filter = resamplerFilter(rate);
+    uint64_t step = resamplerStep(rate);
+    int sourceFrames = (int)ceilf(blockFrames * rate) + 1;
+    float *block = platformAlignedAlloc(64, sizeof(float) * (size_t)blockFrames);
+    int16_t *out = platformAlignedAlloc(64, sizeof(int16_t) * (size_t)blockFrames);
+    long long voiceBlocks = 0;
+    int position = GUARD;
+
+    double start = platformTimeSeconds();
+    double elapsed = 0.0;
+    do
+    {
+        for (int rep = 0; rep < 64; rep++)
+        {
+            memset(block, 0, sizeof(float) * (size_t)blockFrames);
+            for (int v = 0; v < 16; v++)
+            {
+                const float *source = sources[(v + rep) % SOURCE_COUNT] + position;
+                if (rate == 1.0f)
+                    kernels->mixAdd(block, source, 0.25f, blockFrames);
+                else
+                    resamplerMix(kernels->mixResample, block, source, (uint64_t)v << 24, step, filter, 0.25f, blockFrames);
+            }
+            kernels->toS16(out, block, blockFrames);
+            voiceBlocks += 16;
+            position += sourceFrames;
+            if (position + sourceFrames + GUARD > SOURCE_FRAMES)
+                position = GUARD;
+        }
+        elapsed = platformTimeSeconds() - start;
+    } while (elapsed < MEASURE_SECONDS);
+
+    volatile int16_t sink = out[0];
+    (void)sink;
+    platformAlignedFree(block);
+    platformAlignedFree(out);
+    return elapsed / (double)voiceBlocks;
+}
+
+int main(void)
+{
+    fillSources();
+    resamplerInit();
+    const MixKernels *reference = mixKernelsByName("scalar");
+    int failures = 0;
+
+    printf("Selected kernels: %s\n", mixKernels()->name);
+    printf("%-8s %8s %14s %16s %14s %16s\n", "kernels", "block", "ns/voice-block", "voices/core",
+           "resampled ns", "resampled/core");
+    for (size_t k = 0; k < sizeof(KERNEL_NAMES) / sizeof(KERNEL_NAMES[0]); k++)
+    {
+        const MixKernels *kernels = mixKernelsByName(KERNEL_NAMES[k]);
+        if (!kernels)
+        {
+            printf("%-8s %8s\n", KERNEL_NAMES[k], "unsupported");
+            continue;
+        }
+        if (!verify(kernels, reference))
+        {
+            failures++;
+            continue;
+        }
+        for (size_t b = 0; b < sizeof(BLOCK_SIZES) / sizeof(BLOCK_SIZES[0]); b++)
+        {
+            int frames = BLOCK_SIZES[b];
+            double perVoice = secondsPerVoiceBlock(kernels, frames, 1.0f);
+            double perPitched = secondsPerVoiceBlock(kernels, frames, PITCHED_RATE);
+            double blockSeconds = (double)frames / SAMPLE_RATE;
+            printf("%-8s %8d %14.1f %16.0f %14.1f %16.0f\n", kernels->name, frames, perVoice * 1e9,
+                   blockSeconds / perVoice, perPitched * 1e9, blockSeconds / perPitched);
+        }
+    }
+
+    for (int s = 0; s < SOURCE_COUNT; s++)
+        platformAlignedFree(sources[s]);
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,222 @@
+// Pattern layout benchmark: the old row-major NoteCell grid against the
+// sparse column-major bitset store, for step triggering and active-cell
+// walks over long patterns at several densities. Also times project files:
+// a full save, opening it, and saving a one-cell edit.
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "pattern.h"
+#include "platform.h"
+#include "project.h"
+
+#define BENCH_COLS 65536
+#define MEASURE_SECONDS 0.2
+#define BENCH_PROJECT "pattern_bench.lsdproj"
+
+// The layout State used before the bitset store
+typedef struct
+{
+    bool active;
+    Instrument instrument;
+} NoteCell;
+
+static const double DENSITIES[] = {0.02, 0.125, 0.5};
+
+static volatile unsigned long long checksumSink;
+
+static unsigned long long triggerLegacy(const NoteCell *cells, int cols)
+{
+    unsigned long long sum = 0;
+    for (int col = 0; col < cols; col++)
+    {
+        for (int row = 0; row < GRID_ROWS; row++)
+        {
+            const NoteCell *cell = &cells[row * cols + col];
+            if (cell->active)
+                sum += (unsigned long long)(row * NUM_INSTRUMENTS + cell->instrument);
+        }
+    }
+    return sum;
+}
+
+static unsigned long long triggerBitset(const Pattern *pattern)
+{
+    unsigned long long sum = 0;
+    for (int col = 0; col < pattern->cols; col++)
+    {
+        PatternColumnIter it;
+        int row;
+        Instrument instrument;
+        patternColumnBegin(pattern, col, &it);
+        while (patternColumnNext(&it, &row, &instrument))
+            sum += (unsigned long long)(row * NUM_INSTRUMENTS + instrument);
+    }
+    return sum;
+}
+
+// Renderer/exporter style walk: row by row over the whole grid
+static unsigned long long walkLegacy(const NoteCell *cells, int cols)
+{
+    unsigned long long sum = 0;
+    for (int row = 0; row < GRID_ROWS; row++)
+    {
+        for (int col = 0; col < cols; col++)
+        {
+            if (cells[row * cols + col].active)
+                sum += (unsigned long long)(col + row);
+        }
+    }
+    return sum;
+}
+
+static unsigned long long walkBitset(const Pattern *pattern)
+{
+    unsigned long long sum = 0;
+    for (int col = 0; col < pattern->cols; col++)
+    {
+        if (!patternPage(pattern, col))
+        {
+            col += PATTERN_PAGE_COLS - 1 - col % PATTERN_PAGE_COLS;
+            continue;
+        }
+        PatternColumnIter it;
+        int row;
+        Instrument instrument;
+        patternColumnBegin(pattern, col, &it);
+        while (patternColumnNext(&it, &row, &instrument))
+            sum += (unsigned long long)(col + row);
+    }
+    return sum;
+}
+
+typedef unsigned long long (*LegacyFn)(const NoteCell *, int);
+typedef unsigned long long (*BitsetFn)(const Pattern *);
+
+static double timeLegacy(LegacyFn fn, const NoteCell *cells, int cols, unsigned long long *checksum)
+{
+    int runs = 0;
+    double start = platformTimeSeconds();
+    double elapsed;
+    do
+    {
+        *checksum = fn(cells, cols);
+        runs++;
+        elapsed = platformTimeSeconds() - start;
+    } while (elapsed < MEASURE_SECONDS);
+    return elapsed / runs;
+}
+
+static double timeBitset(BitsetFn fn, const Pattern *pattern, unsigned long long *checksum)
+{
+    int runs = 0;
+    double start = platformTimeSeconds();
+    double elapsed;
+    do
+    {
+        *checksum = fn(pattern);
+        runs++;
+        elapsed = platformTimeSeconds() - start;
+    } while (elapsed < MEASURE_SECONDS);
+    return elapsed / runs;
+}
+
+// Round-trips the pattern through a project file; false if what comes back
+// differs
+static bool benchProject(const Pattern *pattern, double density)
+{
+    Project project;
+    Pattern loaded = {0};
+    Pattern reloaded = {0};
+    float tempo = 120.0f;
+    Instrument instrument = PIANO;
+    remove(BENCH_PROJECT);
+
+    bool ok = projectOpen(&project, BENCH_PROJECT, &loaded, &tempo, &instrument);
+    double start = platformTimeSeconds();
+    ok = ok && projectSave(&project, pattern, tempo, instrument);
+    double fullSave = platformTimeSeconds() - start;
+    uint64_t fullBytes = project.savedBytes;
+    projectClose(&project);
+
+    start = platformTimeSeconds();
+    ok = ok && projectOpen(&project, BENCH_PROJECT, &loaded, &tempo, &instrument);
+    double open = platformTimeSeconds() - start;
+    ok = ok && triggerBitset(&loaded) == triggerBitset(pattern);
+
+    int col = loaded.cols / 2;
+    ok = ok && patternSet(&loaded, 0, col, !patternIsActive(&loaded, 0, col), BELL);
+    start = platformTimeSeconds();
+    ok = ok && projectSave(&project, &loaded, tempo, instrument);
+    double editSave = platformTimeSeconds() - start;
+    uint64_t editBytes = project.savedBytes;
+    projectClose(&project);
+
+    ok = ok && projectOpen(&project, BENCH_PROJECT, &reloaded, &tempo, &instrument) &&
+         triggerBitset(&reloaded) == triggerBitset(&loaded);
+    projectClose(&project);
+    printf("%-8.3f %-8s full save %.2f ms (%.1f KiB), open %.2f ms, one-cell save %.3f ms (%.1f KiB)\n", density,
+           "project", fullSave * 1e3, fullBytes / 1024.0, open * 1e3, editSave * 1e3, editBytes / 1024.0);
+
+    patternFree(&loaded);
+    patternFree(&reloaded);
+    remove(BENCH_PROJECT);
+    return ok;
+}
+
+int main(void)
+{
+    NoteCell *cells = malloc(sizeof(NoteCell) * GRID_ROWS * BENCH_COLS);
+    Pattern pattern;
+    if (!cells || !patternInitDefault(&pattern, BENCH_COLS))
+    {
+        fprintf(stderr, "Out of memory\n");
+        return 1;
+    }
+
+    printf("%d rows x %d steps\n", GRID_ROWS, BENCH_COLS);
+    printf("%-8s %-8s %14s %14s %8s %12s\n", "density", "task", "legacy ns/step", "bitset ns/step", "speedup", "bitset KiB");
+
+    int failures = 0;
+    for (size_t d = 0; d < sizeof(DENSITIES) / sizeof(DENSITIES[0]); d++)
+    {
+        unsigned int seed = 42;
+        patternClear(&pattern);
+        for (int row = 0; row < GRID_ROWS; row++)
+        {
+            for (int col = 0; col < BENCH_COLS; col++)
+            {
+                seed = seed * 1103515245u + 12345u;
+                bool active = (seed >> 8) % 10000 < (unsigned int)(DENSITIES[d] * 10000.0);
+                Instrument instrument = (Instrument)((seed >> 20) % NUM_INSTRUMENTS);
+                cells[row * BENCH_COLS + col].active = active;
+                cells[row * BENCH_COLS + col].instrument = instrument;
+                patternSet(&pattern, row, col, active, instrument);
+            }
+        }
+
+        unsigned long long legacySum, bitsetSum;
+        double legacy = timeLegacy(triggerLegacy, cells, BENCH_COLS, &legacySum);
+        double bitset = timeBitset(triggerBitset, &pattern, &bitsetSum);
+        failures += legacySum != bitsetSum;
+        checksumSink = legacySum + bitsetSum;
+        printf("%-8.3f %-8s %14.2f %14.2f %7.1fx %12.1f\n", DENSITIES[d], "trigger",
+               legacy / BENCH_COLS * 1e9, bitset / BENCH_COLS * 1e9, legacy / bitset,
+               patternResidentBytes(&pattern) / 1024.0);
+
+        legacy = timeLegacy(walkLegacy, cells, BENCH_COLS, &legacySum);
+        bitset = timeBitset(walkBitset, &pattern, &bitsetSum);
+        failures += legacySum != bitsetSum;
+        checksumSink = legacySum + bitsetSum;
+        printf("%-8.3f %-8s %14.2f %14.2f %7.1fx %12.1f\n", DENSITIES[d], "walk",
+               legacy / BENCH_COLS * 1e9, bitset / BENCH_COLS * 1e9, legacy / bitset,
+               patternResidentBytes(&pattern) / 1024.0);
+
+        failures += !benchProject(&pattern, DENSITIES[d]);
+    }
+
+    if (failures)
+        fprintf(stderr, "Layouts disagree on %d workloads\n", failures);
+    patternFree(&pattern);
+    free(cells);
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,701 @@
+// Sequencer performance suite: sample loading, step triggering, mixing per
+// voice count, disk streaming, offline render speed and grid-draw CPU time.
+// Inputs are
+// fixed (generated patterns use a fixed seed) and every figure is the
+// median of several runs; results go out as JSON so runs can be diffed
+// between releases. Run from the repository root: it reads sounds/,
+// shaders/ and patterns/demo.pattern, and writes a scratch sample under
+// STREAM_DIR.
+#include <GLFW/glfw3.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "audio_engine.h"
+#include "gl_loader.h"
+#include "grid_renderer.h"
+#include "mix_kernels.h"
+#include "pattern.h"
+#include "platform.h"
+#include "sample_bank.h"
+#include "sample_streamer.h"
+#include "sequencer.h"
+#include "wav.h"
+
+#define BENCH_SCHEMA 1
+#define MAX_REPEATS 9
+#define BENCH_STEPS 4096
+#define BENCH_SEED 12345u
+#define DRAW_WIDTH 1160
+#define DRAW_HEIGHT 840
+#define DRAW_ROWS 24
+#define DRAW_COLS 32
+#define STREAM_DIR "sequencer_bench_stream"
+#define STREAM_SAMPLE_SECONDS 10
+
+static int repeats = 5;
+static double minSeconds = 0.1; // Per timed run
+static int drawFrames = 240;
+
+static const int VOICE_COUNTS[] = {1, 4, 16, 32, 64};
+#define VOICE_COUNT_COUNT (int)(sizeof(VOICE_COUNTS) / sizeof(VOICE_COUNTS[0]))
+static const int STREAM_VOICE_COUNTS[] = {1, 4, 16, SAMPLE_STREAM_SLOTS};
+#define STREAM_VOICE_COUNT_COUNT (int)(sizeof(STREAM_VOICE_COUNTS) / sizeof(STREAM_VOICE_COUNTS[0]))
+
+// Minimal JSON emitter; keys and strings are plain ASCII
+typedef struct
+{
+    FILE *file;
+    int depth;
+    bool needComma[8];
+} Json;
+
+static void jsonKey(Json *j, const char *key)
+{
+    if (j->needComma[j->depth])
+        fputc(',', j->file);
+    if (j->depth > 0)
+        fprintf(j->file, "\n%*s", j->depth * 2, "");
+    if (key)
+        fprintf(j->file, "\"%s\": ", key);
+    j->needComma[j->depth] = true;
+}
+
+static void jsonOpen(Json *j, const char *key, char bracket)
+{
+    jsonKey(j, key);
+    fputc(bracket, j->file);
+    j->needComma[++j->depth] = false;
+}
+
+static void jsonClose(Json *j, char bracket)
+{
+    j->depth--;
+    fprintf(j->file, "\n%*s%c", j->depth * 2, "", bracket);
+}
+
+static void jsonNumber(Json *j, const char *key, double value)
+{
+    jsonKey(j, key);
+    fprintf(j->file, "%.6g", value);
+}
+
+static void jsonString(Json *j, const char *key, const char *value)
+{
+    jsonKey(j, key);
+    fprintf(j->file, "\"%s\"", value);
+}
+
+static double median(const double *values, int count)
+{
+    double sorted[MAX_REPEATS];
+    memcpy(sorted, values, sizeof(double) * (size_t)count);
+    for (int i = 1; i < count; i++)
+    {
+        double v = sorted[i];
+        int k = i;
+        for (; k > 0 && sorted[k - 1] > v; k--)
+            sorted[k] = sorted[k - 1];
+        sorted[k] = v;
+    }
+    return count % 2 ? sorted[count / 2] : 0.5 * (sorted[count / 2 - 1] + sorted[count / 2]);
+}
+
+static uint32_t nextRandom(uint32_t *state)
+{
+    *state = *state * 1664525u + 1013904223u;
+    return *state >> 8;
+}
+
+// A pattern plus how its notes are voiced, as main.c's playColumn does it
+typedef struct
+{
+    const char *name;
+    Pattern pattern;
+    float tempo;
+    bool useSamples;
+    const SampleRef *pitchSamples[PATTERN_MAX_ROWS]; // NULL: silent in sample mode
+} BenchSong;
+
+static void benchStep(void *user, AudioEngine *engine, int column, int offset)
+{
+    const BenchSong *song = user;
+    PatternColumnIter it;
+    int row;
+    Instrument instrument;
+    patternColumnBegin(&song->pattern, column, &it);
+    while (patternColumnNext(&it, &row, &instrument))
+    {
+        int pitch = song->pattern.rowPitch[row];
+        if (!song->useSamples)
+        {
+            audioEngineStartSynth(engine, &SYNTH_PATCHES[instrument], noteFrequency(pitch), 1.0f, offset);
+            continue;
+        }
+        const SampleRef *sample = song->pitchSamples[pitch];
+        if (sample && sample->samples)
+            audioEngineStartVoice(engine, sample, 1.0f, 1.0f, offset);
+    }
+}
+
+// Every cell of a full-range pattern is set with probability 1 / oneIn
+static bool generateSong(BenchSong *song, const char *name, int oneIn)
+{
+    memset(song, 0, sizeof(*song));
+    song->name = name;
+    song->tempo = 120.0f;
+    if (!patternInitChromatic(&song->pattern, 0, PATTERN_MAX_ROWS - 1, BENCH_STEPS))
+        return false;
+    uint32_t seed = BENCH_SEED;
+    for (int col = 0; col < BENCH_STEPS; col++)
+    {
+        for (int row = 0; row < PATTERN_MAX_ROWS; row++)
+        {
+            if (nextRandom(&seed) % (uint32_t)oneIn == 0 &&
+                !patternSet(&song->pattern, row, col, true, (Instrument)(nextRandom(&seed) % NUM_INSTRUMENTS)))
+                return false;
+        }
+    }
+    return true;
+}
+
+static void useSamples(BenchSong *song, const SampleRef *sample)
+{
+    song->useSamples = true;
+    for (int pitch = 0; pitch < PATTERN_MAX_ROWS; pitch++)
+        song->pitchSamples[pitch] = sample;
+}
+
+static void useSampleBank(BenchSong *song, const SampleBank *bank)
+{
+    // Piano samples at the pitches sounds/ has, like --samples in the app
+    song->useSamples = true;
+    for (int i = 0; i < SAMPLE_NOTE_COUNT; i++)
+        song->pitchSamples[noteParse(SAMPLE_NOTE_NAMES[i])] = sampleBankGet(bank, PIANO, i);
+}
+
+static void benchSampleLoading(Json *j, SampleBank *bank)
+{
+    double times[MAX_REPEATS];
+    jsonOpen(j, "sample_loading", '{');
+    for (int r = 0; r < repeats; r++)
+    {
+        double start = platformTimeSeconds();
+        bool ok = sampleBankLoad(bank, "sounds", INSTRUMENT_DIRS, NUM_INSTRUMENTS, SAMPLE_NOTE_NAMES, SAMPLE_NOTE_COUNT, NULL, 0);
+        times[r] = platformTimeSeconds() - start;
+        if (!ok)
+        {
+            jsonString(j, "skipped", "no samples under sounds/");
+            jsonClose(j, '}');
+            return;
+        }
+        // Keep the last load for the render benchmark
+        if (r + 1 < repeats)
+            sampleBankFree(bank);
+    }
+    jsonNumber(j, "samples", bank->loadedCount);
+    jsonNumber(j, "resident_kib", bank->residentBytes / 1024.0);
+    jsonNumber(j, "first_ms", times[0] * 1e3);
+    jsonNumber(j, "median_ms", median(times, repeats) * 1e3);
+    jsonClose(j, '}');
+    fprintf(stderr, "sample loading: %.2f ms\n", median(times, repeats) * 1e3);
+}
+
+static void benchTriggering(Json *j, BenchSong *song, const char *voicing)
+{
+    AudioEngine *engine = malloc(sizeof(AudioEngine));
+    double times[MAX_REPEATS];
+    int64_t notes = 0;
+    int64_t steps = 0;
+    for (int r = 0; r < repeats; r++)
+    {
+        audioEngineInit(engine);
+        notes = 0;
+        steps = 0;
+        double start = platformTimeSeconds();
+        do
+        {
+            for (int col = 0; col < song->pattern.cols; col++)
+                benchStep(song, engine, col, 0);
+            steps += song->pattern.cols;
+            notes += song->pattern.noteCount;
+        } while (platformTimeSeconds() - start < minSeconds);
+        times[r] = (platformTimeSeconds() - start) / (double)steps;
+    }
+    free(engine);
+
+    double perStep = median(times, repeats);
+    double notesPerStep = (double)notes / (double)steps;
+    jsonOpen(j, NULL, '{');
+    jsonString(j, "pattern", song->name);
+    jsonString(j, "voices", voicing);
+    jsonNumber(j, "notes_per_step", notesPerStep);
+    jsonNumber(j, "ns_per_step", perStep * 1e9);
+    jsonNumber(j, "ns_per_note", notesPerStep > 0.0 ? perStep / notesPerStep * 1e9 : 0.0);
+    jsonClose(j, '}');
+    fprintf(stderr, "triggering %s/%s: %.0f ns/step\n", song->name, voicing, perStep * 1e9);
+}
+
+// Keeps `voices` notes sounding and times full blocks through the mixer
+static void benchMixing(Json *j, const char *voicing, const SynthPatch *patch, const SampleRef *sample, int voices)
+{
+    AudioEngine *engine = malloc(sizeof(AudioEngine));
+    float *block = platformAlignedAlloc(64, sizeof(float) * AUDIO_BLOCK_FRAMES);
+    double times[MAX_REPEATS];
+    int note = 0;
+    for (int r = 0; r < repeats; r++)
+    {
+        audioEngineInit(engine);
+        long long blocks = 0;
+        double start = platformTimeSeconds();
+        do
+        {
+            for (int rep = 0; rep < 32; rep++)
+            {
+                while (patch ? engine->synth.pool.playing < voices : engine->voicePool.playing < voices)
+                {
+                    if (patch)
+                        audioEngineStartSynth(engine, patch, 110.0f * powf(2.0f, (float)(note++ % 48) / 12.0f), 0.1f, 0);
+                    else
+                        audioEngineStartVoice(engine, sample, 1.0f, 0.1f, 0);
+                }
+                audioEngineRender(engine, block, AUDIO_BLOCK_FRAMES);
+                blocks++;
+            }
+        } while (platformTimeSeconds() - start < minSeconds);
+        times[r] = (platformTimeSeconds() - start) / (double)blocks;
+    }
+    platformAlignedFree(block);
+    free(engine);
+
+    double perBlock = median(times, repeats);
+    double blockSeconds = (double)AUDIO_BLOCK_FRAMES / AUDIO_SAMPLE_RATE;
+    jsonOpen(j, NULL, '{');
+    jsonString(j, "voices", voicing);
+    jsonNumber(j, "count", voices);
+    jsonNumber(j, "ns_per_block", perBlock * 1e9);
+    jsonNumber(j, "ns_per_voice_block", perBlock / voices * 1e9);
+    jsonNumber(j, "block_load", perBlock / blockSeconds);
+    jsonNumber(j, "voices_per_core", blockSeconds / (perBlock / voices));
+    jsonClose(j, '}');
+    fprintf(stderr, "mixing %s x%d: %.0f ns/block\n", voicing, voices, perBlock * 1e9);
+}
+
+// Keeps `voices` notes of a long sample sounding, started a few blocks
+// apart so they sit at different chunks. With a streamer the prefetch pass
+// runs inline between blocks, timed apart from the mixing, so it never
+// falls behind and the mix time is the audio thread's share alone.
+static void streamRun(const SampleRef *sample, SampleStreamer *streamer, int voices,
+                      double *mixPerBlock, double *prefetchPerBlock)
+{
+    AudioEngine *engine = malloc(sizeof(AudioEngine));
+    float *block = platformAlignedAlloc(64, sizeof(float) * AUDIO_BLOCK_FRAMES);
+    double mix[MAX_REPEATS];
+    double prefetch[MAX_REPEATS];
+    for (int r = 0; r < repeats; r++)
+    {
+        audioEngineInit(engine);
+        audioEngineSetStreamer(engine, streamer);
+        // Until every voice is past its resident head
+        for (int b = 0; b < voices * 8 + SAMPLE_BANK_HEAD_FRAMES / AUDIO_BLOCK_FRAMES; b++)
+        {
+            if (b % 8 == 0 && engine->voicePool.playing < voices)
+                audioEngineStartVoice(engine, sample, 1.0f, 0.1f, 0);
+            if (streamer)
+                sampleStreamerPrefetch(streamer);
+            audioEngineRender(engine, block, AUDIO_BLOCK_FRAMES);
+        }
+
+        long long blocks = 0;
+        double mixTotal = 0.0;
+        double prefetchTotal = 0.0;
+        double start = platformTimeSeconds();
+        do
+        {
+            while (engine->voicePool.playing < voices)
+                audioEngineStartVoice(engine, sample, 1.0f, 0.1f, 0);
+            double t0 = platformTimeSeconds();
+            if (streamer)
+                sampleStreamerPrefetch(streamer);
+            double t1 = platformTimeSeconds();
+            audioEngineRender(engine, block, AUDIO_BLOCK_FRAMES);
+            mixTotal += platformTimeSeconds() - t1;
+            prefetchTotal += t1 - t0;
+            blocks++;
+        } while (platformTimeSeconds() - start < minSeconds);
+        mix[r] = mixTotal / (double)blocks;
+        prefetch[r] = prefetchTotal / (double)blocks;
+    }
+    platformAlignedFree(block);
+    free(engine);
+    *mixPerBlock = median(mix, repeats);
+    *prefetchPerBlock = median(prefetch, repeats);
+}
+
+// A long noise one-shot written to disk, then mixed fully resident and
+// streamed past its head
+static void benchStreaming(Json *j)
+{
+    jsonOpen(j, "streaming", '{');
+    static const char *const DIRS[] = {"piano"};
+    static const char *const NAMES[] = {"C4"};
+    int32_t frames = STREAM_SAMPLE_SECONDS * AUDIO_SAMPLE_RATE;
+    int16_t *pcm = malloc(sizeof(int16_t) * (size_t)frames);
+    bool written = false;
+    if (pcm && platformMakeDirectory(STREAM_DIR) && platformMakeDirectory(STREAM_DIR "/piano"))
+    {
+        uint32_t seed = BENCH_SEED;
+        for (int32_t i = 0; i < frames; i++)
+            pcm[i] = (int16_t)((int)(nextRandom(&seed) % 20001) - 10000);
+        written = wavWriteFile(STREAM_DIR "/piano/C4.wav", pcm, frames, AUDIO_SAMPLE_RATE);
+    }
+    free(pcm);
+
+    SampleBank resident = {0};
+    SampleBank streamed = {0};
+    SampleStreamer *streamer = malloc(sizeof(SampleStreamer));
+    if (!written || !streamer ||
+        !sampleBankLoad(&resident, STREAM_DIR, DIRS, 1, NAMES, 1, NULL, 0) ||
+        !sampleBankLoad(&streamed, STREAM_DIR, DIRS, 1, NAMES, 1, NULL, AUDIO_SAMPLE_RATE) ||
+        streamed.streamCount == 0 || !sampleStreamerInit(streamer, &streamed))
+    {
+        jsonString(j, "skipped", "could not write, map or load " STREAM_DIR "/piano/C4.wav");
+        jsonClose(j, '}');
+        sampleBankFree(&resident);
+        sampleBankFree(&streamed);
+        free(streamer);
+        remove(STREAM_DIR "/piano/C4.wav");
+        return;
+    }
+
+    jsonNumber(j, "sample_seconds", STREAM_SAMPLE_SECONDS);
+    jsonNumber(j, "resident_kib", resident.residentBytes / 1024.0);
+    jsonNumber(j, "streamed_resident_kib", streamed.residentBytes / 1024.0);
+    jsonOpen(j, "runs", '[');
+    for (int v = 0; v < STREAM_VOICE_COUNT_COUNT; v++)
+    {
+        int voices = STREAM_VOICE_COUNTS[v];
+        double residentMix, streamedMix, prefetch, unused;
+        streamRun(sampleBankGet(&resident, 0, 0), NULL, voices, &residentMix, &unused);
+        SampleStreamStats before = streamer->stats;
+        streamRun(sampleBankGet(&streamed, 0, 0), streamer, voices, &streamedMix, &prefetch);
+
+        jsonOpen(j, NULL, '{');
+        jsonNumber(j, "voices", voices);
+        jsonNumber(j, "resident_ns_per_block", residentMix * 1e9);
+        jsonNumber(j, "streamed_ns_per_block", streamedMix * 1e9);
+        jsonNumber(j, "prefetch_ns_per_block", prefetch * 1e9);
+        jsonNumber(j, "cache_hits", streamer->stats.cacheHits - before.cacheHits);
+        jsonNumber(j, "cache_misses", streamer->stats.cacheMisses - before.cacheMisses);
+        jsonNumber(j, "underruns", streamer->stats.underruns - before.underruns);
+        jsonClose(j, '}');
+        fprintf(stderr, "streaming x%d: %.0f ns/block mixing (%.0f resident), %.0f ns/block prefetch\n",
+                voices, streamedMix * 1e9, residentMix * 1e9, prefetch * 1e9);
+    }
+    jsonClose(j, ']');
+    jsonClose(j, '}');
+
+    sampleStreamerFree(streamer);
+    free(streamer);
+    sampleBankFree(&resident);
+    sampleBankFree(&streamed);
+    remove(STREAM_DIR "/piano/C4.wav");
+    remove(STREAM_DIR "/piano");
+    remove(STREAM_DIR);
+}
+
+// The --render loop of the app, minus the file: every step, then the tail
+static void benchRender(Json *j, BenchSong *song, const char *voicing)
+{
+    AudioEngine *engine = malloc(sizeof(AudioEngine));
+    Sequencer sequencer;
+    float *block = platformAlignedAlloc(64, sizeof(float) * AUDIO_BLOCK_FRAMES);
+    int64_t stepFrames = (int64_t)llround(AUDIO_SAMPLE_RATE * 60.0 / song->tempo);
+    int64_t tailFrames = 0;
+    for (int i = 0; song->useSamples && i < PATTERN_MAX_ROWS; i++)
+    {
+        if (song->pitchSamples[i] && song->pitchSamples[i]->frames > tailFrames)
+            tailFrames = song->pitchSamples[i]->frames;
+    }
+    for (int i = 0; !song->useSamples && i < SYNTH_PATCH_COUNT; i++)
+    {
+        int64_t frames = (int64_t)ceil(synthPatchLength(&SYNTH_PATCHES[i]) * AUDIO_SAMPLE_RATE);
+        if (frames > tailFrames)
+            tailFrames = frames;
+    }
+    int64_t totalFrames = song->pattern.cols * stepFrames + tailFrames;
+
+    double times[MAX_REPEATS];
+    for (int r = 0; r < repeats; r++)
+    {
+        audioEngineInit(engine);
+        sequencerInit(&sequencer, song->pattern.cols, song->tempo, benchStep, song);
+        audioEngineSetBlockCallback(engine, sequencerProcessBlock, &sequencer);
+        sequencerSetPlaying(&sequencer, true);
+        double start = platformTimeSeconds();
+        for (int64_t done = 0; done < totalFrames; done += AUDIO_BLOCK_FRAMES)
+        {
+            int frames = totalFrames - done < AUDIO_BLOCK_FRAMES ? (int)(totalFrames - done) : AUDIO_BLOCK_FRAMES;
+            if (done >= totalFrames - tailFrames)
+                sequencerSetPlaying(&sequencer, false);
+            audioEngineRender(engine, block, frames);
+        }
+        times[r] = platformTimeSeconds() - start;
+    }
+    platformAlignedFree(block);
+    free(engine);
+
+    double seconds = (double)totalFrames / AUDIO_SAMPLE_RATE;
+    double elapsed = median(times, repeats);
+    jsonOpen(j, NULL, '{');
+    jsonString(j, "pattern", song->name);
+    jsonString(j, "voices", voicing);
+    jsonNumber(j, "audio_seconds", seconds);
+    jsonNumber(j, "median_ms", elapsed * 1e3);
+    jsonNumber(j, "x_realtime", seconds / elapsed);
+    jsonClose(j, '}');
+    fprintf(stderr, "render %s/%s: %.0fx real time\n", song->name, voicing, seconds / elapsed);
+}
+
+static void gridColor(int pitch, Instrument instrument, float color[3])
+{
+    color[0] = (float)(pitch % 12) / 12.0f;
+    color[1] = instrument == SYNTH ? 1.0f : 0.3f;
+    color[2] = instrument == BELL ? 1.0f : 0.3f;
+}
+
+typedef enum
+{
+    DRAW_CACHED,   // Nothing changed since the last frame
+    DRAW_PLAYHEAD, // The playhead moved a step
+    DRAW_EDIT,     // A visible note was toggled
+    DRAW_SCROLL,   // The view moved a step
+    DRAW_CASE_COUNT
+} DrawCase;
+
+static const char *const DRAW_CASE_NAMES[DRAW_CASE_COUNT] = {"cached", "playhead", "edit", "scroll"};
+
+// CPU time spent inside gridRendererDraw; the GPU is drained between frames
+// so queued work never stalls the timed call
+static void benchGridCase(Json *j, GridRenderer *renderer, Pattern *pattern, DrawCase drawCase, int fbWidth, int fbHeight)
+{
+    GridView view = {40, 0, DRAW_ROWS, DRAW_COLS};
+    double cpu[MAX_REPEATS];
+    double wall[MAX_REPEATS];
+    for (int r = 0; r < repeats; r++)
+    {
+        double cpuTotal = 0.0;
+        double wallTotal = 0.0;
+        view.firstCol = 0;
+        for (int frame = 0; frame < drawFrames; frame++)
+        {
+            int playColumn = drawCase == DRAW_PLAYHEAD ? frame % view.cols : 3;
+            if (drawCase == DRAW_EDIT)
+            {
+                int row = view.firstRow + frame % view.rows;
+                patternSet(pattern, row, 5, !patternIsActive(pattern, row, 5), PIANO);
+            }
+            else if (drawCase == DRAW_SCROLL)
+            {
+                view.firstCol = frame % (pattern->cols - view.cols);
+            }
+
+            glClear(GL_COLOR_BUFFER_BIT);
+            double cpuStart = platformThreadCpuSeconds();
+            double wallStart = platformTimeSeconds();
+            gridRendererDraw(renderer, pattern, view, playColumn, gridColor, fbWidth, fbHeight, (float)frame / 60.0f);
+            wallTotal += platformTimeSeconds() - wallStart;
+            cpuTotal += platformThreadCpuSeconds() - cpuStart;
+            glFinish();
+        }
+        cpu[r] = cpuTotal / drawFrames;
+        wall[r] = wallTotal / drawFrames;
+    }
+
+    jsonOpen(j, NULL, '{');
+    jsonString(j, "case", DRAW_CASE_NAMES[drawCase]);
+    jsonNumber(j, "cells", renderer->cellCount);
+    jsonNumber(j, "cpu_us_per_frame", median(cpu, repeats) * 1e6);
+    jsonNumber(j, "wall_us_per_frame", median(wall, repeats) * 1e6);
+    jsonClose(j, '}');
+    fprintf(stderr, "grid draw %s: %.1f us CPU\n", DRAW_CASE_NAMES[drawCase], median(cpu, repeats) * 1e6);
+}
+
+static void benchGridDraw(Json *j, Pattern *pattern)
+{
+    jsonOpen(j, "grid_draw", '{');
+    if (!glfwInit())
+    {
+        jsonString(j, "skipped", "GLFW could not initialize");
+        jsonClose(j, '}');
+        return;
+    }
+    // Offscreen: a hidden window only provides the context
+    glLoaderContextHints();
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+    GLFWwindow *window = glfwCreateWindow(DRAW_WIDTH, DRAW_HEIGHT, "sequencer_bench", NULL, NULL);
+    if (!window)
+    {
+        jsonString(j, "skipped", "no OpenGL context");
+        jsonClose(j, '}');
+        glfwTerminate();
+        return;
+    }
+    glfwMakeContextCurrent(window);
+    glfwSwapInterval(0);
+
+    GridRenderer renderer;
+    if (!glLoaderInit() || !gridRendererInit(&renderer, 100.0f, 80.0f, 30.0f))
+    {
+        jsonString(j, "skipped", "grid renderer needs OpenGL 3.3 and shaders/");
+        jsonClose(j, '}');
+        glfwDestroyWindow(window);
+        glfwTerminate();
+        return;
+    }
+    int fbWidth, fbHeight;
+    glfwGetFramebufferSize(window, &fbWidth, &fbHeight);
+    glViewport(0, 0, fbWidth, fbHeight);
+
+    jsonString(j, "renderer", (const char *)glGetString(GL_RENDERER));
+    jsonNumber(j, "frames", drawFrames);
+    jsonOpen(j, "cases", '[');
+    for (int c = 0; c < DRAW_CASE_COUNT; c++)
+        benchGridCase(j, &renderer, pattern, (DrawCase)c, fbWidth, fbHeight);
+    jsonClose(j, ']');
+    jsonClose(j, '}');
+
+    gridRendererShutdown(&renderer);
+    glfwDestroyWindow(window);
+    glfwTerminate();
+}
+
+int main(int argc, char *argv[])
+{
+    const char *outPath = NULL;
+    bool drawGrid = true;
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--out") == 0 && i + 1 < argc)
+        {
+            outPath = argv[++i];
+        }
+        else if (strcmp(argv[i], "--quick") == 0)
+        {
+            repeats = 3;
+            minSeconds = 0.02;
+            drawFrames = 60;
+        }
+        else if (strcmp(argv[i], "--no-gl") == 0)
+        {
+            drawGrid = false;
+        }
+        else
+        {
+            fprintf(stderr, "Usage: %s [--quick] [--no-gl] [--out results.json]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    Json json = {stdout, 0, {false}};
+    if (outPath && !(json.file = fopen(outPath, "w")))
+    {
+        fprintf(stderr, "Failed to open %s for writing\n", outPath);
+        return 1;
+    }
+
+    static BenchSong dense, sparse, demo;
+    if (!generateSong(&dense, "dense", 4) || !generateSong(&sparse, "sparse", 512))
+    {
+        fprintf(stderr, "Failed to allocate the benchmark patterns\n");
+        return 1;
+    }
+
+    // One second of fixed noise stands in for a sample, so the triggering
+    // and mixing figures don't depend on sounds/
+    float *noise = platformAlignedAlloc(SAMPLE_BANK_ALIGNMENT, sizeof(float) * (AUDIO_SAMPLE_RATE + 64));
+    uint32_t seed = BENCH_SEED;
+    for (int i = 0; i < AUDIO_SAMPLE_RATE + 64; i++)
+        noise[i] = i < AUDIO_SAMPLE_RATE ? (float)(nextRandom(&seed) % 2001) / 1000.0f - 1.0f : 0.0f;
+    SampleRef noiseSample = {noise, AUDIO_SAMPLE_RATE, AUDIO_SAMPLE_RATE, -1};
+
+    char date[32];
+    time_t now = time(NULL);
+    strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%SZ", gmtime(&now));
+
+    Json *j = &json;
+    jsonOpen(j, NULL, '{');
+    jsonString(j, "benchmark", "sequencer_bench");
+    jsonNumber(j, "schema", BENCH_SCHEMA);
+    jsonString(j, "date", date);
+    jsonString(j, "mix_kernels", mixKernels()->name);
+    jsonNumber(j, "sample_rate", AUDIO_SAMPLE_RATE);
+    jsonNumber(j, "block_frames", AUDIO_BLOCK_FRAMES);
+    jsonNumber(j, "repeats", repeats);
+
+    SampleBank bank = {0};
+    benchSampleLoading(j, &bank);
+
+    jsonOpen(j, "step_triggering", '[');
+    BenchSong *generated[] = {&dense, &sparse};
+    for (int s = 0; s < 2; s++)
+    {
+        benchTriggering(j, generated[s], "synth");
+        useSamples(generated[s], &noiseSample);
+        benchTriggering(j, generated[s], "samples");
+        generated[s]->useSamples = false;
+    }
+    jsonClose(j, ']');
+
+    jsonOpen(j, "mixing", '[');
+    for (int v = 0; v < VOICE_COUNT_COUNT; v++)
+        benchMixing(j, "samples", NULL, &noiseSample, VOICE_COUNTS[v]);
+    for (int p = 0; p < SYNTH_PATCH_COUNT; p++)
+    {
+        for (int v = 0; v < VOICE_COUNT_COUNT; v++)
+            benchMixing(j, SYNTH_PATCHES[p].name, &SYNTH_PATCHES[p], NULL, VOICE_COUNTS[v]);
+    }
+    jsonClose(j, ']');
+
+    benchStreaming(j);
+
+    jsonOpen(j, "offline_render", '[');
+    demo.name = "demo";
+    if (patternInitDefault(&demo.pattern, GRID_COLS) && patternLoadText("patterns/demo.pattern", &demo.pattern, &demo.tempo))
+    {
+        benchRender(j, &demo, "synth");
+        if (bank.slots)
+        {
+            useSampleBank(&demo, &bank);
+            benchRender(j, &demo, "samples");
+        }
+    }
+    else
+    {
+        fprintf(stderr, "patterns/demo.pattern not found, skipping its render\n");
+    }
+    benchRender(j, &sparse, "synth");
+    jsonClose(j, ']');
+
+    if (drawGrid)
+        benchGridDraw(j, &dense.pattern);
+    else
+    {
+        jsonOpen(j, "grid_draw", '{');
+        jsonString(j, "skipped", "--no-gl");
+        jsonClose(j, '}');
+    }
+
+    jsonClose(j, '}');
+    fputc('\n', j->file);
+    bool ok = !outPath || fclose(j->file) == 0;
+
+    sampleBankFree(&bank);
+    platformAlignedFree(noise);
+    patternFree(&demo.pattern);
+    patternFree(&dense.pattern);
+    patternFree(&sparse.pattern);
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,108 @@
+// Synth benchmark: checks the table oscillators against libm, then reports
+// how many voices of each patch one core can render in real time at
+// 44.1 kHz for several block sizes.
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "platform.h"
+#include "synth.h"
+
+#define SAMPLE_RATE 44100
+#define BENCH_VOICES 32
+#define MEASURE_SECONDS 0.25
+
+static const int BLOCK_SIZES[] = {64, 128, 256};
+
+// Returns false if a sustained note strays from the exact partial sum
+static bool verify(const SynthPatch *patch)
+{
+    enum { FRAMES = 4096 };
+    static float out[FRAMES];
+    const float frequency = 440.0f;
+    Synth synth;
+    synthInit(&synth, SAMPLE_RATE);
+    synthNoteOn(&synth, patch, frequency, 1.0f, 0);
+    memset(out, 0, sizeof(out));
+    synthRender(&synth, out, FRAMES);
+
+    // Compare during the sustain stage, where the envelope is flat
+    int first = (int)ceil((patch->attack + patch->decay) * SAMPLE_RATE) + 1;
+    float total = 0.0f;
+    for (int p = 0; p < patch->partialCount; p++)
+        total += patch->partials[p].amplitude;
+    double maxError = 0.0;
+    for (int i = first; i < FRAMES; i++)
+    {
+        double expected = 0.0;
+        for (int p = 0; p < patch->partialCount; p++)
+        {
+            double cycles = (double)(uint32_t)((double)frequency * patch->partials[p].ratio / SAMPLE_RATE * 4294967296.0) / 4294967296.0;
+            expected += patch->partials[p].amplitude / total * sin(2.0 * 3.14159265358979323846 * cycles * i);
+        }
+        expected *= patch->sustain;
+        maxError = fmax(maxError, fabs(expected - out[i]));
+    }
+    bool ok = maxError < 1e-4;
+    if (!ok)
+        fprintf(stderr, "%s: oscillator error %g\n", patch->name, maxError);
+    return ok;
+}
+
+// Seconds of CPU per voice per block, keeping BENCH_VOICES notes sounding
+static double secondsPerVoiceBlock(const SynthPatch *patch, int blockFrames)
+{
+    float *block = platformAlignedAlloc(64, sizeof(float) * (size_t)blockFrames);
+    Synth synth;
+    synthInit(&synth, SAMPLE_RATE);
+    long long voiceBlocks = 0;
+    int note = 0;
+
+    double start = platformTimeSeconds();
+    double elapsed = 0.0;
+    do
+    {
+        for (int rep = 0; rep < 64; rep++)
+        {
+            // Replace finished notes so the voice count stays constant
+            while (synth.pool.playing < BENCH_VOICES)
+            {
+                float frequency = 110.0f * powf(2.0f, (float)(note++ % 48) / 12.0f);
+                synthNoteOn(&synth, patch, frequency, 0.1f, 0);
+            }
+            memset(block, 0, sizeof(float) * (size_t)blockFrames);
+            synthRender(&synth, block, blockFrames);
+            voiceBlocks += BENCH_VOICES;
+        }
+        elapsed = platformTimeSeconds() - start;
+    } while (elapsed < MEASURE_SECONDS);
+
+    volatile float sink = block[0];
+    (void)sink;
+    platformAlignedFree(block);
+    return elapsed / (double)voiceBlocks;
+}
+
+int main(void)
+{
+    int failures = 0;
+    printf("%-8s %8s %14s %16s\n", "patch", "block", "ns/voice-block", "voices/core");
+    for (int i = 0; i < SYNTH_PATCH_COUNT; i++)
+    {
+        const SynthPatch *patch = &SYNTH_PATCHES[i];
+        if (!verify(patch))
+        {
+            failures++;
+            continue;
+        }
+        for (size_t b = 0; b < sizeof(BLOCK_SIZES) / sizeof(BLOCK_SIZES[0]); b++)
+        {
+            int frames = BLOCK_SIZES[b];
+            double perVoice = secondsPerVoiceBlock(patch, frames);
+            double blockSeconds = (double)frames / SAMPLE_RATE;
+            printf("%-8s %8d %14.1f %16.0f\n", patch->name, frames, perVoice * 1e9, blockSeconds / perVoice);
+        }
+    }
+    return failures ? 1 : 0;
+}
@@ -1,14 +1,45 @@
 #version 330 core
 out vec4 FragColor;
 in vec2 TexCoord;
+in vec3 BaseColor;
+flat in int Instrument;
+flat in int Playing;
 
 uniform float time;
 uniform bool isSelected;
-uniform bool isPlaying;
-uniform vec3 baseColor;
+uniform int mode; // 0 = note cell, 1 = instrument indicator, 2 = plain quad
+
+// One-pixel outline of the instrument glyph in the 6x6 indicator box
+bool indicatorOutline(vec2 uv)
+{
+    float t = 1.0 / 6.0;
+    if (Instrument == 0) {
+        // Piano: square
+        return uv.x < t || uv.x > 1.0 - t || uv.y < t || uv.y > 1.0 - t;
+    } else if (Instrument == 1) {
+        // Synth: triangle, apex at the top
+        float edge = abs(uv.x * 2.0 - 1.0);
+        return uv.y >= edge && (uv.y - edge < t * 2.0 || uv.y > 1.0 - t);
+    }
+    // Bell: circle
+    return abs(length(uv - 0.5) - (0.5 - t * 0.5)) < t * 0.5;
+}
 
 void main()
 {
+    if (mode == 2) {
+        FragColor = vec4(BaseColor, 1.0);
+        return;
+    }
+    if (mode == 1) {
+        if (!indicatorOutline(TexCoord))
+            discard;
+        FragColor = vec4(1.0);
+        return;
+    }
+
+    vec3 baseColor = BaseColor;
+    bool isPlaying = Playing != 0;
     vec3 color = baseColor;
     
     if (isSelected) {
@@ -35,4 +66,4 @@ void main()
     }
     
     FragColor = vec4(color, 1.0);
-} 
\ No newline at end of file
+}
@@ -0,0 +1,14 @@
+#version 330 core
+out vec4 FragColor;
+in vec2 TexCoord;
+in vec3 Color;
+
+uniform sampler2D atlas;
+
+void main()
+{
+    // The atlas is one bit per texel: glyph pixels and the solid cell are set
+    if (texture(atlas, TexCoord).r < 0.5)
+        discard;
+    FragColor = vec4(Color, 1.0);
+}
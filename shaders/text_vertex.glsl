@@ -0,0 +1,20 @@
+#version 330 core
+layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec2 aTexCoord;
+
+// Per-instance quad data
+layout (location = 2) in vec4 aRect;  // x, y, width, height in pixels
+layout (location = 3) in vec4 aAtlas; // u, v, width, height in the atlas
+layout (location = 4) in vec3 aColor;
+
+out vec2 TexCoord;
+out vec3 Color;
+
+uniform mat4 transform;
+
+void main()
+{
+    gl_Position = transform * vec4(aRect.xy + aPos.xy * aRect.zw, aPos.z, 1.0);
+    TexCoord = aAtlas.xy + aTexCoord * aAtlas.zw;
+    Color = aColor;
+}
@@ -2,11 +2,36 @@
 layout (location = 0) in vec3 aPos;
 layout (location = 1) in vec2 aTexCoord;
 
+// Per-instance grid data
+layout (location = 2) in vec4 aRect;  // x, y, width, height in pixels
+layout (location = 3) in vec3 aColor;
+layout (location = 4) in vec3 aFlags; // instrument, active, playing
+
 out vec2 TexCoord;
+out vec3 BaseColor;
+flat out int Instrument;
+flat out int Playing;
+
 uniform mat4 transform;
+uniform int mode; // 0 = note cell, 1 = instrument indicator, 2 = plain quad
 
 void main()
 {
-    gl_Position = transform * vec4(aPos, 1.0);
+    vec4 rect = aRect;
+    if (mode == 0) {
+        rect = vec4(rect.xy + 2.0, rect.zw - 4.0);
+    } else if (mode == 1) {
+        rect = vec4(rect.xy + 4.0, 6.0, 6.0);
+    }
+
+    gl_Position = transform * vec4(rect.xy + aPos.xy * rect.zw, aPos.z, 1.0);
+    if (mode != 2 && aFlags.y < 0.5) {
+        // Empty cell: collapse outside the clip volume
+        gl_Position = vec4(2.0, 2.0, 2.0, 1.0);
+    }
+
     TexCoord = aTexCoord;
-} 
\ No newline at end of file
+    BaseColor = aColor;
+    Instrument = int(aFlags.x);
+    Playing = int(aFlags.z);
+}
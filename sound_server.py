@@ -1,8 +1,9 @@
-import sounddevice as sd
 import numpy as np
+import heapq
+import struct
 import sys
 import time
-from threading import Thread, Lock
+from threading import Lock
 import json
 
 # Audio parameters
@@ -10,85 +11,317 @@ SAMPLE_RATE = 44100
 AMPLITUDE = 0.3
 ATTACK_TIME = 0.01
 RELEASE_TIME = 0.1
+MAX_VOICES = 64
+BLOCK_SIZE = 512
+
+class OscillatorBank:
+    """Fixed pool of sine voices whose state persists between callbacks.
+
+    Phase and envelope level are carried across blocks, so notes neither
+    click at block boundaries nor allocate per note. Every block is computed
+    for all voices at once as a (voices, frames) array. The envelope is a
+    linear ramp clipped to [0, 1]: rising at the attack rate after note-on,
+    falling at the release rate after note-off, flat in between.
+    """
+
+    def __init__(self, max_voices=MAX_VOICES, sample_rate=SAMPLE_RATE):
+        self.sample_rate = sample_rate
+        self.frequency = np.zeros(max_voices)
+        self.phase = np.zeros(max_voices)  # Radians, kept in [0, 2*pi)
+        self.level = np.zeros(max_voices)  # Envelope level at the next frame
+        self.rate = np.zeros(max_voices)   # Envelope change per frame
+        self.gain = np.zeros(max_voices)
+        self.active = np.zeros(max_voices, dtype=bool)
+        self.age = np.zeros(max_voices, dtype=np.int64)
+        self.attack_rate = 1.0 / max(1, int(ATTACK_TIME * sample_rate))
+        self.release_rate = -1.0 / max(1, int(RELEASE_TIME * sample_rate))
+        self._ramp = np.arange(BLOCK_SIZE, dtype=np.float64)
+        self._clock = 0
+
+    def note_on(self, frequency, velocity=1.0):
+        # Retrigger a sounding note in place so its phase stays continuous
+        held = np.flatnonzero(self.active & (self.frequency == frequency))
+        if held.size:
+            voice = held[0]
+        else:
+            free = np.flatnonzero(~self.active)
+            # Steal the oldest voice when the pool is full
+            voice = free[0] if free.size else int(np.argmin(self.age))
+            self.phase[voice] = 0.0
+            self.level[voice] = 0.0
+        self.frequency[voice] = frequency
+        self.gain[voice] = AMPLITUDE * velocity
+        self.rate[voice] = self.attack_rate
+        self.active[voice] = True
+        self.age[voice] = self._clock
+        self._clock += 1
+
+    def note_off(self, frequency):
+        self.rate[self.active & (self.frequency == frequency)] = self.release_rate
+
+    def all_notes_off(self):
+        self.rate[self.active] = self.release_rate
+
+    def sounding_frequencies(self):
+        return set(self.frequency[self.active & (self.rate >= 0)].tolist())
+
+    def render(self, frames):
+        voices = np.flatnonzero(self.active)
+        if voices.size == 0:
+            return np.zeros(frames)
+        if frames > self._ramp.size:
+            self._ramp = np.arange(frames, dtype=np.float64)
+        ramp = self._ramp[:frames]
+
+        step = 2.0 * np.pi * self.frequency[voices] / self.sample_rate
+        phases = self.phase[voices, None] + step[:, None] * ramp
+        envelope = np.clip(self.level[voices, None] + self.rate[voices, None] * ramp, 0.0, 1.0)
+        mixed = np.einsum('vf,vf,v->f', np.sin(phases), envelope, self.gain[voices])
+
+        # Carry the state over to the next block
+        self.phase[voices] = np.mod(self.phase[voices] + step * frames, 2.0 * np.pi)
+        self.level[voices] = np.clip(self.level[voices] + self.rate[voices] * frames, 0.0, 1.0)
+        finished = voices[(self.rate[voices] < 0) & (self.level[voices] <= 0.0)]
+        self.active[finished] = False
+        return mixed
+
+# Shared-memory event ring; layout mirrors src/event_ring.h
+RING_MAGIC = 0x5244534C
+RING_VERSION = 1
+RING_HEADER = struct.Struct('<IIIIi')
+RING_WRITE_OFFSET = 64
+RING_READ_OFFSET = 128
+RING_FRAME_OFFSET = 192
+RING_EVENTS_OFFSET = 256
+RING_EVENT = struct.Struct('<qfiBBBBI')
+NOTE_ON, NOTE_OFF, ALL_OFF = 1, 2, 3
+
+class EventRing:
+    """Consumer side of the sequencer's single-producer event ring.
+
+    Indices and the published frame are plain aligned stores, which relies
+    on x86's ordering guarantees; the C producer uses release/acquire.
+    """
+
+    def __init__(self, name):
+        from multiprocessing import shared_memory
+        self.shm = shared_memory.SharedMemory(name=name.lstrip('/'))
+        try:
+            # The producer owns the name; don't let Python unlink it at exit
+            from multiprocessing import resource_tracker
+            resource_tracker.unregister(self.shm._name, 'shared_memory')
+        except Exception:
+            pass
+        self.buf = self.shm.buf
+        magic, version, capacity, event_size, sample_rate = RING_HEADER.unpack_from(self.buf, 0)
+        if magic != RING_MAGIC or version != RING_VERSION or event_size != RING_EVENT.size:
+            raise ValueError(f"{name} is not a version {RING_VERSION} event ring")
+        if sample_rate != SAMPLE_RATE:
+            raise ValueError(f"ring runs at {sample_rate} Hz, server at {SAMPLE_RATE} Hz")
+        self.mask = capacity - 1
+        self.next_sequence = None
+        self.lost = 0
+
+    def pop_all(self):
+        write = struct.unpack_from('<i', self.buf, RING_WRITE_OFFSET)[0]
+        read = struct.unpack_from('<i', self.buf, RING_READ_OFFSET)[0]
+        events = []
+        while read != write:
+            event = RING_EVENT.unpack_from(self.buf, RING_EVENTS_OFFSET + (read & self.mask) * RING_EVENT.size)
+            sequence = event[7]
+            if self.next_sequence is not None and sequence != self.next_sequence:
+                self.lost += (sequence - self.next_sequence) & 0xFFFFFFFF
+            self.next_sequence = (sequence + 1) & 0xFFFFFFFF
+            events.append(event)
+            read = (read + 1 + 2**31) % 2**32 - 2**31  # int32 wraparound
+        struct.pack_into('<i', self.buf, RING_READ_OFFSET, read)
+        return events
+
+    def publish_frame(self, frame):
+        struct.pack_into('<q', self.buf, RING_FRAME_OFFSET, frame)
+
+    def close(self):
+        self.buf = None
+        self.shm.close()
+
+class EventScheduler:
+    """Applies time-stamped events to the bank on their exact frame by
+    splitting each block at event boundaries."""
+
+    def __init__(self, ring):
+        self.ring = ring
+        self.frame = 0
+        self.pending = []  # Heap of (frame, order, type, frequency, velocity)
+        self.order = 0
+        self.late = 0
+
+    def schedule(self, frame, kind, frequency, velocity=1.0):
+        heapq.heappush(self.pending, (frame, self.order, kind, frequency, velocity))
+        self.order += 1
+
+    def render(self, frames):
+        for frame, frequency, length, kind, _instrument, velocity, _reserved, _sequence in self.ring.pop_all():
+            if kind == ALL_OFF:
+                # Also cancels what is pending past it, e.g. events the
+                # producer timed on an earlier server's clock
+                self.pending = [event for event in self.pending if event[0] < frame]
+                heapq.heapify(self.pending)
+            self.schedule(frame, kind, frequency, velocity / 127.0)
+            if kind == NOTE_ON and length > 0:
+                self.schedule(frame + length, NOTE_OFF, frequency)
+
+        out = np.empty(frames)
+        end = self.frame + frames
+        position = 0
+        while self.pending and self.pending[0][0] < end:
+            frame, _order, kind, frequency, velocity = heapq.heappop(self.pending)
+            if frame < self.frame:
+                self.late += 1
+            offset = max(0, frame - self.frame)
+            if offset > position:
+                out[position:offset] = bank.render(offset - position)
+                position = offset
+            if kind == NOTE_ON:
+                bank.note_on(frequency, velocity)
+            elif kind == NOTE_OFF:
+                bank.note_off(frequency)
+            elif kind == ALL_OFF:
+                bank.all_notes_off()
+        out[position:] = bank.render(frames - position)
+
+        self.frame = end
+        self.ring.publish_frame(self.frame)
+        return out
 
 # Global state
-active_notes = set()
+bank = OscillatorBank()
 note_lock = Lock()
-
-def generate_sine_wave(frequency, duration):
-    t = np.linspace(0, duration, int(SAMPLE_RATE * duration), False)
-    tone = AMPLITUDE * np.sin(2 * np.pi * frequency * t)
-    
-    # Apply simple envelope
-    attack_samples = int(ATTACK_TIME * SAMPLE_RATE)
-    release_samples = int(RELEASE_TIME * SAMPLE_RATE)
-    
-    attack = np.linspace(0, 1, attack_samples)
-    release = np.linspace(1, 0, release_samples)
-    sustain = np.ones(len(tone) - attack_samples - release_samples)
-    
-    envelope = np.concatenate([attack, sustain, release])
-    return tone * envelope
+scheduler = None  # EventScheduler when fed from the event ring
 
 def audio_callback(outdata, frames, time, status):
     if status:
         print(status)
-    
+
     with note_lock:
-        if not active_notes:
-            outdata.fill(0)
-            return
-            
-        # Mix all active notes
-        mixed = np.zeros(frames)
-        for freq in active_notes:
-            samples = generate_sine_wave(freq, frames/SAMPLE_RATE)
-            mixed += samples[:frames]
-        
-        # Normalize
-        if len(active_notes) > 0:
-            mixed /= len(active_notes)
-        
-        outdata[:, 0] = mixed
+        mixed = scheduler.render(frames) if scheduler else bank.render(frames)
+    # Fixed per-voice gain, so chords never change the level of held notes
+    np.clip(mixed, -1.0, 1.0, out=mixed)
+    outdata[:, 0] = mixed
 
 def start_audio():
+    import sounddevice as sd
     stream = sd.OutputStream(
         channels=1,
         callback=audio_callback,
-        samplerate=SAMPLE_RATE
+        samplerate=SAMPLE_RATE,
+        blocksize=BLOCK_SIZE
     )
     stream.start()
     return stream
 
+def handle_command(data):
+    command = data.get('command')
+    with note_lock:
+        if command == 'note_on':
+            bank.note_on(float(data['frequency']), float(data.get('velocity', 1.0)))
+        elif command == 'note_off':
+            bank.note_off(float(data['frequency']))
+        elif command == 'play':
+            # Chord change: release what is no longer held, start what is new
+            wanted = set(float(f) for f in data.get('frequencies', []))
+            for freq in bank.sounding_frequencies() - wanted:
+                bank.note_off(freq)
+            for freq in wanted - bank.sounding_frequencies():
+                bank.note_on(freq)
+        elif command == 'stop':
+            bank.all_notes_off()
+        else:
+            print(f"Unknown command: {command}")
+
+def benchmark():
+    """Times the callback against the number of sounding voices."""
+    global bank
+    block_seconds = BLOCK_SIZE / SAMPLE_RATE
+    outdata = np.zeros((BLOCK_SIZE, 1), dtype=np.float32)
+    print(f"Block: {BLOCK_SIZE} frames ({block_seconds * 1000:.2f} ms)")
+    print(f"{'voices':>8} {'us/callback':>12} {'% of block':>11}")
+    for count in (1, 2, 4, 8, 16, 32, 64):
+        bank = OscillatorBank()
+        for i in range(count):
+            bank.note_on(110.0 * 2.0 ** (i / 12.0))
+        runs = 0
+        start = time.perf_counter()
+        while time.perf_counter() - start < 0.5:
+            audio_callback(outdata, BLOCK_SIZE, None, None)
+            runs += 1
+        elapsed = (time.perf_counter() - start) / runs
+        print(f"{count:>8} {elapsed * 1e6:>12.1f} {elapsed / block_seconds * 100:>10.1f}%")
+
+def run_ring(name, dry_run):
+    """Plays events from the sequencer's shared-memory ring until Ctrl+C.
+    --dry-run paces the callback with a timer instead of an audio device."""
+    global scheduler
+    scheduler = EventScheduler(EventRing(name))
+    # Whatever is left in the ring was timed on an earlier server's clock.
+    # Frame 0 means "no consumer yet" to the producer, and a frame lower
+    # than the last one it saw makes it restart scheduling from there.
+    scheduler.ring.pop_all()
+    scheduler.frame = 1
+    scheduler.ring.publish_frame(scheduler.frame)
+    print(f"Playing events from {name}")
+
+    stream = None
+    outdata = np.zeros((BLOCK_SIZE, 1), dtype=np.float32)
+    try:
+        if dry_run:
+            next_block = time.perf_counter()
+            while True:
+                audio_callback(outdata, BLOCK_SIZE, None, None)
+                next_block += BLOCK_SIZE / SAMPLE_RATE
+                time.sleep(max(0.0, next_block - time.perf_counter()))
+        else:
+            stream = start_audio()
+            while True:
+                time.sleep(1.0)
+    except KeyboardInterrupt:
+        pass
+    finally:
+        if stream:
+            stream.stop()
+            stream.close()
+        print(f"\nFrames: {scheduler.frame}, late events: {scheduler.late}, lost events: {scheduler.ring.lost}")
+        scheduler.ring.close()
+
 def main():
+    if '--bench' in sys.argv:
+        benchmark()
+        return
+    if '--ring' in sys.argv:
+        index = sys.argv.index('--ring')
+        name = sys.argv[index + 1] if index + 1 < len(sys.argv) and not sys.argv[index + 1].startswith('--') else 'lsdvis_events'
+        run_ring(name, '--dry-run' in sys.argv)
+        return
+
     print("Starting sound server...")
     stream = start_audio()
-    
+
     try:
         while True:
             try:
-                line = sys.stdin.readline().strip()
+                line = sys.stdin.readline()
+                if not line:
+                    break
+                line = line.strip()
                 if not line:
                     continue
-                    
-                data = json.loads(line)
-                command = data.get('command')
-                
-                if command == 'play':
-                    frequencies = data.get('frequencies', [])
-                    with note_lock:
-                        active_notes.clear()
-                        active_notes.update(frequencies)
-                
-                elif command == 'stop':
-                    with note_lock:
-                        active_notes.clear()
-                
+
+                handle_command(json.loads(line))
+
             except json.JSONDecodeError:
                 print("Invalid JSON received")
             except Exception as e:
                 print(f"Error: {e}")
-                
+
     except KeyboardInterrupt:
         print("\nStopping sound server...")
     finally:
@@ -96,4 +329,4 @@ def main():
         stream.close()
 
 if __name__ == "__main__":
-    main() 
\ No newline at end of file
+    main()
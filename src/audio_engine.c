@@ -0,0 +1,435 @@
+#include "audio_engine.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "mix_kernels.h"
+#include "resampler.h"
+#include "trace.h"
+
+#define FADE_FRAMES ((int32_t)(AUDIO_SAMPLE_RATE * VOICE_POOL_FADE_SECONDS))
+
+void audioEngineInit(AudioEngine *engine)
+{
+    memset(engine, 0, sizeof(*engine));
+    engine->masterGain = 0.5f; // Headroom for chords
+    voicePoolInit(&engine->voicePool, VOICE_POOL_DEFAULT_VOICES, VOICE_STEAL_OLDEST);
+    synthInit(&engine->synth, AUDIO_SAMPLE_RATE);
+    resamplerInit();
+    for (int i = 0; i < VOICE_POOL_MAX_SLOTS; i++)
+        engine->voices[i].streamSlot = -1;
+}
+
+void audioEngineSetBlockCallback(AudioEngine *engine, AudioBlockCallback callback, void *user)
+{
+    engine->blockCallback = callback;
+    engine->blockCallbackUser = user;
+}
+
+void audioEngineSetStreamer(AudioEngine *engine, SampleStreamer *streamer)
+{
+    engine->streamer = streamer;
+}
+
+void audioEngineSetPolyphony(AudioEngine *engine, int voices, VoiceStealPolicy policy)
+{
+    voicePoolInit(&engine->voicePool, voices, policy);
+    synthSetPolyphony(&engine->synth, voices, policy);
+}
+
+static bool pushTrigger(AudioEngine *engine, const AudioTrigger *trigger)
+{
+    int32_t write = engine->triggerWrite; // Only this thread writes it
+    int32_t read = atomicLoad32(&engine->triggerRead);
+    if (write - read >= AUDIO_TRIGGER_QUEUE_SIZE)
+    {
+        atomicStore32(&engine->stats.droppedTriggers, engine->stats.droppedTriggers + 1);
+        return false;
+    }
+
+    engine->triggers[write & (AUDIO_TRIGGER_QUEUE_SIZE - 1)] = *trigger;
+    atomicStore32(&engine->triggerWrite, write + 1);
+    return true;
+}
+
+bool audioEngineTrigger(AudioEngine *engine, const SampleRef *sample, float rate, float gain)
+{
+    AudioTrigger trigger = {sample, rate, NULL, 0.0f, gain, -1, 0.0};
+    return pushTrigger(engine, &trigger);
+}
+
+bool audioEngineTriggerSynth(AudioEngine *engine, const SynthPatch *patch, float frequency, float gain)
+{
+    AudioTrigger trigger = {NULL, 1.0f, patch, frequency, gain, -1, 0.0};
+    return pushTrigger(engine, &trigger);
+}
+
+bool audioEngineMark(AudioEngine *engine, AudioMark mark, double stamp)
+{
+    AudioTrigger trigger = {NULL, 1.0f, NULL, 0.0f, 0.0f, (int)mark, stamp};
+    return pushTrigger(engine, &trigger);
+}
+
+static void fadeOut(AudioVoice *voice)
+{
+    if (voice->delay > 0)
+    {
+        // Never sounded: end it at the next block
+        voice->delay = 0;
+        voice->length = voice->position;
+    }
+    else
+    {
+        voice->fadeFrames = FADE_FRAMES;
+    }
+}
+
+// The voice has ended, or its slot is being taken over
+static void releaseStream(AudioEngine *engine, AudioVoice *voice)
+{
+    if (voice->streamSlot < 0)
+        return;
+    sampleStreamerRelease(engine->streamer, voice->streamSlot);
+    voice->streamSlot = -1;
+}
+
+void audioEngineStartVoice(AudioEngine *engine, const SampleRef *sample, float rate, float gain, int offset)
+{
+    if (!sample || !sample->samples || sample->frames <= 0 || !(rate > 0.0f))
+        return;
+    const float *samples = sample->samples;
+
+    // A sample and a rate make a pitch: the retrigger key
+    uint32_t rateBits;
+    memcpy(&rateBits, &rate, sizeof(rateBits));
+    int fadeSlot;
+    int slot = voicePoolAlloc(&engine->voicePool, ((uint64_t)(uintptr_t)samples << 16) ^ rateBits, &fadeSlot);
+    if (fadeSlot >= 0)
+        fadeOut(&engine->voices[fadeSlot]);
+
+    AudioVoice *voice = &engine->voices[slot];
+    releaseStream(engine, voice); // A cut fade
+    int32_t length = sample->frames;
+    voice->residentFrames = sample->residentFrames;
+    if (sample->stream >= 0)
+    {
+        voice->streamSlot = engine->streamer ? sampleStreamerClaim(engine->streamer, sample->stream) : -1;
+        if (voice->streamSlot < 0)
+            length = sample->residentFrames;
+    }
+    voice->samples = samples;
+    voice->length = length;
+    voice->filter = NULL;
+    voice->source = 0;
+    voice->step = (uint64_t)1 << 32;
+    if (rate != 1.0f)
+    {
+        voice->filter = resamplerFilter(rate);
+        voice->step = resamplerStep(rate);
+        voice->length = (int32_t)ceil((double)length / rate);
+    }
+    voice->position = 0;
+    voice->delay = offset;
+    voice->gain = gain;
+    voice->fadeFrames = 0;
+    engine->voicePool.slots[slot].level = gain;
+}
+
+void audioEngineStartSynth(AudioEngine *engine, const SynthPatch *patch, float frequency, float gain, int offset)
+{
+    synthNoteOn(&engine->synth, patch, frequency, gain * engine->masterGain, offset);
+}
+
+void audioEngineNoteStep(AudioEngine *engine, int64_t frame, bool restart)
+{
+    if (engine->pendingStepCount < AUDIO_MAX_PENDING)
+        engine->pendingSteps[engine->pendingStepCount++] = (AudioPendingStep){frame, restart};
+}
+
+static void drainTriggers(AudioEngine *engine)
+{
+    int32_t read = engine->triggerRead; // Only this thread writes it
+    int32_t write = atomicLoad32(&engine->triggerWrite);
+    while (read != write)
+    {
+        const AudioTrigger *trigger = &engine->triggers[read & (AUDIO_TRIGGER_QUEUE_SIZE - 1)];
+        if (trigger->mark >= 0)
+        {
+            if (engine->pendingMarkCount < AUDIO_MAX_PENDING)
+                engine->pendingMarks[engine->pendingMarkCount++] = *trigger;
+        }
+        else if (trigger->patch)
+            audioEngineStartSynth(engine, trigger->patch, trigger->frequency, trigger->gain, 0);
+        else
+            audioEngineStartVoice(engine, trigger->sample, trigger->rate, trigger->gain, 0);
+        read++;
+    }
+    atomicStore32(&engine->triggerRead, read);
+}
+
+// Adds in x gain, ramped down to reach zero `fadeFrames` frames from here
+static void mixFadeOut(float *out, const float *in, float gain, int32_t fadeFrames, int frames)
+{
+    float step = gain / (float)FADE_FRAMES;
+    float g = step * (float)fadeFrames;
+    for (int i = 0; i < frames; i++)
+    {
+        out[i] += in[i] * g;
+        g -= step;
+    }
+}
+
+void audioEngineRender(AudioEngine *engine, float *out, int frames)
+{
+    int64_t blockStart = engine->frameCounter;
+
+    engine->pendingStepCount = 0;
+    engine->pendingMarkCount = 0;
+    drainTriggers(engine);
+    if (engine->blockCallback)
+        engine->blockCallback(engine->blockCallbackUser, engine, blockStart, frames);
+    memset(out, 0, sizeof(float) * (size_t)frames);
+
+    MixAddFn mixAdd = mixKernels()->mixAdd;
+    MixResampleFn mixResample = mixKernels()->mixResample;
+    VoicePool *pool = &engine->voicePool;
+    for (int i = 0; i < pool->activeCount;)
+    {
+        int slot = pool->active[i];
+        AudioVoice *voice = &engine->voices[slot];
+        if (voice->delay >= frames)
+        {
+            voice->delay -= frames;
+            i++;
+            continue;
+        }
+
+        int start = voice->delay;
+        int32_t remaining = voice->length - voice->position;
+        int n = remaining < frames - start ? (int)remaining : frames - start;
+        float gain = voice->gain * engine->masterGain;
+        if (voice->fadeFrames > 0 && n > voice->fadeFrames)
+            n = voice->fadeFrames;
+
+        // In spans that each read from one place: the resident frames or,
+        // for a streamed sample, a single chunk
+        for (int done = 0; done < n;)
+        {
+            const float *src = voice->samples;
+            uint64_t position = voice->source;
+            int span = n - done;
+            int32_t index = (int32_t)(voice->source >> 32);
+            if (voice->streamSlot >= 0)
+            {
+                int32_t first = 0;
+                int32_t end = voice->residentFrames;
+                if (index >= voice->residentFrames)
+                {
+                    int32_t chunk = (index - voice->residentFrames) / SAMPLE_STREAM_CHUNK_FRAMES;
+                    first = voice->residentFrames + chunk * SAMPLE_STREAM_CHUNK_FRAMES;
+                    end = first + SAMPLE_STREAM_CHUNK_FRAMES;
+                    src = sampleStreamerChunk(engine->streamer, voice->streamSlot, chunk);
+                    sampleStreamerAdvance(engine->streamer, voice->streamSlot, chunk);
+                    if (!src)
+                    {
+                        // Not read yet: skip ahead in silence rather than wait
+                        TRACE_INSTANT("stream underrun");
+                        voice->source += voice->step * (uint64_t)span;
+                        break;
+                    }
+                }
+                uint64_t fit = (((uint64_t)end << 32) - voice->source + voice->step - 1) / voice->step;
+                if (fit < (uint64_t)span)
+                    span = (int)fit;
+                position -= (uint64_t)first << 32;
+            }
+
+            float *dst = out + start + done;
+            if (voice->fadeFrames > 0)
+            {
+                const float *in = src + (position >> 32);
+                if (voice->filter)
+                {
+                    memset(engine->fadeBuffer, 0, sizeof(float) * (size_t)span);
+                    resamplerMix(mixResample, engine->fadeBuffer, src, position, voice->step, voice->filter, 1.0f, span);
+                    in = engine->fadeBuffer;
+                }
+                mixFadeOut(dst, in, gain, voice->fadeFrames - done, span);
+            }
+            else if (voice->filter)
+            {
+                resamplerMix(mixResample, dst, src, position, voice->step, voice->filter, gain, span);
+            }
+            else
+            {
+                mixAdd(dst, src + (position >> 32), gain, span);
+            }
+            voice->source += voice->step * (uint64_t)span;
+            done += span;
+        }
+        if (voice->fadeFrames > 0)
+        {
+            voice->fadeFrames -= n;
+            if (voice->fadeFrames == 0)
+                voice->length = voice->position + n;
+        }
+
+        voice->delay = 0;
+        voice->position += n;
+        if (voice->position >= voice->length)
+        {
+            // Finished: the last active slot takes its place
+            releaseStream(engine, voice);
+            voicePoolFree(pool, slot);
+            continue;
+        }
+        // Samples mostly decay over their length: a cheap loudness guess
+        pool->slots[slot].level = voice->gain * (float)(voice->length - voice->position) / (float)voice->length;
+        i++;
+    }
+    synthRender(&engine->synth, out, frames);
+
+    atomicStore64(&engine->frameCounter, blockStart + frames);
+}
+
+// Times what the block just rendered carried, now that it goes to the sink
+// and its first frame will leave it at `out`
+static void recordLatency(AudioEngine *engine, int64_t blockStart, double out)
+{
+    AudioEngineStats *stats = &engine->stats;
+    double periodSeconds = (double)engine->periodFrames / AUDIO_SAMPLE_RATE;
+    for (int i = 0; i < engine->pendingStepCount; i++)
+    {
+        const AudioPendingStep *step = &engine->pendingSteps[i];
+        double onset = out + (double)(step->frame - blockStart) / AUDIO_SAMPLE_RATE;
+        double scheduled = engine->streamStart + (double)step->frame / AUDIO_SAMPLE_RATE;
+        latencyHistogramRecord(&stats->stepLatency, onset - scheduled);
+
+        // Against where the previous step's spacing says it belongs
+        if (engine->haveLastOnset && !step->restart)
+        {
+            double deviation = (onset - engine->lastOnset) - (double)(step->frame - engine->lastStepFrame) / AUDIO_SAMPLE_RATE;
+            latencyHistogramRecord(&stats->stepJitter, deviation < 0.0 ? -deviation : deviation);
+            if (deviation >= periodSeconds)
+            {
+                atomicStore32(&stats->lateSteps, stats->lateSteps + 1);
+                TRACE_INSTANT("late step");
+            }
+        }
+        engine->haveLastOnset = true;
+        engine->lastOnset = onset;
+        engine->lastStepFrame = step->frame;
+    }
+    for (int i = 0; i < engine->pendingMarkCount; i++)
+        latencyHistogramRecord(&stats->marks[engine->pendingMarks[i].mark], out - engine->pendingMarks[i].stamp);
+}
+
+static void audioThreadMain(void *arg)
+{
+    AudioEngine *engine = arg;
+    platformThreadSetRealtime();
+    TRACE_THREAD("audio");
+
+    while (atomicLoad32(&engine->running))
+    {
+        int64_t blockStart = engine->frameCounter;
+        TRACE_BEGIN(render, "audio block");
+        audioEngineRender(engine, engine->mixBuffer, engine->periodFrames);
+        TRACE_END(render);
+
+        // The sink plays what it had queued, less what it has played since
+        // the last write returned, before this block
+        double handoff = platformTimeSeconds();
+        double out = handoff;
+        if (engine->streamStarted)
+            out = fmax(handoff, engine->lastWrite + (double)engine->sink->queuedFrames / AUDIO_SAMPLE_RATE);
+        else
+            engine->streamStart = handoff - (double)blockStart / AUDIO_SAMPLE_RATE;
+        engine->streamStarted = true;
+        recordLatency(engine, blockStart, out);
+
+        TRACE_BEGIN(write, "sink write");
+        bool ok = engine->sink->write(engine->sink, engine->mixBuffer, engine->periodFrames);
+        engine->lastWrite = platformTimeSeconds();
+        TRACE_END(write);
+        if (engine->sink->underruns != engine->stats.underruns)
+        {
+            TRACE_INSTANT("underrun");
+            atomicStore32(&engine->stats.underruns, engine->sink->underruns);
+        }
+        if (!ok)
+        {
+            fprintf(stderr, "Audio sink '%s' write failed, stopping audio thread\n", engine->sink->name);
+            break;
+        }
+    }
+}
+
+void audioEngineDefaultConfig(AudioSinkConfig *config)
+{
+    config->sampleRate = AUDIO_SAMPLE_RATE;
+    config->periodFrames = AUDIO_BLOCK_FRAMES;
+    config->periodCount = AUDIO_DEFAULT_PERIODS;
+    config->device = NULL;
+}
+
+bool audioEngineStart(AudioEngine *engine, AudioSink *sink, const AudioSinkConfig *config)
+{
+    if (!sink || config->sampleRate != AUDIO_SAMPLE_RATE ||
+        config->periodFrames < 1 || config->periodFrames > AUDIO_MAX_PERIOD_FRAMES || config->periodCount < 1)
+        return false;
+    if (!sink->open(sink, config))
+        return false;
+
+    engine->sink = sink;
+    sink->queuedFrames = 0;
+    engine->streamStarted = false;
+    engine->periodFrames = config->periodFrames;
+    engine->bufferFrames = config->periodFrames * config->periodCount;
+    atomicStore32(&engine->running, 1);
+    engine->thread = platformThreadStart(audioThreadMain, engine);
+    if (!engine->thread)
+    {
+        atomicStore32(&engine->running, 0);
+        sink->close(sink);
+        engine->sink = NULL;
+        return false;
+    }
+    return true;
+}
+
+void audioEngineStop(AudioEngine *engine)
+{
+    if (!engine->thread)
+        return;
+    atomicStore32(&engine->running, 0);
+    platformThreadJoin(engine->thread);
+    engine->thread = NULL;
+    engine->sink->close(engine->sink);
+    engine->sink = NULL;
+}
+
+void audioEnginePrintVoices(AudioEngine *engine, FILE *out)
+{
+    voicePoolPrint(&engine->voicePool, "sample voices", out);
+    voicePoolPrint(&engine->synth.pool, "synth voices", out);
+    if (engine->streamer && engine->streamer->arena)
+        sampleStreamerPrintStats(engine->streamer, out);
+}
+
+void audioEnginePrintStats(AudioEngine *engine, FILE *out)
+{
+    static const char *const MARK_LABELS[AUDIO_MARK_COUNT] = {"click to sound", "key to start"};
+    AudioEngineStats *stats = &engine->stats;
+    fprintf(out, "Audio latency out of the sink (%.1f ms buffer):\n",
+            1000.0 * engine->bufferFrames / AUDIO_SAMPLE_RATE);
+    latencyHistogramPrint(&stats->stepLatency, "step latency", out);
+    latencyHistogramPrint(&stats->stepJitter, "step jitter", out);
+    for (int i = 0; i < AUDIO_MARK_COUNT; i++)
+        latencyHistogramPrint(&stats->marks[i], MARK_LABELS[i], out);
+    fprintf(out, "  underruns %d, late steps %d, dropped triggers %d\n",
+            atomicLoad32(&stats->underruns), atomicLoad32(&stats->lateSteps),
+            atomicLoad32(&stats->droppedTriggers));
+    audioEnginePrintVoices(engine, out);
+}
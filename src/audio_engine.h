@@ -0,0 +1,185 @@
+#ifndef AUDIO_ENGINE_H
+#define AUDIO_ENGINE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "audio_sink.h"
+#include "latency_histogram.h"
+#include "platform.h"
+#include "resampler.h"
+#include "sample_bank.h"
+#include "sample_streamer.h"
+#include "synth.h"
+#include "voice_pool.h"
+
+#define AUDIO_SAMPLE_RATE 44100
+#define AUDIO_BLOCK_FRAMES 256     // Default period; also the offline render block
+#define AUDIO_MAX_PERIOD_FRAMES 4096
+#define AUDIO_DEFAULT_PERIODS 4
+#define AUDIO_TRIGGER_QUEUE_SIZE 256 // Must be a power of two
+#define AUDIO_MAX_PENDING 32         // Steps or marks timed per block
+
+// UI events timed from the callback to the first block that can sound them
+typedef enum
+{
+    AUDIO_MARK_CLICK, // Note preview from a grid click
+    AUDIO_MARK_START, // Playback start from Space
+    AUDIO_MARK_COUNT
+} AudioMark;
+
+// A one-shot request to start playing a bank sample, or a synth note when
+// patch is set
+typedef struct
+{
+    const SampleRef *sample;
+    float rate;
+    const SynthPatch *patch;
+    float frequency;
+    float gain;
+    int mark;     // AudioMark, or -1; a mark carries no sound
+    double stamp; // platformTimeSeconds() of the event being marked
+} AudioTrigger;
+
+// A sample played at its own rate reads it frame for frame; any other rate
+// goes through a resampling filter. Length and position count output
+// frames, source counts sample frames. Past residentFrames a streamed
+// sample reads the chunks its stream slot holds.
+typedef struct
+{
+    const float *samples;
+    int32_t length;
+    int32_t position;
+    int32_t delay; // Frames of silence before the first sample
+    float gain;
+    int32_t fadeFrames; // Left of a steal fade-out, or 0
+    const ResamplerFilter *filter; // resamplerFilter() for the rate, or NULL
+    uint64_t source;     // 32.32 fixed-point position in samples
+    uint64_t step;       // Added to source per output frame
+    int32_t residentFrames;
+    int streamSlot; // In the streamer, or -1
+} AudioVoice;
+
+// Times are to when a frame leaves the sink: the block's hand-off plus what
+// the sink still had queued ahead of it. Frame f is scheduled at
+// streamStart + f / AUDIO_SAMPLE_RATE, the stream's first frame setting the
+// anchor, so a step's latency is how far playback has slipped behind the
+// sample clock by the time it sounds.
+typedef struct
+{
+    LatencyHistogram stepLatency;             // Step scheduled -> its first sample out of the sink
+    LatencyHistogram stepJitter;              // |actual - nominal| spacing of consecutive steps out of the sink
+    LatencyHistogram marks[AUDIO_MARK_COUNT]; // UI event -> first sample that can sound it
+    volatile int32_t underruns;               // Reported by the sink
+    volatile int32_t lateSteps;               // Left the sink a period or more behind the beat
+    volatile int32_t droppedTriggers;         // Trigger queue full (UI thread)
+} AudioEngineStats;
+
+typedef struct
+{
+    int64_t frame;
+    bool restart; // First step after playback (re)started
+} AudioPendingStep;
+
+typedef struct AudioEngine AudioEngine;
+
+// Runs on the audio thread before each block is mixed. blockStart is the
+// engine's running sample-frame count at the first frame of the block.
+typedef void (*AudioBlockCallback)(void *user, AudioEngine *engine, int64_t blockStart, int frames);
+
+struct AudioEngine
+{
+    AudioSink *sink;
+    PlatformThread *thread;
+    volatile int32_t running;
+    int periodFrames; // Frames per block on the audio thread, fixed while running
+    float masterGain;
+
+    AudioBlockCallback blockCallback;
+    void *blockCallbackUser;
+    SampleStreamer *streamer; // For streamed samples; may be NULL
+
+    // Total frames rendered since start; written by the audio thread only
+    volatile int64_t frameCounter;
+
+    // Triggers from the UI thread (single producer) to the audio thread
+    // (single consumer); indices only ever grow and are masked on access
+    AudioTrigger triggers[AUDIO_TRIGGER_QUEUE_SIZE];
+    volatile int32_t triggerWrite;
+    volatile int32_t triggerRead;
+
+    // Audio thread only
+    AudioVoice voices[VOICE_POOL_MAX_SLOTS]; // Indexed by voicePool slot
+    VoicePool voicePool;
+    Synth synth;
+    float mixBuffer[AUDIO_MAX_PERIOD_FRAMES];
+    float fadeBuffer[AUDIO_MAX_PERIOD_FRAMES]; // A resampled voice before its fade
+
+    // Audio thread only: what the block being rendered must time once it
+    // reaches the sink, and the previous step's onset for jitter
+    AudioPendingStep pendingSteps[AUDIO_MAX_PENDING];
+    int pendingStepCount;
+    AudioTrigger pendingMarks[AUDIO_MAX_PENDING];
+    int pendingMarkCount;
+    bool haveLastOnset;
+    double lastOnset;
+    int64_t lastStepFrame;
+    bool streamStarted;
+    double streamStart; // When frame 0 left the sink
+    double lastWrite;   // When the sink's last write returned
+
+    int bufferFrames; // periodFrames x periodCount of the open sink
+    AudioEngineStats stats;
+};
+
+void audioEngineInit(AudioEngine *engine);
+
+// Must be called before audioEngineStart
+void audioEngineSetBlockCallback(AudioEngine *engine, AudioBlockCallback callback, void *user);
+// Must be called before audioEngineStart if any sample streams. Without a
+// streamer, streamed samples stop after their resident head.
+void audioEngineSetStreamer(AudioEngine *engine, SampleStreamer *streamer);
+// Sizes both the sample and the synth voice pools (VOICE_POOL_DEFAULT_VOICES
+// each after init); must be called before audioEngineStart
+void audioEngineSetPolyphony(AudioEngine *engine, int voices, VoiceStealPolicy policy);
+
+// Fills in AUDIO_SAMPLE_RATE, AUDIO_BLOCK_FRAMES x AUDIO_DEFAULT_PERIODS and
+// the backend's default device
+void audioEngineDefaultConfig(AudioSinkConfig *config);
+
+// Opens the sink and starts the audio thread, which renders and writes one
+// period of config->periodFrames (at most AUDIO_MAX_PERIOD_FRAMES) at a time
+bool audioEngineStart(AudioEngine *engine, AudioSink *sink, const AudioSinkConfig *config);
+void audioEngineStop(AudioEngine *engine);
+
+// Queues a sample for playback at `rate` sample frames per output frame
+// (1 plays it as recorded); never blocks, never touches the disk. The
+// sample must stay loaded while it may play. Returns false if the trigger
+// queue is full.
+bool audioEngineTrigger(AudioEngine *engine, const SampleRef *sample, float rate, float gain);
+bool audioEngineTriggerSynth(AudioEngine *engine, const SynthPatch *patch, float frequency, float gain);
+// Times `mark` from `stamp` (platformTimeSeconds) to the hand-off of the next
+// block, the first one to hear anything queued or requested before the call
+bool audioEngineMark(AudioEngine *engine, AudioMark mark, double stamp);
+
+// Audio thread only (e.g. from the block callback): starts a voice `offset`
+// frames into the block about to be mixed.
+void audioEngineStartVoice(AudioEngine *engine, const SampleRef *sample, float rate, float gain, int offset);
+void audioEngineStartSynth(AudioEngine *engine, const SynthPatch *patch, float frequency, float gain, int offset);
+// Audio thread only, from the sequencer: a step starts at `frame` in the
+// block about to be mixed; it is timed when the block reaches the sink
+void audioEngineNoteStep(AudioEngine *engine, int64_t frame, bool restart);
+
+// Histograms in milliseconds, counters and voice use on `out`; safe while
+// running
+void audioEnginePrintStats(AudioEngine *engine, FILE *out);
+// Just the voice pools' use and steals, and the streaming counters if a
+// streamer is set
+void audioEnginePrintVoices(AudioEngine *engine, FILE *out);
+
+// Mixes the next `frames` frames into out.
+// Called by the audio thread; exposed so the mixer can be driven directly.
+void audioEngineRender(AudioEngine *engine, float *out, int frames);
+
+#endif // AUDIO_ENGINE_H
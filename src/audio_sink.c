@@ -0,0 +1,84 @@
+#include "audio_sink.h"
+
+#include <string.h>
+
+#include "platform.h"
+
+typedef AudioSink *(*AudioSinkFactory)(void);
+
+typedef struct
+{
+    const char *name;
+    AudioSinkFactory create;
+} AudioSinkEntry;
+
+// Best first: audioSinkNames()[0] is the default
+static const AudioSinkEntry SINKS[] = {
+#ifdef _WIN32
+    {"winmm", audioSinkCreateWinmm},
+#endif
+#ifdef HAVE_PULSE
+    {"pulse", audioSinkCreatePulse},
+#endif
+#ifdef HAVE_ALSA
+    {"alsa", audioSinkCreateAlsa},
+#endif
+    {"null", audioSinkCreateNull},
+    {"wav", audioSinkCreateWav}};
+
+#define SINK_COUNT (sizeof(SINKS) / sizeof(SINKS[0]))
+
+AudioSink *audioSinkCreateByName(const char *name)
+{
+    for (size_t i = 0; i < SINK_COUNT; i++)
+    {
+        if (strcmp(SINKS[i].name, name) == 0)
+            return SINKS[i].create();
+    }
+    return NULL;
+}
+
+const char *const *audioSinkNames(void)
+{
+    static const char *names[SINK_COUNT + 1];
+    for (size_t i = 0; i < SINK_COUNT; i++)
+        names[i] = SINKS[i].name;
+    return names;
+}
+
+void audioSinkClockStart(AudioSinkClock *clock, const AudioSinkConfig *config)
+{
+    clock->start = 0.0;
+    clock->frames = 0;
+    clock->sampleRate = config->sampleRate;
+    clock->bufferFrames = config->periodFrames * config->periodCount;
+}
+
+bool audioSinkClockWait(AudioSinkClock *clock, int frames)
+{
+    double now = platformTimeSeconds();
+    double written = (double)clock->frames / clock->sampleRate;
+    bool underrun = clock->frames > 0 && now - clock->start > written;
+    if (clock->frames == 0 || underrun)
+        clock->start = now - written; // Playback resumes from what was written
+
+    clock->frames += frames;
+    double due = clock->start + (double)(clock->frames - clock->bufferFrames) / clock->sampleRate;
+    double remaining;
+    while ((remaining = due - platformTimeSeconds()) > 0.0)
+    {
+        // Sleep most of the way, then yield through the last millisecond
+        if (remaining > 0.002)
+            platformSleepMs((int)(remaining * 1000.0) - 1);
+        else
+            platformYield();
+    }
+    return !underrun;
+}
+
+int32_t audioSinkClockQueued(const AudioSinkClock *clock)
+{
+    double played = (platformTimeSeconds() - clock->start) * clock->sampleRate;
+    double queued = (double)clock->frames - played;
+    return queued > 0.0 ? (int32_t)queued : 0;
+}
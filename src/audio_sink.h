@@ -0,0 +1,77 @@
+#ifndef AUDIO_SINK_H
+#define AUDIO_SINK_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Output side of the audio engine. The audio thread renders one mono float
+// block of config.periodFrames at a time and hands it to write(), which
+// blocks until the device has room for it. That back-pressure is what paces
+// the engine in real time; sinks without a device pace themselves with a
+// timer so every backend has the same contract.
+typedef struct AudioSink AudioSink;
+
+typedef struct
+{
+    int sampleRate;
+    int periodFrames;   // Frames per write() and per device period
+    int periodCount;    // Periods buffered ahead of playback
+    const char *device; // Backend specific (ALSA device, Pulse sink, WAV path); NULL for the default
+} AudioSinkConfig;
+
+struct AudioSink
+{
+    const char *name;
+    bool (*open)(AudioSink *sink, const AudioSinkConfig *config);
+    bool (*write)(AudioSink *sink, const float *block, int frames);
+    void (*close)(AudioSink *sink);
+    void (*destroy)(AudioSink *sink);
+    void *impl;
+    int32_t underruns;    // Times the device ran dry; written by the audio thread
+    int32_t queuedFrames; // Still to play when write() last returned, its own included
+};
+
+#ifdef _WIN32
+AudioSink *audioSinkCreateWinmm(void);
+#endif
+#ifdef HAVE_ALSA
+AudioSink *audioSinkCreateAlsa(void);
+#endif
+#ifdef HAVE_PULSE
+AudioSink *audioSinkCreatePulse(void);
+#endif
+// Discards audio at real-time pace
+AudioSink *audioSinkCreateNull(void);
+// Writes a 16-bit WAV file (config.device, default "sink.wav") at real-time pace
+AudioSink *audioSinkCreateWav(void);
+
+// "winmm", "pulse", "alsa", "null" or "wav"; NULL if unknown or not built in
+AudioSink *audioSinkCreateByName(const char *name);
+// Names of the backends built into this binary, best first, NULL terminated
+const char *const *audioSinkNames(void);
+
+static inline void audioSinkDestroy(AudioSink *sink)
+{
+    if (sink)
+        sink->destroy(sink);
+}
+
+// Real-time pacing for sinks without a device: wait() returns once the
+// frames written so far, minus `periodCount` periods of notional buffer,
+// are due. The notional device starts playing at the first wait().
+typedef struct
+{
+    double start;
+    int64_t frames;
+    int sampleRate;
+    int bufferFrames;
+} AudioSinkClock;
+
+void audioSinkClockStart(AudioSinkClock *clock, const AudioSinkConfig *config);
+// Returns false if the writer fell so far behind that the notional device
+// ran dry; the clock then restarts from the current time
+bool audioSinkClockWait(AudioSinkClock *clock, int frames);
+// Frames written that the notional device hasn't played yet
+int32_t audioSinkClockQueued(const AudioSinkClock *clock);
+
+#endif // AUDIO_SINK_H
@@ -0,0 +1,145 @@
+#include "audio_sink.h"
+
+#include <alsa/asoundlib.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "mix_kernels.h"
+
+// Blocking snd_pcm_writei on an S16 mono stream. The hardware ring is
+// periodFrames x periodCount, so write() returns once a period frees up.
+
+typedef struct
+{
+    snd_pcm_t *pcm;
+    int16_t *buffer;
+} AlsaSink;
+
+static void alsaClose(AudioSink *sink);
+
+static bool alsaConfigure(AlsaSink *a, const AudioSinkConfig *config)
+{
+    snd_pcm_hw_params_t *hw;
+    snd_pcm_hw_params_alloca(&hw);
+    unsigned int rate = (unsigned int)config->sampleRate;
+    snd_pcm_uframes_t period = (snd_pcm_uframes_t)config->periodFrames;
+    unsigned int periods = (unsigned int)config->periodCount;
+
+    if (snd_pcm_hw_params_any(a->pcm, hw) < 0 ||
+        snd_pcm_hw_params_set_access(a->pcm, hw, SND_PCM_ACCESS_RW_INTERLEAVED) < 0 ||
+        snd_pcm_hw_params_set_format(a->pcm, hw, SND_PCM_FORMAT_S16_LE) < 0 ||
+        snd_pcm_hw_params_set_channels(a->pcm, hw, 1) < 0 ||
+        snd_pcm_hw_params_set_rate_near(a->pcm, hw, &rate, NULL) < 0)
+        return false;
+    if ((int)rate != config->sampleRate)
+    {
+        fprintf(stderr, "ALSA: device runs at %u Hz, not %d Hz; try the 'default' or a 'plughw' device\n", rate, config->sampleRate);
+        return false;
+    }
+    // The device may round these; we write whatever period it settles on
+    snd_pcm_hw_params_set_period_size_near(a->pcm, hw, &period, NULL);
+    snd_pcm_hw_params_set_periods_near(a->pcm, hw, &periods, NULL);
+    if (snd_pcm_hw_params(a->pcm, hw) < 0)
+        return false;
+
+    snd_pcm_uframes_t bufferFrames;
+    snd_pcm_hw_params_get_period_size(hw, &period, NULL);
+    snd_pcm_hw_params_get_buffer_size(hw, &bufferFrames);
+    if ((int)period != config->periodFrames)
+        fprintf(stderr, "ALSA: period is %lu frames (asked for %d)\n", (unsigned long)period, config->periodFrames);
+
+    snd_pcm_sw_params_t *sw;
+    snd_pcm_sw_params_alloca(&sw);
+    snd_pcm_sw_params_current(a->pcm, sw);
+    // Start once the ring is full so the first periods don't underrun
+    snd_pcm_sw_params_set_start_threshold(a->pcm, sw, bufferFrames);
+    snd_pcm_sw_params_set_avail_min(a->pcm, sw, period);
+    return snd_pcm_sw_params(a->pcm, sw) >= 0;
+}
+
+static bool alsaOpen(AudioSink *sink, const AudioSinkConfig *config)
+{
+    AlsaSink *a = sink->impl;
+    const char *device = config->device ? config->device : "default";
+    int err = snd_pcm_open(&a->pcm, device, SND_PCM_STREAM_PLAYBACK, 0);
+    if (err < 0)
+    {
+        fprintf(stderr, "ALSA: cannot open '%s': %s\n", device, snd_strerror(err));
+        a->pcm = NULL;
+        return false;
+    }
+
+    a->buffer = malloc(sizeof(int16_t) * (size_t)config->periodFrames);
+    if (!a->buffer || !alsaConfigure(a, config))
+    {
+        alsaClose(sink);
+        return false;
+    }
+    return true;
+}
+
+static bool alsaWrite(AudioSink *sink, const float *block, int frames)
+{
+    AlsaSink *a = sink->impl;
+    mixKernels()->toS16(a->buffer, block, frames);
+
+    const int16_t *p = a->buffer;
+    while (frames > 0)
+    {
+        snd_pcm_sframes_t n = snd_pcm_writei(a->pcm, p, (snd_pcm_uframes_t)frames);
+        if (n < 0)
+        {
+            // Underrun (-EPIPE) or suspend: reset the stream and carry on
+            if (n == -EPIPE)
+                sink->underruns++;
+            if (snd_pcm_recover(a->pcm, (int)n, 1) < 0)
+                return false;
+            continue;
+        }
+        p += n;
+        frames -= (int)n;
+    }
+    snd_pcm_sframes_t delay;
+    if (snd_pcm_delay(a->pcm, &delay) == 0)
+        sink->queuedFrames = delay > 0 ? (int32_t)delay : 0;
+    return true;
+}
+
+static void alsaClose(AudioSink *sink)
+{
+    AlsaSink *a = sink->impl;
+    if (a->pcm)
+    {
+        snd_pcm_drop(a->pcm);
+        snd_pcm_close(a->pcm);
+        a->pcm = NULL;
+    }
+    free(a->buffer);
+    a->buffer = NULL;
+}
+
+static void alsaDestroy(AudioSink *sink)
+{
+    free(sink->impl);
+    free(sink);
+}
+
+AudioSink *audioSinkCreateAlsa(void)
+{
+    AudioSink *sink = calloc(1, sizeof(AudioSink));
+    AlsaSink *a = calloc(1, sizeof(AlsaSink));
+    if (!sink || !a)
+    {
+        free(sink);
+        free(a);
+        return NULL;
+    }
+    sink->name = "alsa";
+    sink->open = alsaOpen;
+    sink->write = alsaWrite;
+    sink->close = alsaClose;
+    sink->destroy = alsaDestroy;
+    sink->impl = a;
+    return sink;
+}
@@ -0,0 +1,51 @@
+#include "audio_sink.h"
+
+#include <stdlib.h>
+
+// Drops every block but still paces the audio thread like a device would,
+// so the engine can run on hosts without audio hardware.
+
+static bool nullOpen(AudioSink *sink, const AudioSinkConfig *config)
+{
+    audioSinkClockStart(sink->impl, config);
+    return true;
+}
+
+static bool nullWrite(AudioSink *sink, const float *block, int frames)
+{
+    (void)block;
+    if (!audioSinkClockWait(sink->impl, frames))
+        sink->underruns++;
+    sink->queuedFrames = audioSinkClockQueued(sink->impl);
+    return true;
+}
+
+static void nullClose(AudioSink *sink)
+{
+    (void)sink;
+}
+
+static void nullDestroy(AudioSink *sink)
+{
+    free(sink->impl);
+    free(sink);
+}
+
+AudioSink *audioSinkCreateNull(void)
+{
+    AudioSink *sink = calloc(1, sizeof(AudioSink));
+    AudioSinkClock *clock = calloc(1, sizeof(AudioSinkClock));
+    if (!sink || !clock)
+    {
+        free(sink);
+        free(clock);
+        return NULL;
+    }
+    sink->name = "null";
+    sink->open = nullOpen;
+    sink->write = nullWrite;
+    sink->close = nullClose;
+    sink->destroy = nullDestroy;
+    sink->impl = clock;
+    return sink;
+}
@@ -0,0 +1,137 @@
+#include "audio_sink.h"
+
+#include <math.h>
+#include <pulse/error.h>
+#include <pulse/simple.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "mix_kernels.h"
+#include "platform.h"
+
+// pa_simple playback stream; PipeWire serves the same API through
+// pipewire-pulse. The server-side buffer is sized to periodCount periods so
+// pa_simple_write blocks once that much audio is queued.
+//
+// pa_simple reports no underflows, and its latency includes the device's,
+// so an empty queue can't be read off it. Instead the sink tracks how much
+// it has queued: each write adds its frames, up to the buffer size (a write
+// that would overfill it blocks until there is room), and playback drains
+// it at the sample rate in between. A queue that drained below zero ran dry.
+// The estimate resyncs whenever a write blocks, so clock drift between the
+// host and the device doesn't accumulate.
+
+typedef struct
+{
+    pa_simple *stream;
+    int16_t *buffer;
+    int sampleRate;
+    double bufferFrames;
+    double queued;    // Frames estimated to be waiting when the last write returned
+    double lastWrite; // When it returned
+    bool playing;     // Server has started draining the queue
+} PulseSink;
+
+static void pulseClose(AudioSink *sink);
+
+static bool pulseOpen(AudioSink *sink, const AudioSinkConfig *config)
+{
+    PulseSink *p = sink->impl;
+
+    pa_sample_spec spec = {PA_SAMPLE_S16LE, (uint32_t)config->sampleRate, 1};
+    uint32_t periodBytes = (uint32_t)config->periodFrames * sizeof(int16_t);
+    pa_buffer_attr attr;
+    attr.maxlength = (uint32_t)-1;
+    attr.tlength = periodBytes * (uint32_t)config->periodCount;
+    attr.prebuf = (uint32_t)-1;
+    attr.minreq = periodBytes;
+    attr.fragsize = (uint32_t)-1;
+
+    p->sampleRate = config->sampleRate;
+    p->bufferFrames = (double)config->periodFrames * config->periodCount;
+    p->queued = 0.0;
+    p->playing = false;
+
+    int err = 0;
+    p->stream = pa_simple_new(NULL, "lsdvis", PA_STREAM_PLAYBACK, config->device, "sequencer", &spec, NULL, &attr, &err);
+    if (!p->stream)
+    {
+        fprintf(stderr, "PulseAudio: %s\n", pa_strerror(err));
+        return false;
+    }
+    p->buffer = malloc(sizeof(int16_t) * (size_t)config->periodFrames);
+    if (!p->buffer)
+    {
+        pulseClose(sink);
+        return false;
+    }
+    return true;
+}
+
+static bool pulseWrite(AudioSink *sink, const float *block, int frames)
+{
+    PulseSink *p = sink->impl;
+    mixKernels()->toS16(p->buffer, block, frames);
+    if (p->playing)
+    {
+        p->queued -= (platformTimeSeconds() - p->lastWrite) * p->sampleRate;
+        if (p->queued < 0.0)
+        {
+            // The server stops and waits for a full buffer again
+            sink->underruns++;
+            p->queued = 0.0;
+            p->playing = false;
+        }
+    }
+    int err = 0;
+    if (pa_simple_write(p->stream, p->buffer, sizeof(int16_t) * (size_t)frames, &err) < 0)
+    {
+        fprintf(stderr, "PulseAudio: %s\n", pa_strerror(err));
+        return false;
+    }
+    p->queued = fmin(p->queued + frames, p->bufferFrames);
+    // Playback starts once the server has a full buffer (the default prebuf)
+    if (p->queued >= p->bufferFrames)
+        p->playing = true;
+    p->lastWrite = platformTimeSeconds();
+    sink->queuedFrames = (int32_t)p->queued;
+    return true;
+}
+
+static void pulseClose(AudioSink *sink)
+{
+    PulseSink *p = sink->impl;
+    if (p->stream)
+    {
+        pa_simple_flush(p->stream, NULL);
+        pa_simple_free(p->stream);
+        p->stream = NULL;
+    }
+    free(p->buffer);
+    p->buffer = NULL;
+}
+
+static void pulseDestroy(AudioSink *sink)
+{
+    free(sink->impl);
+    free(sink);
+}
+
+AudioSink *audioSinkCreatePulse(void)
+{
+    AudioSink *sink = calloc(1, sizeof(AudioSink));
+    PulseSink *p = calloc(1, sizeof(PulseSink));
+    if (!sink || !p)
+    {
+        free(sink);
+        free(p);
+        return NULL;
+    }
+    sink->name = "pulse";
+    sink->open = pulseOpen;
+    sink->write = pulseWrite;
+    sink->close = pulseClose;
+    sink->destroy = pulseDestroy;
+    sink->impl = p;
+    return sink;
+}
@@ -0,0 +1,65 @@
+#include "audio_sink.h"
+
+#include <stdlib.h>
+
+#include "wav.h"
+
+// Records the live output to a WAV file, paced by a timer instead of a
+// device, so a headless run hears exactly what the speakers would.
+
+typedef struct
+{
+    AudioSinkClock clock;
+    WavWriter writer;
+} WavSink;
+
+static bool wavSinkOpen(AudioSink *sink, const AudioSinkConfig *config)
+{
+    WavSink *w = sink->impl;
+    if (!wavWriterOpen(&w->writer, config->device ? config->device : "sink.wav", config->sampleRate))
+        return false;
+    audioSinkClockStart(&w->clock, config);
+    return true;
+}
+
+static bool wavSinkWrite(AudioSink *sink, const float *block, int frames)
+{
+    WavSink *w = sink->impl;
+    if (!wavWriterWrite(&w->writer, block, frames))
+        return false;
+    if (!audioSinkClockWait(&w->clock, frames))
+        sink->underruns++;
+    sink->queuedFrames = audioSinkClockQueued(&w->clock);
+    return true;
+}
+
+static void wavSinkClose(AudioSink *sink)
+{
+    WavSink *w = sink->impl;
+    wavWriterClose(&w->writer);
+}
+
+static void wavSinkDestroy(AudioSink *sink)
+{
+    free(sink->impl);
+    free(sink);
+}
+
+AudioSink *audioSinkCreateWav(void)
+{
+    AudioSink *sink = calloc(1, sizeof(AudioSink));
+    WavSink *w = calloc(1, sizeof(WavSink));
+    if (!sink || !w)
+    {
+        free(sink);
+        free(w);
+        return NULL;
+    }
+    sink->name = "wav";
+    sink->open = wavSinkOpen;
+    sink->write = wavSinkWrite;
+    sink->close = wavSinkClose;
+    sink->destroy = wavSinkDestroy;
+    sink->impl = w;
+    return sink;
+}
@@ -0,0 +1,154 @@
+#include "audio_sink.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <windows.h>
+#include <mmsystem.h>
+
+#include "mix_kernels.h"
+
+// waveOut ring of periodCount small buffers; write() waits on the driver's
+// done event until the next header in the ring has been played back.
+#define WINMM_MAX_BUFFERS 16
+
+typedef struct
+{
+    HWAVEOUT device;
+    HANDLE doneEvent;
+    WAVEHDR headers[WINMM_MAX_BUFFERS];
+    int16_t *buffers[WINMM_MAX_BUFFERS];
+    int bufferCount;
+    int next;
+    int64_t queued; // Buffers written since open
+} WinmmSink;
+
+static void winmmClose(AudioSink *sink);
+
+static bool winmmOpen(AudioSink *sink, const AudioSinkConfig *config)
+{
+    WinmmSink *w = sink->impl;
+
+    WAVEFORMATEX format = {0};
+    format.wFormatTag = WAVE_FORMAT_PCM;
+    format.nChannels = 1;
+    format.nSamplesPerSec = (DWORD)config->sampleRate;
+    format.wBitsPerSample = 16;
+    format.nBlockAlign = 2;
+    format.nAvgBytesPerSec = (DWORD)config->sampleRate * format.nBlockAlign;
+
+    w->doneEvent = CreateEvent(NULL, FALSE, FALSE, NULL);
+    if (!w->doneEvent)
+        return false;
+    if (waveOutOpen(&w->device, WAVE_MAPPER, &format, (DWORD_PTR)w->doneEvent, 0, CALLBACK_EVENT) != MMSYSERR_NOERROR)
+    {
+        CloseHandle(w->doneEvent);
+        w->doneEvent = NULL;
+        w->device = NULL;
+        return false;
+    }
+
+    w->bufferCount = config->periodCount < 2 ? 2 : config->periodCount > WINMM_MAX_BUFFERS ? WINMM_MAX_BUFFERS : config->periodCount;
+    w->next = 0;
+    w->queued = 0;
+    for (int i = 0; i < w->bufferCount; i++)
+    {
+        w->buffers[i] = calloc((size_t)config->periodFrames, sizeof(int16_t));
+        if (!w->buffers[i])
+        {
+            winmmClose(sink);
+            return false;
+        }
+        WAVEHDR *hdr = &w->headers[i];
+        ZeroMemory(hdr, sizeof(*hdr));
+        hdr->lpData = (LPSTR)w->buffers[i];
+        hdr->dwBufferLength = (DWORD)config->periodFrames * sizeof(int16_t);
+        waveOutPrepareHeader(w->device, hdr, sizeof(*hdr));
+        hdr->dwFlags |= WHDR_DONE; // Free until first queued
+    }
+    return true;
+}
+
+static bool winmmWrite(AudioSink *sink, const float *block, int frames)
+{
+    WinmmSink *w = sink->impl;
+    WAVEHDR *hdr = &w->headers[w->next];
+
+    while (!(hdr->dwFlags & WHDR_DONE))
+        WaitForSingleObject(w->doneEvent, INFINITE);
+
+    // The newest queued buffer already played out: the device went idle
+    const WAVEHDR *newest = &w->headers[(w->next + w->bufferCount - 1) % w->bufferCount];
+    if (w->queued >= w->bufferCount && (newest->dwFlags & WHDR_DONE))
+        sink->underruns++;
+
+    mixKernels()->toS16(w->buffers[w->next], block, frames);
+
+    hdr->dwBufferLength = (DWORD)frames * sizeof(int16_t);
+    hdr->dwFlags &= ~WHDR_DONE;
+    if (waveOutWrite(w->device, hdr, sizeof(*hdr)) != MMSYSERR_NOERROR)
+        return false;
+
+    w->next = (w->next + 1) % w->bufferCount;
+    w->queued++;
+
+    // Whole buffers still with the driver; the one playing counts in full
+    int32_t pending = 0;
+    for (int i = 0; i < w->bufferCount; i++)
+    {
+        if (!(w->headers[i].dwFlags & WHDR_DONE))
+            pending += (int32_t)(w->headers[i].dwBufferLength / sizeof(int16_t));
+    }
+    sink->queuedFrames = pending;
+    return true;
+}
+
+static void winmmClose(AudioSink *sink)
+{
+    WinmmSink *w = sink->impl;
+    if (w->device)
+    {
+        waveOutReset(w->device);
+        for (int i = 0; i < WINMM_MAX_BUFFERS; i++)
+        {
+            if (w->buffers[i])
+                waveOutUnprepareHeader(w->device, &w->headers[i], sizeof(WAVEHDR));
+        }
+        waveOutClose(w->device);
+        w->device = NULL;
+    }
+    for (int i = 0; i < WINMM_MAX_BUFFERS; i++)
+    {
+        free(w->buffers[i]);
+        w->buffers[i] = NULL;
+    }
+    if (w->doneEvent)
+    {
+        CloseHandle(w->doneEvent);
+        w->doneEvent = NULL;
+    }
+}
+
+static void winmmDestroy(AudioSink *sink)
+{
+    free(sink->impl);
+    free(sink);
+}
+
+AudioSink *audioSinkCreateWinmm(void)
+{
+    AudioSink *sink = calloc(1, sizeof(AudioSink));
+    WinmmSink *w = calloc(1, sizeof(WinmmSink));
+    if (!sink || !w)
+    {
+        free(sink);
+        free(w);
+        return NULL;
+    }
+    sink->name = "winmm";
+    sink->open = winmmOpen;
+    sink->write = winmmWrite;
+    sink->close = winmmClose;
+    sink->destroy = winmmDestroy;
+    sink->impl = w;
+    return sink;
+}
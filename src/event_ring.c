@@ -0,0 +1,105 @@
+#include "event_ring.h"
+
+#include <string.h>
+
+static size_t regionSize(int capacity)
+{
+    return sizeof(EventRingHeader) + sizeof(RingEvent) * (size_t)capacity;
+}
+
+static void attach(EventRing *ring, PlatformSharedMemory *shm)
+{
+    ring->shm = shm;
+    ring->header = platformSharedMemoryData(shm);
+    ring->events = (RingEvent *)(ring->header + 1);
+}
+
+bool eventRingCreate(EventRing *ring, const char *name, int capacity, int sampleRate)
+{
+    memset(ring, 0, sizeof(*ring));
+    if (capacity <= 0 || (capacity & (capacity - 1)) != 0)
+        return false;
+    PlatformSharedMemory *shm = platformSharedMemoryCreate(name, regionSize(capacity));
+    if (!shm)
+        return false;
+    attach(ring, shm);
+
+    EventRingHeader *header = ring->header;
+    header->version = EVENT_RING_VERSION;
+    header->capacity = (uint32_t)capacity;
+    header->eventSize = sizeof(RingEvent);
+    header->sampleRate = sampleRate;
+    // Published last: a consumer that sees the magic sees a complete header
+    atomicStore32((volatile int32_t *)&header->magic, (int32_t)EVENT_RING_MAGIC);
+    return true;
+}
+
+bool eventRingOpen(EventRing *ring, const char *name)
+{
+    memset(ring, 0, sizeof(*ring));
+    PlatformSharedMemory *shm = platformSharedMemoryOpen(name, sizeof(EventRingHeader));
+    if (!shm)
+        return false;
+    const EventRingHeader *header = platformSharedMemoryData(shm);
+    if (platformSharedMemorySize(shm) < sizeof(EventRingHeader) ||
+        (uint32_t)atomicLoad32((volatile int32_t *)&header->magic) != EVENT_RING_MAGIC ||
+        header->version != EVENT_RING_VERSION || header->eventSize != sizeof(RingEvent))
+    {
+        platformSharedMemoryClose(shm);
+        return false;
+    }
+
+    // Remap at full size now that the capacity is known
+    size_t size = regionSize((int)header->capacity);
+    if (platformSharedMemorySize(shm) < size)
+    {
+        platformSharedMemoryClose(shm);
+        shm = platformSharedMemoryOpen(name, size);
+        if (!shm)
+            return false;
+    }
+    attach(ring, shm);
+    return true;
+}
+
+void eventRingClose(EventRing *ring)
+{
+    platformSharedMemoryClose(ring->shm);
+    memset(ring, 0, sizeof(*ring));
+}
+
+bool eventRingPush(EventRing *ring, RingEvent *event)
+{
+    EventRingHeader *header = ring->header;
+    int32_t write = header->writeIndex; // Only this side writes it
+    int32_t read = atomicLoad32(&header->readIndex);
+    if ((uint32_t)(write - read) >= header->capacity)
+        return false;
+
+    event->sequence = ring->nextSequence++;
+    ring->events[(uint32_t)write & (header->capacity - 1)] = *event;
+    atomicStore32(&header->writeIndex, write + 1);
+    return true;
+}
+
+bool eventRingPop(EventRing *ring, RingEvent *event)
+{
+    EventRingHeader *header = ring->header;
+    int32_t read = header->readIndex; // Only this side writes it
+    if (read == atomicLoad32(&header->writeIndex))
+        return false;
+
+    *event = ring->events[(uint32_t)read & (header->capacity - 1)];
+    atomicStore32(&header->readIndex, read + 1);
+    return true;
+}
+
+int64_t eventRingConsumerFrame(EventRing *ring)
+{
+    return atomicLoad64(&ring->header->consumerFrame);
+}
+
+void eventRingSetConsumerFrame(EventRing *ring, int64_t frame)
+{
+    atomicStore64(&ring->header->consumerFrame, frame);
+}
@@ -0,0 +1,85 @@
+#ifndef EVENT_RING_H
+#define EVENT_RING_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "platform.h"
+
+// Binary note events from the sequencer (single producer) to
+// sound_server.py (single consumer) through a ring in shared memory.
+// Events are stamped with the consumer's sample clock, which the consumer
+// publishes in the header, so the producer can schedule ahead and the
+// consumer can start every note on its exact frame. The layout is fixed
+// little-endian and mirrored by sound_server.py; bump EVENT_RING_VERSION on
+// any change.
+
+#define EVENT_RING_MAGIC 0x5244534Cu // "LSDR"
+#define EVENT_RING_VERSION 1
+#define EVENT_RING_DEFAULT_NAME "/lsdvis_events"
+#define EVENT_RING_DEFAULT_CAPACITY 4096 // Must be a power of two
+
+typedef enum
+{
+    RING_EVENT_NOTE_ON = 1,
+    RING_EVENT_NOTE_OFF = 2,
+    RING_EVENT_ALL_OFF = 3
+} RingEventType;
+
+typedef struct
+{
+    int64_t frame;     // Consumer sample frame the event takes effect on
+    float frequency;   // Hz; identifies the note for NOTE_OFF
+    int32_t length;    // NOTE_ON: frames until an implied NOTE_OFF, 0 = held
+    uint8_t type;      // RingEventType
+    uint8_t instrument;
+    uint8_t velocity;  // 0-127
+    uint8_t reserved;
+    uint32_t sequence; // Increments per event, for loss checks
+} RingEvent;
+
+_Static_assert(sizeof(RingEvent) == 24, "RingEvent is part of the shared layout");
+
+// Each index lives on its own cache line so the two sides never share one
+typedef struct
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t capacity;
+    uint32_t eventSize;
+    int32_t sampleRate;
+    uint8_t reserved0[44];
+    volatile int32_t writeIndex; // Producer only; grows, masked on access
+    uint8_t reserved1[60];
+    volatile int32_t readIndex; // Consumer only
+    uint8_t reserved2[60];
+    volatile int64_t consumerFrame; // Next frame the consumer will render
+    uint8_t reserved3[56];
+} EventRingHeader;
+
+_Static_assert(sizeof(EventRingHeader) == 256, "EventRingHeader is part of the shared layout");
+
+typedef struct
+{
+    PlatformSharedMemory *shm;
+    EventRingHeader *header;
+    RingEvent *events;
+    uint32_t nextSequence;
+} EventRing;
+
+// Producer: creates the region and its name; closing removes the name
+bool eventRingCreate(EventRing *ring, const char *name, int capacity, int sampleRate);
+// Consumer: maps an existing region, checking magic and version
+bool eventRingOpen(EventRing *ring, const char *name);
+void eventRingClose(EventRing *ring);
+
+// Producer. Fills in the sequence number; false if the ring is full.
+bool eventRingPush(EventRing *ring, RingEvent *event);
+// Consumer. False if the ring is empty.
+bool eventRingPop(EventRing *ring, RingEvent *event);
+
+int64_t eventRingConsumerFrame(EventRing *ring);
+void eventRingSetConsumerFrame(EventRing *ring, int64_t frame);
+
+#endif // EVENT_RING_H
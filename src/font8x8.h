@@ -0,0 +1,13 @@
+#ifndef FONT8X8_H
+#define FONT8X8_H
+
+// 8x8 bitmap glyphs for printable ASCII, compiled into the binary so the
+// UI needs no font files
+
+#define FONT_FIRST_CHAR 32
+#define FONT_GLYPH_COUNT 95 // ' ' through '~'
+#define FONT_GLYPH_SIZE 8   // Pixels per side
+
+extern const unsigned char FONT8X8[FONT_GLYPH_COUNT][FONT_GLYPH_SIZE];
+
+#endif // FONT8X8_H
@@ -0,0 +1,115 @@
+#include "frame_scheduler.h"
+
+#include <GLFW/glfw3.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+void frameSchedulerInit(FrameScheduler *scheduler, double maxFps)
+{
+    memset(scheduler, 0, sizeof(*scheduler));
+    scheduler->maxFps = maxFps;
+    scheduler->redrawRequested = true; // First frame
+    scheduler->startTime = glfwGetTime();
+    scheduler->lastFrameStart = -1.0;
+}
+
+void frameSchedulerRequestRedraw(FrameScheduler *scheduler)
+{
+    scheduler->redrawRequested = true;
+}
+
+void frameSchedulerRedrawAt(FrameScheduler *scheduler, double time)
+{
+    if (scheduler->deadline == 0.0 || time < scheduler->deadline)
+        scheduler->deadline = time;
+}
+
+static double earliestFrameTime(const FrameScheduler *scheduler)
+{
+    if (scheduler->maxFps <= 0.0 || scheduler->lastFrameStart < 0.0)
+        return 0.0;
+    return scheduler->lastFrameStart + 1.0 / scheduler->maxFps;
+}
+
+bool frameSchedulerWait(FrameScheduler *scheduler)
+{
+    double now = glfwGetTime();
+    double wakeAt;
+    if (scheduler->redrawRequested)
+    {
+        wakeAt = earliestFrameTime(scheduler);
+    }
+    else if (scheduler->deadline > 0.0)
+    {
+        double capped = earliestFrameTime(scheduler);
+        wakeAt = scheduler->deadline > capped ? scheduler->deadline : capped;
+    }
+    else
+    {
+        // Nothing scheduled: sleep until the OS has an event for us
+        glfwWaitEvents();
+        scheduler->wakeups++;
+        return scheduler->redrawRequested && glfwGetTime() >= earliestFrameTime(scheduler);
+    }
+
+    if (wakeAt > now)
+        glfwWaitEventsTimeout(wakeAt - now);
+    else
+        glfwPollEvents();
+    scheduler->wakeups++;
+
+    now = glfwGetTime();
+    if (scheduler->deadline > 0.0 && now >= scheduler->deadline)
+    {
+        scheduler->deadline = 0.0;
+        scheduler->redrawRequested = true;
+    }
+    return scheduler->redrawRequested && now >= earliestFrameTime(scheduler);
+}
+
+void frameSchedulerBeginFrame(FrameScheduler *scheduler)
+{
+    scheduler->frameStart = glfwGetTime();
+    scheduler->lastFrameStart = scheduler->frameStart;
+    scheduler->redrawRequested = false;
+}
+
+void frameSchedulerEndFrame(FrameScheduler *scheduler)
+{
+    double seconds = glfwGetTime() - scheduler->frameStart;
+    scheduler->recentFrameSeconds[scheduler->frames % FRAME_STATS_WINDOW] = seconds;
+    scheduler->frames++;
+    scheduler->totalFrameSeconds += seconds;
+    if (seconds > scheduler->maxFrameSeconds)
+        scheduler->maxFrameSeconds = seconds;
+}
+
+static int compareDoubles(const void *a, const void *b)
+{
+    double x = *(const double *)a;
+    double y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+void frameSchedulerPrintStats(const FrameScheduler *scheduler)
+{
+    if (scheduler->frames == 0)
+        return;
+
+    int count = scheduler->frames < FRAME_STATS_WINDOW ? (int)scheduler->frames : FRAME_STATS_WINDOW;
+    double sorted[FRAME_STATS_WINDOW];
+    memcpy(sorted, scheduler->recentFrameSeconds, sizeof(double) * (size_t)count);
+    qsort(sorted, (size_t)count, sizeof(double), compareDoubles);
+
+    double elapsed = glfwGetTime() - scheduler->startTime;
+    printf("Frames: %llu in %.1f s (%.1f fps avg), %llu wakeups; frame time mean %.2f ms, "
+           "p50 %.2f ms, p99 %.2f ms, max %.2f ms\n",
+           (unsigned long long)scheduler->frames, elapsed,
+           elapsed > 0.0 ? scheduler->frames / elapsed : 0.0,
+           (unsigned long long)scheduler->wakeups,
+           scheduler->totalFrameSeconds / scheduler->frames * 1000.0,
+           sorted[count / 2] * 1000.0,
+           sorted[(count * 99) / 100] * 1000.0,
+           scheduler->maxFrameSeconds * 1000.0);
+}
@@ -0,0 +1,47 @@
+#ifndef FRAME_SCHEDULER_H
+#define FRAME_SCHEDULER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Decides when the main loop redraws. Between frames the thread sleeps in
+// glfwWaitEvents/glfwWaitEventsTimeout until input arrives, an animation
+// deadline passes, or the frame cap allows the next pending redraw.
+
+#define FRAME_STATS_WINDOW 256 // Recent frames kept for percentiles
+
+typedef struct
+{
+    double maxFps; // 0 = uncapped
+    bool redrawRequested;
+    double deadline; // Next animation deadline, 0 = none
+    double lastFrameStart;
+
+    // Statistics
+    uint64_t frames;
+    uint64_t wakeups;
+    double totalFrameSeconds;
+    double maxFrameSeconds;
+    double recentFrameSeconds[FRAME_STATS_WINDOW];
+    double frameStart;
+    double startTime;
+} FrameScheduler;
+
+void frameSchedulerInit(FrameScheduler *scheduler, double maxFps);
+
+// Input, resize, expose, playhead moves: draw as soon as the cap allows
+void frameSchedulerRequestRedraw(FrameScheduler *scheduler);
+// Keeps time-based animation running: redraw no later than `time`
+void frameSchedulerRedrawAt(FrameScheduler *scheduler, double time);
+
+// Sleeps processing events until a frame is due; returns false if it woke
+// for an event that did not ask for a redraw
+bool frameSchedulerWait(FrameScheduler *scheduler);
+
+void frameSchedulerBeginFrame(FrameScheduler *scheduler);
+void frameSchedulerEndFrame(FrameScheduler *scheduler);
+
+// One-line summary: frames, wakeups, mean/p50/p99/max frame time
+void frameSchedulerPrintStats(const FrameScheduler *scheduler);
+
+#endif // FRAME_SCHEDULER_H
@@ -0,0 +1,182 @@
+#include "gl_loader.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define GL_LOADER_DEFINE(ret, name, args) GlLoader##name##Fn glLoader##name;
+GL_LOADER_FUNCTIONS(GL_LOADER_DEFINE)
+#undef GL_LOADER_DEFINE
+
+void glLoaderContextHints(void)
+{
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+#ifdef __APPLE__
+    // macOS only creates core contexts that are forward compatible
+    glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GLFW_TRUE);
+#endif
+}
+
+bool glLoaderInit(void)
+{
+#define GL_LOADER_RESOLVE(ret, name, args)                                     \
+    glLoader##name = (GlLoader##name##Fn)glfwGetProcAddress("gl" #name);       \
+    if (!glLoader##name)                                                       \
+    {                                                                          \
+        fprintf(stderr, "OpenGL 3.3 entry point gl%s is unavailable\n", #name); \
+        return false;                                                          \
+    }
+    GL_LOADER_FUNCTIONS(GL_LOADER_RESOLVE)
+#undef GL_LOADER_RESOLVE
+    return true;
+}
+
+static char *readFile(const char *path)
+{
+    FILE *file = fopen(path, "rb");
+    if (!file)
+        return NULL;
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    char *text = size >= 0 ? malloc((size_t)size + 1) : NULL;
+    if (text)
+    {
+        size_t got = fread(text, 1, (size_t)size, file);
+        text[got] = '\0';
+    }
+    fclose(file);
+    return text;
+}
+
+static GLuint compileShader(GLenum type, const char *path)
+{
+    char *source = readFile(path);
+    if (!source)
+    {
+        fprintf(stderr, "Failed to read shader %s\n", path);
+        return 0;
+    }
+
+    GLuint shader = glCreateShader(type);
+    const GLchar *sources[] = {source};
+    glShaderSource(shader, 1, sources, NULL);
+    glCompileShader(shader);
+    free(source);
+
+    GLint ok = GL_FALSE;
+    glGetShaderiv(shader, GL_COMPILE_STATUS, &ok);
+    if (!ok)
+    {
+        char log[1024];
+        glGetShaderInfoLog(shader, sizeof(log), NULL, log);
+        fprintf(stderr, "Failed to compile %s:\n%s\n", path, log);
+        glDeleteShader(shader);
+        return 0;
+    }
+    return shader;
+}
+
+GLuint glLoaderBuildProgram(const char *vertexPath, const char *fragmentPath)
+{
+    GLuint vertex = compileShader(GL_VERTEX_SHADER, vertexPath);
+    GLuint fragment = vertex ? compileShader(GL_FRAGMENT_SHADER, fragmentPath) : 0;
+    if (!fragment)
+    {
+        if (vertex)
+            glDeleteShader(vertex);
+        return 0;
+    }
+
+    GLuint program = glCreateProgram();
+    glAttachShader(program, vertex);
+    glAttachShader(program, fragment);
+    glLinkProgram(program);
+    glDeleteShader(vertex);
+    glDeleteShader(fragment);
+
+    GLint ok = GL_FALSE;
+    glGetProgramiv(program, GL_LINK_STATUS, &ok);
+    if (!ok)
+    {
+        char log[1024];
+        glGetProgramInfoLog(program, sizeof(log), NULL, log);
+        fprintf(stderr, "Failed to link %s + %s:\n%s\n", vertexPath, fragmentPath, log);
+        glDeleteProgram(program);
+        return 0;
+    }
+    return program;
+}
+
+// Unit quad as a triangle strip: aPos (xyz), aTexCoord (uv)
+static const float QUAD_VERTICES[] = {
+    0.0f, 0.0f, 0.0f, 0.0f, 0.0f,
+    1.0f, 0.0f, 0.0f, 1.0f, 0.0f,
+    0.0f, 1.0f, 0.0f, 0.0f, 1.0f,
+    1.0f, 1.0f, 0.0f, 1.0f, 1.0f};
+
+GLuint glLoaderCreateQuadVbo(void)
+{
+    GLuint vbo;
+    glGenBuffers(1, &vbo);
+    glBindBuffer(GL_ARRAY_BUFFER, vbo);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(QUAD_VERTICES), QUAD_VERTICES, GL_STATIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    return vbo;
+}
+
+GLuint glLoaderCreateInstancedVao(GLuint quadVbo, GLuint instanceVbo, size_t instanceBytes,
+                                  const GlLoaderInstanceAttrib *attribs, int attribCount)
+{
+    GLuint vao;
+    glGenVertexArrays(1, &vao);
+    glBindVertexArray(vao);
+
+    glBindBuffer(GL_ARRAY_BUFFER, quadVbo);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void *)0);
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void *)(3 * sizeof(float)));
+
+    glBindBuffer(GL_ARRAY_BUFFER, instanceVbo);
+    for (int i = 0; i < attribCount; i++)
+    {
+        GLuint location = 2 + (GLuint)i;
+        glEnableVertexAttribArray(location);
+        glVertexAttribPointer(location, attribs[i].components, GL_FLOAT, GL_FALSE, (GLsizei)instanceBytes,
+                              (void *)attribs[i].offset);
+        glVertexAttribDivisor(location, 1);
+    }
+
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    return vao;
+}
+
+void glLoaderUploadInstances(GLuint vbo, size_t *vboBytes, const void *data, size_t bytes)
+{
+    glBindBuffer(GL_ARRAY_BUFFER, vbo);
+    if (bytes > *vboBytes)
+    {
+        glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr)bytes, data, GL_DYNAMIC_DRAW);
+        *vboBytes = bytes;
+    }
+    else if (bytes > 0)
+    {
+        glBufferSubData(GL_ARRAY_BUFFER, 0, (GLsizeiptr)bytes, data);
+    }
+}
+
+void glLoaderPixelProjection(float transform[16], int fbWidth, int fbHeight)
+{
+    float w = (float)fbWidth;
+    float h = (float)fbHeight;
+    const float ortho[16] = {
+        2.0f / w, 0.0f, 0.0f, 0.0f,
+        0.0f, -2.0f / h, 0.0f, 0.0f,
+        0.0f, 0.0f, -1.0f, 0.0f,
+        -1.0f, 1.0f, 0.0f, 1.0f};
+    memcpy(transform, ortho, sizeof(ortho));
+}
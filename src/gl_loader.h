@@ -0,0 +1,145 @@
+#ifndef GL_LOADER_H
+#define GL_LOADER_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <GLFW/glfw3.h>
+
+// The handful of GL 3.3 entry points the renderers need, resolved through
+// glfwGetProcAddress so no loader library is required. Call glLoaderInit()
+// once after the context is made current.
+
+#ifdef _WIN32
+#define GL_LOADER_APIENTRY __stdcall
+#else
+#define GL_LOADER_APIENTRY
+#endif
+
+#ifndef GL_VERSION_1_5
+typedef ptrdiff_t GLsizeiptr;
+typedef ptrdiff_t GLintptr;
+#endif
+#ifndef GL_VERSION_2_0
+typedef char GLchar;
+#endif
+
+#ifndef GL_ARRAY_BUFFER
+#define GL_ARRAY_BUFFER 0x8892
+#define GL_STATIC_DRAW 0x88E4
+#define GL_DYNAMIC_DRAW 0x88E8
+#endif
+#ifndef GL_FRAGMENT_SHADER
+#define GL_FRAGMENT_SHADER 0x8B30
+#define GL_VERTEX_SHADER 0x8B31
+#define GL_COMPILE_STATUS 0x8B81
+#define GL_LINK_STATUS 0x8B82
+#define GL_INFO_LOG_LENGTH 0x8B84
+#endif
+#ifndef GL_CLAMP_TO_EDGE
+#define GL_CLAMP_TO_EDGE 0x812F
+#endif
+#ifndef GL_R8
+#define GL_R8 0x8229
+#endif
+
+#define GL_LOADER_FUNCTIONS(X)                                                                   \
+    X(void, GenVertexArrays, (GLsizei n, GLuint *arrays))                                         \
+    X(void, BindVertexArray, (GLuint array))                                                      \
+    X(void, DeleteVertexArrays, (GLsizei n, const GLuint *arrays))                                \
+    X(void, GenBuffers, (GLsizei n, GLuint *buffers))                                             \
+    X(void, BindBuffer, (GLenum target, GLuint buffer))                                           \
+    X(void, BufferData, (GLenum target, GLsizeiptr size, const void *data, GLenum usage))         \
+    X(void, BufferSubData, (GLenum target, GLintptr offset, GLsizeiptr size, const void *data))   \
+    X(void, DeleteBuffers, (GLsizei n, const GLuint *buffers))                                    \
+    X(void, EnableVertexAttribArray, (GLuint index))                                              \
+    X(void, VertexAttribPointer, (GLuint index, GLint size, GLenum type, GLboolean normalized,    \
+                                  GLsizei stride, const void *pointer))                           \
+    X(void, VertexAttribDivisor, (GLuint index, GLuint divisor))                                  \
+    X(void, DrawArraysInstanced, (GLenum mode, GLint first, GLsizei count, GLsizei instances))    \
+    X(GLuint, CreateShader, (GLenum type))                                                        \
+    X(void, ShaderSource, (GLuint shader, GLsizei count, const GLchar *const *string,             \
+                           const GLint *length))                                                  \
+    X(void, CompileShader, (GLuint shader))                                                       \
+    X(void, GetShaderiv, (GLuint shader, GLenum pname, GLint *params))                            \
+    X(void, GetShaderInfoLog, (GLuint shader, GLsizei size, GLsizei *length, GLchar *log))        \
+    X(void, DeleteShader, (GLuint shader))                                                        \
+    X(GLuint, CreateProgram, (void))                                                              \
+    X(void, AttachShader, (GLuint program, GLuint shader))                                        \
+    X(void, LinkProgram, (GLuint program))                                                        \
+    X(void, GetProgramiv, (GLuint program, GLenum pname, GLint *params))                          \
+    X(void, GetProgramInfoLog, (GLuint program, GLsizei size, GLsizei *length, GLchar *log))      \
+    X(void, UseProgram, (GLuint program))                                                         \
+    X(void, DeleteProgram, (GLuint program))                                                      \
+    X(GLint, GetUniformLocation, (GLuint program, const GLchar *name))                            \
+    X(void, Uniform1i, (GLint location, GLint v0))                                                \
+    X(void, Uniform1f, (GLint location, GLfloat v0))                                              \
+    X(void, UniformMatrix4fv, (GLint location, GLsizei count, GLboolean transpose,                \
+                               const GLfloat *value))
+
+#define GL_LOADER_DECLARE(ret, name, args)                 \
+    typedef ret(GL_LOADER_APIENTRY *GlLoader##name##Fn) args; \
+    extern GlLoader##name##Fn glLoader##name;
+GL_LOADER_FUNCTIONS(GL_LOADER_DECLARE)
+#undef GL_LOADER_DECLARE
+
+#define glGenVertexArrays glLoaderGenVertexArrays
+#define glBindVertexArray glLoaderBindVertexArray
+#define glDeleteVertexArrays glLoaderDeleteVertexArrays
+#define glGenBuffers glLoaderGenBuffers
+#define glBindBuffer glLoaderBindBuffer
+#define glBufferData glLoaderBufferData
+#define glBufferSubData glLoaderBufferSubData
+#define glDeleteBuffers glLoaderDeleteBuffers
+#define glEnableVertexAttribArray glLoaderEnableVertexAttribArray
+#define glVertexAttribPointer glLoaderVertexAttribPointer
+#define glVertexAttribDivisor glLoaderVertexAttribDivisor
+#define glDrawArraysInstanced glLoaderDrawArraysInstanced
+#define glCreateShader glLoaderCreateShader
+#define glShaderSource glLoaderShaderSource
+#define glCompileShader glLoaderCompileShader
+#define glGetShaderiv glLoaderGetShaderiv
+#define glGetShaderInfoLog glLoaderGetShaderInfoLog
+#define glDeleteShader glLoaderDeleteShader
+#define glCreateProgram glLoaderCreateProgram
+#define glAttachShader glLoaderAttachShader
+#define glLinkProgram glLoaderLinkProgram
+#define glGetProgramiv glLoaderGetProgramiv
+#define glGetProgramInfoLog glLoaderGetProgramInfoLog
+#define glUseProgram glLoaderUseProgram
+#define glDeleteProgram glLoaderDeleteProgram
+#define glGetUniformLocation glLoaderGetUniformLocation
+#define glUniform1i glLoaderUniform1i
+#define glUniform1f glLoaderUniform1f
+#define glUniformMatrix4fv glLoaderUniformMatrix4fv
+
+// Asks GLFW for a 3.3 core profile context for the next window it creates;
+// without it drivers may hand out an older compatibility context
+void glLoaderContextHints(void);
+
+// Returns false (and names the first missing entry point) if the context
+// does not provide GL 3.3
+bool glLoaderInit(void);
+
+// Compiles and links a program from two GLSL files; returns 0 on failure
+GLuint glLoaderBuildProgram(const char *vertexPath, const char *fragmentPath);
+
+// The renderers draw instanced unit quads in pixel space. Attributes 0 and
+// 1 are the quad's aPos (xyz) and aTexCoord (uv); the per-instance ones
+// follow from location 2.
+typedef struct
+{
+    GLint components; // Floats
+    size_t offset;    // In the instance struct
+} GlLoaderInstanceAttrib;
+
+// A static buffer holding the unit quad as a four-vertex triangle strip
+GLuint glLoaderCreateQuadVbo(void);
+GLuint glLoaderCreateInstancedVao(GLuint quadVbo, GLuint instanceVbo, size_t instanceBytes,
+                                  const GlLoaderInstanceAttrib *attribs, int attribCount);
+// Orphans the buffer when it has to grow, otherwise overwrites in place;
+// leaves it bound
+void glLoaderUploadInstances(GLuint vbo, size_t *vboBytes, const void *data, size_t bytes);
+// Orthographic projection onto the framebuffer in pixels, y down (column-major)
+void glLoaderPixelProjection(float transform[16], int fbWidth, int fbHeight);
+
+#endif // GL_LOADER_H
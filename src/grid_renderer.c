@@ -0,0 +1,213 @@
+#include "grid_renderer.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+enum
+{
+    MODE_CELL = 0,
+    MODE_INDICATOR = 1,
+    MODE_FLAT = 2
+};
+
+// aRect, aColor, aFlags
+static const GlLoaderInstanceAttrib INSTANCE_ATTRIBS[] = {
+    {4, offsetof(GridInstance, x)},
+    {3, offsetof(GridInstance, r)},
+    {3, offsetof(GridInstance, instrument)}};
+
+static GLuint createInstancedVao(GLuint quadVbo, GLuint instanceVbo)
+{
+    return glLoaderCreateInstancedVao(quadVbo, instanceVbo, sizeof(GridInstance), INSTANCE_ATTRIBS, 3);
+}
+
+static GridInstance lineInstance(float x, float y, float width, float height, float shade)
+{
+    GridInstance line = {x, y, width, height, shade, shade, shade, -1.0f, 1.0f, 0.0f};
+    return line;
+}
+
+bool gridRendererInit(GridRenderer *renderer, float originX, float originY, float cellSize)
+{
+    memset(renderer, 0, sizeof(*renderer));
+    renderer->originX = originX;
+    renderer->originY = originY;
+    renderer->cellSize = cellSize;
+
+    renderer->program = glLoaderBuildProgram("shaders/vertex.glsl", "shaders/fragment.glsl");
+    if (!renderer->program)
+        return false;
+    renderer->transformLoc = glGetUniformLocation(renderer->program, "transform");
+    renderer->timeLoc = glGetUniformLocation(renderer->program, "time");
+    renderer->modeLoc = glGetUniformLocation(renderer->program, "mode");
+    renderer->isSelectedLoc = glGetUniformLocation(renderer->program, "isSelected");
+
+    renderer->quadVbo = glLoaderCreateQuadVbo();
+    glGenBuffers(1, &renderer->cellVbo);
+    glGenBuffers(1, &renderer->lineVbo);
+
+    renderer->cellVao = createInstancedVao(renderer->quadVbo, renderer->cellVbo);
+    renderer->lineVao = createInstancedVao(renderer->quadVbo, renderer->lineVbo);
+    return true;
+}
+
+void gridRendererShutdown(GridRenderer *renderer)
+{
+    if (renderer->cellVao)
+        glDeleteVertexArrays(1, &renderer->cellVao);
+    if (renderer->lineVao)
+        glDeleteVertexArrays(1, &renderer->lineVao);
+    GLuint buffers[] = {renderer->quadVbo, renderer->cellVbo, renderer->lineVbo};
+    for (int i = 0; i < 3; i++)
+    {
+        if (buffers[i])
+            glDeleteBuffers(1, &buffers[i]);
+    }
+    if (renderer->program)
+        glDeleteProgram(renderer->program);
+    free(renderer->cells);
+    free(renderer->lines);
+    memset(renderer, 0, sizeof(*renderer));
+}
+
+static bool reserve(GridInstance **instances, int *capacity, int count)
+{
+    if (count <= *capacity)
+        return true;
+    int grown = *capacity ? *capacity : 256;
+    while (grown < count)
+        grown *= 2;
+    GridInstance *bigger = realloc(*instances, sizeof(GridInstance) * (size_t)grown);
+    if (!bigger)
+        return false;
+    *instances = bigger;
+    *capacity = grown;
+    return true;
+}
+
+static void buildCells(GridRenderer *renderer, const Pattern *pattern, GridView view,
+                       int playColumn, GridColorFn colorFn)
+{
+    renderer->cellCount = 0;
+    int lastRow = view.firstRow + view.rows;
+    for (int col = view.firstCol; col < view.firstCol + view.cols; col++)
+    {
+        PatternColumnIter it;
+        int row;
+        Instrument instrument;
+        patternColumnBegin(pattern, col, &it);
+        while (patternColumnNext(&it, &row, &instrument))
+        {
+            if (row < view.firstRow || row >= lastRow)
+                continue;
+            if (!reserve(&renderer->cells, &renderer->cellCapacity, renderer->cellCount + 1))
+                return;
+            GridInstance *cell = &renderer->cells[renderer->cellCount++];
+            cell->x = renderer->originX + (col - view.firstCol) * renderer->cellSize;
+            cell->y = renderer->originY + (row - view.firstRow) * renderer->cellSize;
+            cell->width = renderer->cellSize;
+            cell->height = renderer->cellSize;
+            float color[3];
+            colorFn(pattern->rowPitch[row], instrument, color);
+            cell->r = color[0];
+            cell->g = color[1];
+            cell->b = color[2];
+            cell->instrument = (float)instrument;
+            cell->active = 1.0f;
+            cell->playing = col == playColumn ? 1.0f : 0.0f;
+        }
+    }
+}
+
+static void buildLines(GridRenderer *renderer, GridView view, int playColumn)
+{
+    renderer->lineCount = 0;
+    if (!reserve(&renderer->lines, &renderer->lineCapacity, view.cols + view.rows + 3))
+        return;
+
+    float originX = renderer->originX;
+    float originY = renderer->originY;
+    float gridWidth = view.cols * renderer->cellSize;
+    float gridHeight = view.rows * renderer->cellSize;
+    for (int col = 0; col <= view.cols; col++)
+    {
+        // Beat lines are brighter
+        float shade = (view.firstCol + col) % 4 == 0 ? 0.5f : 0.3f;
+        renderer->lines[renderer->lineCount++] = lineInstance(originX + col * renderer->cellSize, originY, 1.0f, gridHeight, shade);
+    }
+    for (int row = 0; row <= view.rows; row++)
+        renderer->lines[renderer->lineCount++] = lineInstance(originX, originY + row * renderer->cellSize, gridWidth, 1.0f, 0.3f);
+    if (playColumn >= view.firstCol && playColumn < view.firstCol + view.cols)
+    {
+        float x = originX + (playColumn - view.firstCol) * renderer->cellSize;
+        renderer->lines[renderer->lineCount++] = lineInstance(x, originY, 1.0f, gridHeight, 1.0f);
+    }
+}
+
+static void upload(GLuint vbo, size_t *vboBytes, const GridInstance *instances, int count)
+{
+    glLoaderUploadInstances(vbo, vboBytes, instances, sizeof(GridInstance) * (size_t)count);
+}
+
+static bool sameView(GridView a, GridView b)
+{
+    return a.firstRow == b.firstRow && a.firstCol == b.firstCol && a.rows == b.rows && a.cols == b.cols;
+}
+
+void gridRendererDraw(GridRenderer *renderer, const Pattern *pattern, GridView view,
+                      int playColumn, GridColorFn colorFn, int fbWidth, int fbHeight, float time)
+{
+    // Clamp the view to the pattern
+    if (view.firstRow + view.rows > pattern->rows)
+        view.rows = pattern->rows - view.firstRow;
+    if (view.firstCol + view.cols > pattern->cols)
+        view.cols = pattern->cols - view.firstCol;
+    if (view.rows < 0)
+        view.rows = 0;
+    if (view.cols < 0)
+        view.cols = 0;
+
+    bool viewChanged = !renderer->built || !sameView(view, renderer->builtView);
+    bool playChanged = !renderer->built || playColumn != renderer->builtPlayColumn;
+    if (viewChanged || playChanged || pattern->version != renderer->builtVersion)
+    {
+        buildCells(renderer, pattern, view, playColumn, colorFn);
+        upload(renderer->cellVbo, &renderer->cellVboBytes, renderer->cells, renderer->cellCount);
+        if (viewChanged || playChanged)
+        {
+            buildLines(renderer, view, playColumn);
+            upload(renderer->lineVbo, &renderer->lineVboBytes, renderer->lines, renderer->lineCount);
+        }
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        renderer->built = true;
+        renderer->builtVersion = pattern->version;
+        renderer->builtView = view;
+        renderer->builtPlayColumn = playColumn;
+    }
+
+    float transform[16];
+    glLoaderPixelProjection(transform, fbWidth, fbHeight);
+
+    glUseProgram(renderer->program);
+    glUniformMatrix4fv(renderer->transformLoc, 1, GL_FALSE, transform);
+    glUniform1f(renderer->timeLoc, time);
+    glUniform1i(renderer->isSelectedLoc, 0);
+
+    glBindVertexArray(renderer->lineVao);
+    glUniform1i(renderer->modeLoc, MODE_FLAT);
+    glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, renderer->lineCount);
+
+    if (renderer->cellCount > 0)
+    {
+        glBindVertexArray(renderer->cellVao);
+        glUniform1i(renderer->modeLoc, MODE_CELL);
+        glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, renderer->cellCount);
+        glUniform1i(renderer->modeLoc, MODE_INDICATOR);
+        glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, renderer->cellCount);
+    }
+
+    // Leave nothing bound for the next renderer
+    glBindVertexArray(0);
+    glUseProgram(0);
+}
@@ -0,0 +1,79 @@
+#ifndef GRID_RENDERER_H
+#define GRID_RENDERER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "gl_loader.h"
+#include "pattern.h"
+
+// Instanced, viewport-culled renderer for the note grid. Only the active
+// notes inside the visible window get an instance, so draw cost follows
+// what is on screen rather than the pattern's size. The instance buffer is
+// rebuilt when the pattern, the view or the playhead changes. Cells,
+// instrument indicators and grid lines + playhead are three instanced draw
+// calls.
+
+typedef struct
+{
+    float x, y, width, height; // Pixels
+    float r, g, b;
+    float instrument;
+    float active;
+    float playing;
+} GridInstance;
+
+// The window of the pattern on screen, in pattern coordinates
+typedef struct
+{
+    int firstRow;
+    int firstCol;
+    int rows;
+    int cols;
+} GridView;
+
+// Fills the color of a note cell
+typedef void (*GridColorFn)(int pitch, Instrument instrument, float color[3]);
+
+typedef struct
+{
+    GLuint program;
+    GLint transformLoc;
+    GLint timeLoc;
+    GLint modeLoc;
+    GLint isSelectedLoc;
+
+    GLuint quadVbo;
+    GLuint cellVao;
+    GLuint cellVbo;
+    GLuint lineVao;
+    GLuint lineVbo;
+
+    GridInstance *cells; // Visible active notes
+    int cellCount;
+    int cellCapacity;
+    GridInstance *lines; // Visible grid lines followed by the playhead
+    int lineCount;
+    int lineCapacity;
+    size_t cellVboBytes;
+    size_t lineVboBytes;
+
+    // What the instance buffers were built from
+    bool built;
+    uint32_t builtVersion;
+    GridView builtView;
+    int builtPlayColumn;
+
+    float originX;
+    float originY;
+    float cellSize;
+} GridRenderer;
+
+bool gridRendererInit(GridRenderer *renderer, float originX, float originY, float cellSize);
+void gridRendererShutdown(GridRenderer *renderer);
+
+// playColumn -1 hides the playhead
+void gridRendererDraw(GridRenderer *renderer, const Pattern *pattern, GridView view,
+                      int playColumn, GridColorFn colorFn, int fbWidth, int fbHeight, float time);
+
+#endif // GRID_RENDERER_H
@@ -0,0 +1,138 @@
+#include "keymap.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Fills zoneForPitch from the zones: nearest root first, then the ranges
+static void assignPitches(KeyMap *map)
+{
+    for (int instrument = 0; instrument < NUM_INSTRUMENTS; instrument++)
+    {
+        int8_t *zoneFor = map->zoneForPitch[instrument];
+        for (int pitch = 0; pitch < PATTERN_MAX_ROWS; pitch++)
+        {
+            int best = -1;
+            for (int z = 0; z < map->zoneCount[instrument]; z++)
+            {
+                const KeyZone *zone = &map->zones[instrument][z];
+                if (zone->ranged)
+                    continue;
+                int distance = abs(pitch - zone->root);
+                int bestDistance = best < 0 ? 0 : abs(pitch - map->zones[instrument][best].root);
+                if (best < 0 || distance < bestDistance ||
+                    (distance == bestDistance && zone->root < map->zones[instrument][best].root))
+                    best = z;
+            }
+            zoneFor[pitch] = (int8_t)best;
+        }
+        for (int z = 0; z < map->zoneCount[instrument]; z++)
+        {
+            const KeyZone *zone = &map->zones[instrument][z];
+            if (!zone->ranged)
+                continue;
+            for (int pitch = zone->low; pitch <= zone->high; pitch++)
+                zoneFor[pitch] = (int8_t)z;
+        }
+
+        // Record the notes each nearest-root zone ended up with
+        for (int z = 0; z < map->zoneCount[instrument]; z++)
+        {
+            KeyZone *zone = &map->zones[instrument][z];
+            if (zone->ranged)
+                continue;
+            zone->low = PATTERN_MAX_ROWS - 1;
+            zone->high = 0;
+            for (int pitch = 0; pitch < PATTERN_MAX_ROWS; pitch++)
+            {
+                if (zoneFor[pitch] != z)
+                    continue;
+                if (pitch < zone->low)
+                    zone->low = (uint8_t)pitch;
+                zone->high = (uint8_t)pitch;
+            }
+        }
+    }
+}
+
+void keyMapInitDefault(KeyMap *map)
+{
+    memset(map, 0, sizeof(*map));
+    for (int instrument = 0; instrument < NUM_INSTRUMENTS; instrument++)
+    {
+        map->zones[instrument][0].root = (uint8_t)noteParse(KEYMAP_DEFAULT_ROOT);
+        map->zoneCount[instrument] = 1;
+    }
+    assignPitches(map);
+}
+
+static int instrumentForName(const char *name)
+{
+    for (int i = 0; i < NUM_INSTRUMENTS; i++)
+    {
+        if (strcmp(name, INSTRUMENT_DIRS[i]) == 0)
+            return i;
+    }
+    return -1;
+}
+
+bool keyMapLoad(KeyMap *map, const char *path)
+{
+    FILE *file = fopen(path, "r");
+    if (!file)
+    {
+        fprintf(stderr, "Failed to open keymap %s\n", path);
+        return false;
+    }
+
+    KeyMap loaded;
+    memset(&loaded, 0, sizeof(loaded));
+    char line[256];
+    int lineNumber = 0;
+    bool ok = true;
+    while (ok && fgets(line, sizeof(line), file))
+    {
+        lineNumber++;
+        char *comment = strchr(line, '#');
+        if (comment)
+            *comment = '\0';
+
+        char *fields[5];
+        int count = 0;
+        for (char *word = strtok(line, " \t\r\n"); word && count < 5; word = strtok(NULL, " \t\r\n"))
+            fields[count++] = word;
+        if (count == 0)
+            continue;
+
+        int instrument = instrumentForName(fields[0]);
+        int root = count > 1 ? noteParse(fields[1]) : -1;
+        int low = count == 4 ? noteParse(fields[2]) : 0;
+        int high = count == 4 ? noteParse(fields[3]) : 0;
+        ok = instrument >= 0 && root >= 0 && (count == 2 || count == 4) && low >= 0 && high >= low &&
+             loaded.zoneCount[instrument] < KEYMAP_MAX_ZONES;
+        if (!ok)
+            break;
+
+        KeyZone *zone = &loaded.zones[instrument][loaded.zoneCount[instrument]++];
+        zone->root = (uint8_t)root;
+        zone->low = (uint8_t)low;
+        zone->high = (uint8_t)high;
+        zone->ranged = count == 4;
+    }
+    fclose(file);
+    if (!ok)
+    {
+        fprintf(stderr, "%s:%d: expected \"<instrument> <root> [<low> <high>]\"\n", path, lineNumber);
+        return false;
+    }
+
+    assignPitches(&loaded);
+    *map = loaded;
+    return true;
+}
+
+float keyMapRate(int pitch, int root)
+{
+    return exp2f((float)(pitch - root) / 12.0f);
+}
@@ -0,0 +1,59 @@
+#ifndef KEYMAP_H
+#define KEYMAP_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "pattern.h"
+
+// Which recorded sample plays each note of each instrument. A zone maps a
+// range of notes to one root sample, which is resampled by the semitones
+// between the note and the root, so a few roots cover all 128 notes.
+//
+// Keymap files have one zone per line, "<instrument> <root> [<low> <high>]",
+// with instruments named as their sounds/ directories and notes spelled as
+// in patterns; '#' starts a comment:
+//
+//     piano G4              # every piano note from sounds/piano/G4.wav
+//     bell  C4  C0 F#4      # an explicit range
+//     bell  C5
+//
+// A zone without a range takes the notes that are nearer its root than any
+// other root of the instrument, ties going to the lower root; the lowest
+// and highest of them extend to the ends of the MIDI range. Explicit ranges
+// win over those and may leave notes silent.
+
+#define KEYMAP_MAX_ZONES 32 // Per instrument
+#define KEYMAP_DEFAULT_ROOT "G4" // Mid-way through the shipped C4-C5 samples
+
+typedef struct
+{
+    uint8_t root;
+    uint8_t low; // Lowest and highest notes played, inclusive
+    uint8_t high;
+    bool ranged; // Range given in the file
+} KeyZone;
+
+typedef struct
+{
+    KeyZone zones[NUM_INSTRUMENTS][KEYMAP_MAX_ZONES];
+    int zoneCount[NUM_INSTRUMENTS];
+    int8_t zoneForPitch[NUM_INSTRUMENTS][PATTERN_MAX_ROWS]; // -1 where silent
+} KeyMap;
+
+// One zone per instrument over every note, rooted at KEYMAP_DEFAULT_ROOT
+void keyMapInitDefault(KeyMap *map);
+// Replaces map on success. Prints why and changes nothing on failure.
+bool keyMapLoad(KeyMap *map, const char *path);
+
+// The root note that plays `pitch`, or -1
+static inline int keyMapRoot(const KeyMap *map, Instrument instrument, int pitch)
+{
+    int zone = map->zoneForPitch[instrument][pitch];
+    return zone < 0 ? -1 : map->zones[instrument][zone].root;
+}
+
+// Source frames per output frame to sound `pitch` from a sample of `root`
+float keyMapRate(int pitch, int root);
+
+#endif // KEYMAP_H
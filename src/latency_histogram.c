@@ -0,0 +1,101 @@
+#include "latency_histogram.h"
+
+#include <string.h>
+
+#define SUB_COUNT (1 << LATENCY_SUB_BITS)
+#define HALF_COUNT (SUB_COUNT >> 1)
+
+static int highestBit(uint64_t value)
+{
+    int bit = 0;
+    while (value >>= 1)
+        bit++;
+    return bit;
+}
+
+static int bucketFor(uint64_t ns)
+{
+    if (ns < SUB_COUNT)
+        return (int)ns;
+    if (ns >= (uint64_t)1 << LATENCY_MAX_BITS)
+        ns = ((uint64_t)1 << LATENCY_MAX_BITS) - 1;
+    // Keep the top LATENCY_SUB_BITS bits: sub is in [HALF_COUNT, SUB_COUNT)
+    int shift = highestBit(ns) - LATENCY_SUB_BITS + 1;
+    return shift * HALF_COUNT + (int)(ns >> shift);
+}
+
+// Largest value that lands in the bucket
+static uint64_t bucketUpperNs(int bucket)
+{
+    if (bucket < SUB_COUNT)
+        return (uint64_t)bucket;
+    int shift = bucket / HALF_COUNT - 1;
+    uint64_t sub = (uint64_t)(bucket - shift * HALF_COUNT);
+    return ((sub + 1) << shift) - 1;
+}
+
+void latencyHistogramReset(LatencyHistogram *histogram)
+{
+    memset((void *)histogram, 0, sizeof(*histogram));
+}
+
+void latencyHistogramRecord(LatencyHistogram *histogram, double seconds)
+{
+    uint64_t ns = seconds > 0.0 ? (uint64_t)(seconds * 1e9) : 0;
+    volatile int32_t *count = &histogram->counts[bucketFor(ns)];
+    // Single writer: a plain increment published with a release store
+    atomicStore32(count, *count + 1);
+    if ((int64_t)ns > histogram->maxNs)
+        atomicStore64(&histogram->maxNs, (int64_t)ns);
+}
+
+void latencyHistogramSummarize(LatencyHistogram *histogram, LatencySummary *summary)
+{
+    int32_t counts[LATENCY_BUCKETS];
+    int64_t total = 0;
+    for (int i = 0; i < LATENCY_BUCKETS; i++)
+    {
+        counts[i] = atomicLoad32(&histogram->counts[i]);
+        total += counts[i];
+    }
+
+    memset(summary, 0, sizeof(*summary));
+    summary->count = total;
+    summary->max = (double)atomicLoad64(&histogram->maxNs) * 1e-9;
+    if (total == 0)
+        return;
+
+    int64_t p50Rank = (total + 1) / 2;
+    int64_t p99Rank = (total * 99 + 99) / 100;
+    int64_t seen = 0;
+    for (int i = 0; i < LATENCY_BUCKETS; i++)
+    {
+        int64_t before = seen;
+        seen += counts[i];
+        if (before < p50Rank && seen >= p50Rank)
+            summary->p50 = (double)bucketUpperNs(i) * 1e-9;
+        if (before < p99Rank && seen >= p99Rank)
+        {
+            summary->p99 = (double)bucketUpperNs(i) * 1e-9;
+            break;
+        }
+    }
+    // Bucket bounds can overshoot the exact maximum
+    if (summary->p50 > summary->max)
+        summary->p50 = summary->max;
+    if (summary->p99 > summary->max)
+        summary->p99 = summary->max;
+}
+
+void latencyHistogramPrint(LatencyHistogram *histogram, const char *label, FILE *out)
+{
+    LatencySummary s;
+    latencyHistogramSummarize(histogram, &s);
+    if (s.count == 0)
+    {
+        fprintf(out, "  %-16s n=0\n", label);
+        return;
+    }
+    fprintf(out, "  %-16s n=%-8lld p50 %7.3f ms  p99 %7.3f ms  max %7.3f ms\n",
+            label, (long long)s.count, s.p50 * 1e3, s.p99 * 1e3, s.max * 1e3);
+}
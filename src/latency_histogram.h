@@ -0,0 +1,40 @@
+#ifndef LATENCY_HISTOGRAM_H
+#define LATENCY_HISTOGRAM_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include "platform.h"
+
+// HDR-style latency histogram over nanoseconds: exact below 128 ns, then 64
+// sub-buckets per power of two (at most 1.6% error) up to about 18 minutes.
+// Recording is O(1) with no allocation, so the audio thread can do it. One
+// thread records; any thread may read for a report while it does.
+
+#define LATENCY_SUB_BITS 7
+#define LATENCY_MAX_BITS 40
+#define LATENCY_BUCKETS ((LATENCY_MAX_BITS - LATENCY_SUB_BITS + 2) << (LATENCY_SUB_BITS - 1))
+
+typedef struct
+{
+    volatile int32_t counts[LATENCY_BUCKETS];
+    volatile int64_t maxNs;
+} LatencyHistogram;
+
+void latencyHistogramReset(LatencyHistogram *histogram);
+// Negative values count as zero
+void latencyHistogramRecord(LatencyHistogram *histogram, double seconds);
+
+typedef struct
+{
+    int64_t count;
+    double p50;
+    double p99;
+    double max; // Exact; the percentiles are bucket upper bounds
+} LatencySummary;
+
+void latencyHistogramSummarize(LatencyHistogram *histogram, LatencySummary *summary);
+// "<label> n=... p50=... p99=... max=..." in milliseconds
+void latencyHistogramPrint(LatencyHistogram *histogram, const char *label, FILE *out);
+
+#endif // LATENCY_HISTOGRAM_H
@@ -4,75 +4,64 @@
 #include <stdbool.h>
 #include <math.h>
 #include <string.h>
-#include <windows.h>
-#include <mmsystem.h>
-#pragma comment(lib, "winmm.lib")
-
-#define GRID_COLS 32       // Timeline length
-#define GRID_ROWS 8        // Number of notes
-#define CELL_SIZE 30       // Pixel size of each grid cell
-#define TIMELINE_HEIGHT 40 // Height of timeline in pixels
-#define MENU_HEIGHT 30     // Height of instrument menu
-
-// Window dimensions
-const unsigned int SCR_WIDTH = GRID_COLS * CELL_SIZE + 200; // Extra space for labels
-const unsigned int SCR_HEIGHT = GRID_ROWS * CELL_SIZE + TIMELINE_HEIGHT + MENU_HEIGHT + 60;
-
-// Note names and frequencies
-const char *NOTE_NAMES[GRID_ROWS] = {
-    "C5", "B4", "A4", "G4", "F4", "E4", "D4", "C4"};
-
-const float NOTE_FREQUENCIES[GRID_ROWS] = {
-    523.25f, // C5
-    493.88f, // B4
-    440.00f, // A4
-    392.00f, // G4
-    349.23f, // F4
-    329.63f, // E4
-    293.66f, // D4
-    261.63f  // C4
-};
 
-// Colors
-const float NOTE_COLORS[GRID_ROWS][3] = {
-    {1.0f, 0.0f, 0.5f}, // C5 - Pink
-    {0.5f, 0.0f, 1.0f}, // B4 - Purple
-    {0.0f, 0.0f, 1.0f}, // A4 - Blue
-    {0.0f, 1.0f, 1.0f}, // G4 - Cyan
-    {0.0f, 1.0f, 0.0f}, // F4 - Green
-    {1.0f, 1.0f, 0.0f}, // E4 - Yellow
-    {1.0f, 0.5f, 0.0f}, // D4 - Orange
-    {1.0f, 0.0f, 0.0f}  // C4 - Red
-};
+#include "audio_engine.h"
+#include "frame_scheduler.h"
+#include "grid_renderer.h"
+#include "keymap.h"
+#include "midi_file.h"
+#include "pattern.h"
+#include "project.h"
+#include "sample_bank.h"
+#include "sample_streamer.h"
+#include "sequencer.h"
+#include "server_link.h"
+#include "session.h"
+#include "synth.h"
+#include "text_renderer.h"
+#include "trace.h"
+#include "wav.h"
 
-// Instruments
-typedef enum
-{
-    PIANO,
-    SYNTH,
-    BELL,
-    NUM_INSTRUMENTS
-} Instrument;
+#define CELL_SIZE 30                 // Pixel size of each grid cell
+#define TIMELINE_HEIGHT 40           // Height of timeline in pixels
+#define MENU_HEIGHT 30               // Height of instrument menu
+#define GRID_X 100.0f                // Space for labels
+#define GRID_Y (50.0f + MENU_HEIGHT) // Space for timeline and menu
 
-const char *INSTRUMENT_NAMES[NUM_INSTRUMENTS] = {
-    "Piano",
-    "Synth",
-    "Bell"};
+// The window opens large enough for this much of the pattern; bigger
+// patterns scroll
+#define WINDOW_MAX_COLS 32
+#define WINDOW_MAX_ROWS 24
 
-// Note cell structure
-typedef struct
-{
-    bool active;
-    Instrument instrument;
-} NoteCell;
+// How far ahead of sound_server.py's clock steps are sent, unless
+// --lookahead says otherwise
+#define SERVER_LOOKAHEAD_SECONDS 0.05
+
+// Colors by pitch class
+const float NOTE_COLORS[12][3] = {
+    {1.0f, 0.0f, 0.0f}, // C - Red
+    {1.0f, 0.0f, 0.5f}, // C# - Pink
+    {1.0f, 0.5f, 0.0f}, // D - Orange
+    {1.0f, 0.8f, 0.3f}, // D# - Amber
+    {1.0f, 1.0f, 0.0f}, // E - Yellow
+    {0.0f, 1.0f, 0.0f}, // F - Green
+    {0.0f, 0.8f, 0.5f}, // F# - Teal
+    {0.0f, 1.0f, 1.0f}, // G - Cyan
+    {0.3f, 0.6f, 1.0f}, // G# - Sky
+    {0.0f, 0.0f, 1.0f}, // A - Blue
+    {0.3f, 0.0f, 0.8f}, // A# - Indigo
+    {0.5f, 0.0f, 1.0f}  // B - Purple
+};
 
-// Grid state
+// UI thread state. The pattern is the UI's replica of the session's, and
+// isPlaying, tempo and currentInstrument are what the UI last asked for;
+// what the engine is actually doing comes from the session snapshot.
 typedef struct
 {
-    NoteCell cells[GRID_ROWS][GRID_COLS];
-    int currentPlayColumn;
+    Pattern pattern;
+    GridView view; // Scroll position and visible size
+    int currentPlayColumn; // From the latest snapshot
     bool isPlaying;
-    float startTime;
     float tempo; // Beats per minute
     Instrument currentInstrument;
     bool showInstrumentMenu;
@@ -82,54 +71,199 @@ typedef struct
 State state = {
     .currentPlayColumn = -1,
     .isPlaying = false,
-    .startTime = 0.0f,
     .tempo = 120.0f,
     .currentInstrument = PIANO,
     .showInstrumentMenu = false,
     .menuHoverItem = -1};
 
+AudioEngine audio;
+SampleBank sampleBank;
+SampleStreamer streamer;
+Sequencer sequencer;
+GridRenderer gridRenderer;
+TextRenderer textRenderer;
+FrameScheduler scheduler;
+ServerLink serverLink;
+Session session;
+Project project; // path is set while --project is open
+
+// Whether the audio thread or the server link applies session commands;
+// without either, the UI thread applies its own
+bool engineThreadRunning;
+
+_Static_assert(SYNTH_PATCH_COUNT == NUM_INSTRUMENTS, "one synth patch per instrument");
+
+// Notes come from the synth unless --samples asks for the WAVs in sounds/
+bool useSamples = false;
+
+// Where T (and --trace, at exit) writes the Chrome trace
+const char *tracePath = "trace.json";
+int polyphony = VOICE_POOL_DEFAULT_VOICES; // Per pool: samples and synth
+VoiceStealPolicy stealPolicy = VOICE_STEAL_OLDEST;
+int midiStepsPerBeat = MIDI_DEFAULT_STEPS_PER_BEAT; // Pattern steps per MIDI quarter note
+
+// Which root sample plays each note in --samples mode; the bank holds one
+// slot per instrument and MIDI pitch, loaded only for the roots
+KeyMap keyMap;
+const char *keyMapPath = NULL; // --keymap, else one root per instrument
+double streamSeconds = SAMPLE_BANK_STREAM_SECONDS; // --stream: longer samples play from disk
+
+// The sample that sounds `pitch` and the rate to play it at, or NULL
+const SampleRef *sampleForPitch(Instrument instrument, int pitch, float *rate)
+{
+    int root = keyMapRoot(&keyMap, instrument, pitch);
+    if (root < 0 || !sampleBank.slots)
+        return NULL;
+    *rate = keyMapRate(pitch, root);
+    return sampleBankGet(&sampleBank, instrument, root);
+}
+
 void playNoteSound(int row, Instrument instrument)
 {
-    char filename[256];
-    snprintf(filename, sizeof(filename), "sounds\\%s\\%s.wav",
-             INSTRUMENT_NAMES[instrument], NOTE_NAMES[row]);
-    PlaySound(filename, NULL, SND_FILENAME | SND_ASYNC);
+    int pitch = state.pattern.rowPitch[row];
+    if (!useSamples)
+    {
+        audioEngineTriggerSynth(&audio, &SYNTH_PATCHES[instrument], noteFrequency(pitch), 1.0f);
+        return;
+    }
+    float rate;
+    const SampleRef *sample = sampleForPitch(instrument, pitch, &rate);
+    if (sample)
+        audioEngineTrigger(&audio, sample, rate, 1.0f);
 }
 
-void playCurrentColumn()
+// Sequencer step callback; runs on the audio thread at the step's exact
+// frame and reads the session's pattern, which only that thread touches
+void playColumn(void *user, AudioEngine *engine, int column, int offset)
 {
-    if (state.currentPlayColumn >= 0)
+    // Play all active notes in the column
+    PatternColumnIter it;
+    int row;
+    Instrument instrument;
+    patternColumnBegin(&session.pattern, column, &it);
+    while (patternColumnNext(&it, &row, &instrument))
     {
-        // Play all active notes in current column
-        for (int row = 0; row < GRID_ROWS; row++)
+        int pitch = session.pattern.rowPitch[row];
+        if (!useSamples)
         {
-            if (state.cells[row][state.currentPlayColumn].active)
-            {
-                playNoteSound(row, state.cells[row][state.currentPlayColumn].instrument);
-            }
+            audioEngineStartSynth(engine, &SYNTH_PATCHES[instrument], noteFrequency(pitch), 1.0f, offset);
+            continue;
         }
+        float rate;
+        const SampleRef *sample = sampleForPitch(instrument, pitch, &rate);
+        if (sample)
+            audioEngineStartVoice(engine, sample, rate, 1.0f, offset);
     }
 }
 
+// Sequencer step callback in --server mode; runs on the link's scheduling
+// thread and stamps each note with the server's sample clock
+void sendColumn(void *user, AudioEngine *engine, int column, int offset)
+{
+    ServerLink *link = user;
+    int32_t length = (int32_t)(link->sequencer->framesPerStep * 0.9);
+    PatternColumnIter it;
+    int row;
+    Instrument instrument;
+    patternColumnBegin(&session.pattern, column, &it);
+    while (patternColumnNext(&it, &row, &instrument))
+        serverLinkNoteOn(link, offset, noteFrequency(session.pattern.rowPitch[row]), instrument, length);
+}
+
+// Queues an edit for the engine thread; false if the queue was full
+bool sendCommand(SessionCommand command)
+{
+    if (sessionSend(&session, &command))
+        return true;
+    fprintf(stderr, "Engine command queue full, edit dropped\n");
+    return false;
+}
+
+void selectInstrument(Instrument instrument)
+{
+    if (sendCommand((SessionCommand){.type = SESSION_SET_INSTRUMENT, .value = instrument}))
+        state.currentInstrument = instrument;
+}
+
+void setPlaying(bool playing)
+{
+    if (sendCommand((SessionCommand){.type = SESSION_SET_PLAYING, .value = playing}))
+        state.isPlaying = playing;
+}
+
+void setTempo(float tempo)
+{
+    if (sendCommand((SessionCommand){.type = SESSION_SET_TEMPO, .tempo = tempo}))
+        state.tempo = tempo;
+    printf("Tempo: %.1f BPM\n", state.tempo);
+}
+
+void saveProject()
+{
+    if (!project.path)
+    {
+        printf("Nothing to save to; start with --project FILE\n");
+        return;
+    }
+    double start = platformTimeSeconds();
+    if (!projectSave(&project, &state.pattern, state.tempo, state.currentInstrument))
+    {
+        fprintf(stderr, "Failed to save %s\n", project.path);
+        return;
+    }
+    printf("Saved %s: %d pages, %.1f KiB written in %.2f ms\n", project.path, project.savedChunks,
+           project.savedBytes / 1024.0, (platformTimeSeconds() - start) * 1000.0);
+}
+
 void framebuffer_size_callback(GLFWwindow *window, int width, int height)
 {
     glViewport(0, 0, width, height);
+    frameSchedulerRequestRedraw(&scheduler);
 }
 
-void drawText(const char *text, float x, float y, float scale)
+void window_refresh_callback(GLFWwindow *window)
+{
+    frameSchedulerRequestRedraw(&scheduler);
+}
+
+// What the label batch was built from; labels only change with these
+typedef struct
+{
+    GridView view;
+    Instrument instrument;
+    bool menuOpen;
+    int menuHover;
+} LabelKey;
+
+bool labelsBuilt;
+LabelKey labelKey;
+
+const float LABEL_COLOR[3] = {1.0f, 1.0f, 1.0f};
+
+// Starts a new label batch if the cached one is stale; returns whether
+// the draw functions have to add their labels again
+bool beginLabels()
 {
-    // Simple rectangle-based character rendering
-    // This is a placeholder - in a real app, you'd want proper text rendering
-    glColor3f(1.0f, 1.0f, 1.0f);
-    float len = strlen(text) * 8.0f * scale;
-    glBegin(GL_LINES);
-    glVertex2f(x, y);
-    glVertex2f(x + len, y);
-    glEnd();
+    LabelKey key;
+    memset(&key, 0, sizeof(key)); // Padding takes part in the comparison
+    key.view = state.view;
+    key.instrument = state.currentInstrument;
+    key.menuOpen = state.showInstrumentMenu;
+    key.menuHover = state.menuHoverItem;
+    if (labelsBuilt && memcmp(&key, &labelKey, sizeof(key)) == 0)
+        return false;
+
+    labelKey = key;
+    labelsBuilt = true;
+    textRendererClear(&textRenderer);
+    return true;
 }
 
-void drawInstrumentMenu()
+void drawInstrumentMenu(bool rebuildLabels)
 {
+    if (!rebuildLabels)
+        return;
+
     float menuX = 10.0f;
     float menuY = MENU_HEIGHT;
     float menuWidth = 100.0f;
@@ -139,18 +273,13 @@ void drawInstrumentMenu()
     char currentInst[64];
     snprintf(currentInst, sizeof(currentInst), "Instrument: %s",
              INSTRUMENT_NAMES[state.currentInstrument]);
-    drawText(currentInst, menuX, menuY - 20, 1.0f);
+    textRendererAddText(&textRenderer, currentInst, menuX, menuY - 20, 1.0f, LABEL_COLOR);
 
     if (state.showInstrumentMenu)
     {
         // Draw menu background
-        glColor3f(0.2f, 0.2f, 0.2f);
-        glBegin(GL_QUADS);
-        glVertex2f(menuX, menuY);
-        glVertex2f(menuX + menuWidth, menuY);
-        glVertex2f(menuX + menuWidth, menuY + itemHeight * NUM_INSTRUMENTS);
-        glVertex2f(menuX, menuY + itemHeight * NUM_INSTRUMENTS);
-        glEnd();
+        const float background[3] = {0.2f, 0.2f, 0.2f};
+        textRendererAddRect(&textRenderer, menuX, menuY, menuWidth, itemHeight * NUM_INSTRUMENTS, background);
 
         // Draw menu items
         for (int i = 0; i < NUM_INSTRUMENTS; i++)
@@ -160,172 +289,122 @@ void drawInstrumentMenu()
             // Highlight if hovered
             if (i == state.menuHoverItem)
             {
-                glColor3f(0.4f, 0.4f, 0.4f);
-                glBegin(GL_QUADS);
-                glVertex2f(menuX, itemY);
-                glVertex2f(menuX + menuWidth, itemY);
-                glVertex2f(menuX + menuWidth, itemY + itemHeight);
-                glVertex2f(menuX, itemY + itemHeight);
-                glEnd();
+                const float highlight[3] = {0.4f, 0.4f, 0.4f};
+                textRendererAddRect(&textRenderer, menuX, itemY, menuWidth, itemHeight, highlight);
             }
 
-            drawText(INSTRUMENT_NAMES[i], menuX + 5, itemY + itemHeight / 2, 1.0f);
+            textRendererAddText(&textRenderer, INSTRUMENT_NAMES[i], menuX + 5, itemY + itemHeight / 2, 1.0f, LABEL_COLOR);
         }
     }
 }
 
-void drawGrid()
+// Base color from the note, modified by instrument
+void cellColor(int pitch, Instrument instrument, float color[3])
 {
-    float gridStartX = 100.0f;              // Space for labels
-    float gridStartY = 50.0f + MENU_HEIGHT; // Space for timeline and menu
+    float r = NOTE_COLORS[pitch % 12][0];
+    float g = NOTE_COLORS[pitch % 12][1];
+    float b = NOTE_COLORS[pitch % 12][2];
 
-    // Draw note labels
-    for (int row = 0; row < GRID_ROWS; row++)
+    switch (instrument)
     {
-        float y = gridStartY + row * CELL_SIZE;
-        drawText(NOTE_NAMES[row], 10.0f, y + CELL_SIZE / 2, 1.0f);
+    case PIANO:
+        // Keep original colors
+        break;
+    case SYNTH:
+        // Make more neon
+        r = (r + 0.5f) * 0.8f;
+        g = (g + 0.5f) * 0.8f;
+        b = (b + 0.8f) * 0.8f;
+        break;
+    case BELL:
+        // Make more metallic
+        r = (r + 0.7f) * 0.7f;
+        g = (g + 0.7f) * 0.7f;
+        b = (b + 0.7f) * 0.7f;
+        break;
+    default:
+        break;
     }
 
-    // Draw timeline numbers
-    for (int col = 0; col < GRID_COLS; col++)
-    {
-        if (col % 4 == 0)
-        { // Draw number every 4 beats
-            char number[4];
-            sprintf(number, "%d", col + 1);
-            drawText(number, gridStartX + col * CELL_SIZE, 20.0f + MENU_HEIGHT, 1.0f);
-        }
-    }
+    color[0] = r;
+    color[1] = g;
+    color[2] = b;
+}
 
-    // Draw grid lines
-    glColor3f(0.3f, 0.3f, 0.3f);
-    glBegin(GL_LINES);
+// Keeps the view inside the pattern
+void clampView()
+{
+    GridView *view = &state.view;
+    if (view->firstRow > state.pattern.rows - view->rows)
+        view->firstRow = state.pattern.rows - view->rows;
+    if (view->firstCol > state.pattern.cols - view->cols)
+        view->firstCol = state.pattern.cols - view->cols;
+    if (view->firstRow < 0)
+        view->firstRow = 0;
+    if (view->firstCol < 0)
+        view->firstCol = 0;
+}
 
-    // Vertical lines
-    for (int col = 0; col <= GRID_COLS; col++)
-    {
-        float x = gridStartX + col * CELL_SIZE;
-        glVertex2f(x, gridStartY);
-        glVertex2f(x, gridStartY + GRID_ROWS * CELL_SIZE);
+void scrollView(int rows, int cols)
+{
+    state.view.firstRow += rows;
+    state.view.firstCol += cols;
+    clampView();
+    frameSchedulerRequestRedraw(&scheduler);
+}
 
-        // Make beat lines brighter
-        if (col % 4 == 0)
-        {
-            glColor3f(0.5f, 0.5f, 0.5f);
-            glVertex2f(x, gridStartY);
-            glVertex2f(x, gridStartY + GRID_ROWS * CELL_SIZE);
-            glColor3f(0.3f, 0.3f, 0.3f);
-        }
-    }
+// Fits the view to the framebuffer
+void resizeView(int width, int height)
+{
+    int cols = (int)((width - GRID_X - 20.0f) / CELL_SIZE);
+    int rows = (int)((height - GRID_Y - 20.0f) / CELL_SIZE);
+    state.view.cols = cols < 1 ? 1 : cols;
+    state.view.rows = rows < 1 ? 1 : rows;
+    clampView();
+}
 
-    // Horizontal lines
-    for (int row = 0; row <= GRID_ROWS; row++)
-    {
-        float y = gridStartY + row * CELL_SIZE;
-        glVertex2f(gridStartX, y);
-        glVertex2f(gridStartX + GRID_COLS * CELL_SIZE, y);
-    }
-    glEnd();
+// The view must already fit the framebuffer (resizeView)
+void drawGrid(int width, int height, bool rebuildLabels)
+{
+    const GridView *view = &state.view;
+    int lastRow = view->firstRow + view->rows < state.pattern.rows ? view->firstRow + view->rows : state.pattern.rows;
+    int lastCol = view->firstCol + view->cols < state.pattern.cols ? view->firstCol + view->cols : state.pattern.cols;
 
-    // Draw filled cells
-    for (int row = 0; row < GRID_ROWS; row++)
+    if (rebuildLabels)
     {
-        for (int col = 0; col < GRID_COLS; col++)
+        // Draw note labels
+        for (int row = view->firstRow; row < lastRow; row++)
         {
-            if (state.cells[row][col].active)
-            {
-                float x = gridStartX + col * CELL_SIZE;
-                float y = gridStartY + row * CELL_SIZE;
-
-                // Base color from note
-                float r = NOTE_COLORS[row][0];
-                float g = NOTE_COLORS[row][1];
-                float b = NOTE_COLORS[row][2];
-
-                // Modify color based on instrument
-                switch (state.cells[row][col].instrument)
-                {
-                case PIANO:
-                    // Keep original colors
-                    break;
-                case SYNTH:
-                    // Make more neon
-                    r = (r + 0.5f) * 0.8f;
-                    g = (g + 0.5f) * 0.8f;
-                    b = (b + 0.8f) * 0.8f;
-                    break;
-                case BELL:
-                    // Make more metallic
-                    r = (r + 0.7f) * 0.7f;
-                    g = (g + 0.7f) * 0.7f;
-                    b = (b + 0.7f) * 0.7f;
-                    break;
-                }
-
-                glColor3f(r, g, b);
-                glBegin(GL_QUADS);
-                glVertex2f(x + 2, y + 2);
-                glVertex2f(x + CELL_SIZE - 2, y + 2);
-                glVertex2f(x + CELL_SIZE - 2, y + CELL_SIZE - 2);
-                glVertex2f(x + 2, y + CELL_SIZE - 2);
-                glEnd();
-
-                // Draw a small indicator for the instrument
-                float indicatorSize = 6.0f;
-                glColor3f(1.0f, 1.0f, 1.0f);
-                switch (state.cells[row][col].instrument)
-                {
-                case PIANO:
-                    // Draw a small rectangle
-                    glBegin(GL_LINE_LOOP);
-                    glVertex2f(x + 4, y + 4);
-                    glVertex2f(x + 4 + indicatorSize, y + 4);
-                    glVertex2f(x + 4 + indicatorSize, y + 4 + indicatorSize);
-                    glVertex2f(x + 4, y + 4 + indicatorSize);
-                    glEnd();
-                    break;
-                case SYNTH:
-                    // Draw a triangle
-                    glBegin(GL_LINE_LOOP);
-                    glVertex2f(x + 4, y + 4 + indicatorSize);
-                    glVertex2f(x + 4 + indicatorSize / 2, y + 4);
-                    glVertex2f(x + 4 + indicatorSize, y + 4 + indicatorSize);
-                    glEnd();
-                    break;
-                case BELL:
-                    // Draw a circle
-                    const int segments = 8;
-                    glBegin(GL_LINE_LOOP);
-                    for (int i = 0; i < segments; i++)
-                    {
-                        float angle = 2.0f * 3.1415926f * i / segments;
-                        float cx = x + 4 + indicatorSize / 2 + cosf(angle) * indicatorSize / 2;
-                        float cy = y + 4 + indicatorSize / 2 + sinf(angle) * indicatorSize / 2;
-                        glVertex2f(cx, cy);
-                    }
-                    glEnd();
-                    break;
-                }
+            char name[8];
+            float y = GRID_Y + (row - view->firstRow) * CELL_SIZE;
+            noteName(state.pattern.rowPitch[row], name, sizeof(name));
+            textRendererAddText(&textRenderer, name, 10.0f, y + CELL_SIZE / 2, 1.0f, LABEL_COLOR);
+        }
+
+        // Draw timeline numbers
+        for (int col = view->firstCol; col < lastCol; col++)
+        {
+            if (col % 4 == 0)
+            { // Draw number every 4 beats
+                char number[12];
+                snprintf(number, sizeof(number), "%d", col + 1);
+                textRendererAddText(&textRenderer, number, GRID_X + (col - view->firstCol) * CELL_SIZE,
+                                    20.0f + MENU_HEIGHT, 1.0f, LABEL_COLOR);
             }
         }
     }
 
-    // Draw playhead
-    if (state.currentPlayColumn >= 0)
-    {
-        float x = gridStartX + state.currentPlayColumn * CELL_SIZE;
-        glColor3f(1.0f, 1.0f, 1.0f);
-        glBegin(GL_LINES);
-        glVertex2f(x, gridStartY);
-        glVertex2f(x, gridStartY + GRID_ROWS * CELL_SIZE);
-        glEnd();
-    }
+    gridRendererDraw(&gridRenderer, &state.pattern, *view, state.currentPlayColumn, cellColor,
+                     width, height, (float)glfwGetTime());
 }
 
 void mouse_button_callback(GLFWwindow *window, int button, int action, int mods)
 {
+    double stamp = platformTimeSeconds();
     if (button == GLFW_MOUSE_BUTTON_LEFT && action == GLFW_PRESS)
     {
+        frameSchedulerRequestRedraw(&scheduler);
+
         double xpos, ypos;
         glfwGetCursorPos(window, &xpos, &ypos);
 
@@ -340,29 +419,43 @@ void mouse_button_callback(GLFWwindow *window, int button, int action, int mods)
             else if (state.showInstrumentMenu && state.menuHoverItem >= 0)
             {
                 // Select instrument
-                state.currentInstrument = state.menuHoverItem;
+                selectInstrument(state.menuHoverItem);
                 state.showInstrumentMenu = false;
             }
             return;
         }
 
         // Convert mouse coordinates to grid coordinates
-        float gridStartX = 100.0f;
-        float gridStartY = 50.0f + MENU_HEIGHT;
-
-        int col = (int)((xpos - gridStartX) / CELL_SIZE);
-        int row = (int)((ypos - gridStartY) / CELL_SIZE);
+        if (xpos < GRID_X || ypos < GRID_Y)
+            return;
+        int viewCol = (int)((xpos - GRID_X) / CELL_SIZE);
+        int viewRow = (int)((ypos - GRID_Y) / CELL_SIZE);
+        int col = state.view.firstCol + viewCol;
+        int row = state.view.firstRow + viewRow;
 
-        if (row >= 0 && row < GRID_ROWS && col >= 0 && col < GRID_COLS)
+        if (viewRow < state.view.rows && viewCol < state.view.cols &&
+            row < state.pattern.rows && col < state.pattern.cols)
         {
-            // Toggle cell state
-            state.cells[row][col].active = !state.cells[row][col].active;
-
-            // If toggled on, set instrument and play the note
-            if (state.cells[row][col].active)
+            // Toggle cell state; if toggled on, set instrument and play the note.
+            // The engine gets the edited page; if it can't, the edit is undone
+            // so the replica stays in step.
+            bool active = !patternIsActive(&state.pattern, row, col);
+            Instrument previous = patternInstrument(&state.pattern, row, col);
+            if (!patternSet(&state.pattern, row, col, active, state.currentInstrument))
+            {
+                fprintf(stderr, "Out of memory adding a note\n");
+                return;
+            }
+            if (!sessionSendPage(&session, &state.pattern, col))
+            {
+                fprintf(stderr, "Out of memory or engine command queue full, edit dropped\n");
+                patternSet(&state.pattern, row, col, !active, previous);
+                return;
+            }
+            if (active)
             {
-                state.cells[row][col].instrument = state.currentInstrument;
                 playNoteSound(row, state.currentInstrument);
+                audioEngineMark(&audio, AUDIO_MARK_CLICK, stamp);
             }
         }
     }
@@ -373,32 +466,57 @@ void cursor_position_callback(GLFWwindow *window, double xpos, double ypos)
     if (state.showInstrumentMenu)
     {
         // Update menu hover state
+        int hoverItem = -1;
         if (xpos < 110.0f && ypos >= MENU_HEIGHT && ypos < MENU_HEIGHT + NUM_INSTRUMENTS * 25.0f)
         {
-            state.menuHoverItem = (int)((ypos - MENU_HEIGHT) / 25.0f);
+            hoverItem = (int)((ypos - MENU_HEIGHT) / 25.0f);
         }
-        else
+        if (hoverItem != state.menuHoverItem)
         {
-            state.menuHoverItem = -1;
+            state.menuHoverItem = hoverItem;
+            frameSchedulerRequestRedraw(&scheduler);
         }
     }
 }
 
+// Wheel scrolls notes, shift + wheel or a horizontal wheel scrolls steps
+void scroll_callback(GLFWwindow *window, double xoffset, double yoffset)
+{
+    bool shift = glfwGetKey(window, GLFW_KEY_LEFT_SHIFT) == GLFW_PRESS ||
+                 glfwGetKey(window, GLFW_KEY_RIGHT_SHIFT) == GLFW_PRESS;
+    if (shift)
+    {
+        xoffset = yoffset;
+        yoffset = 0.0;
+    }
+    scrollView((int)-yoffset * 3, (int)-xoffset * 4);
+}
+
 void key_callback(GLFWwindow *window, int key, int scancode, int action, int mods)
 {
+    double stamp = platformTimeSeconds();
+    if (action == GLFW_PRESS)
+        frameSchedulerRequestRedraw(&scheduler);
+
     if (key == GLFW_KEY_SPACE && action == GLFW_PRESS)
     {
-        state.isPlaying = !state.isPlaying;
-        if (state.isPlaying)
-        {
-            state.currentPlayColumn = 0;
-            state.startTime = (float)glfwGetTime();
-            playCurrentColumn();
-        }
-        else
-        {
-            state.currentPlayColumn = -1;
-        }
+        // The engine thread starts the clock on its next block
+        setPlaying(!state.isPlaying);
+        // In --server mode the steps sound in sound_server.py, not here
+        if (state.isPlaying && !serverLink.thread)
+            audioEngineMark(&audio, AUDIO_MARK_START, stamp);
+    }
+    else if (key == GLFW_KEY_L && action == GLFW_PRESS)
+    {
+        audioEnginePrintStats(&audio, stdout);
+    }
+    else if (key == GLFW_KEY_T && action == GLFW_PRESS)
+    {
+        traceWriteJson(tracePath);
+    }
+    else if (key == GLFW_KEY_S && (mods & GLFW_MOD_CONTROL) && action == GLFW_PRESS)
+    {
+        saveProject();
     }
     else if (key == GLFW_KEY_ESCAPE && action == GLFW_PRESS)
     {
@@ -407,13 +525,25 @@ void key_callback(GLFWwindow *window, int key, int scancode, int action, int mod
     // Tempo control
     else if (key == GLFW_KEY_UP && action == GLFW_PRESS)
     {
-        state.tempo = fmin(state.tempo + 5.0f, 240.0f);
-        printf("Tempo: %.1f BPM\n", state.tempo);
+        setTempo(fmax(state.tempo, fmin(state.tempo + 5.0f, 240.0f)));
     }
     else if (key == GLFW_KEY_DOWN && action == GLFW_PRESS)
     {
-        state.tempo = fmax(state.tempo - 5.0f, 60.0f);
-        printf("Tempo: %.1f BPM\n", state.tempo);
+        setTempo(fmin(state.tempo, fmax(state.tempo - 5.0f, 60.0f)));
+    }
+    // Scrolling: a bar at a time, a screen at a time with shift
+    else if ((key == GLFW_KEY_LEFT || key == GLFW_KEY_RIGHT) && action != GLFW_RELEASE)
+    {
+        int step = (mods & GLFW_MOD_SHIFT) ? state.view.cols : 4;
+        scrollView(0, key == GLFW_KEY_LEFT ? -step : step);
+    }
+    else if ((key == GLFW_KEY_PAGE_UP || key == GLFW_KEY_PAGE_DOWN) && action != GLFW_RELEASE)
+    {
+        scrollView(key == GLFW_KEY_PAGE_UP ? -state.view.rows : state.view.rows, 0);
+    }
+    else if (key == GLFW_KEY_HOME && action == GLFW_PRESS)
+    {
+        scrollView(0, -state.view.firstCol);
     }
     // Instrument selection with number keys
     else if (key >= GLFW_KEY_1 && key <= GLFW_KEY_3 && action == GLFW_PRESS)
@@ -421,7 +551,7 @@ void key_callback(GLFWwindow *window, int key, int scancode, int action, int mod
         int instrument = key - GLFW_KEY_1;
         if (instrument < NUM_INSTRUMENTS)
         {
-            state.currentInstrument = instrument;
+            selectInstrument(instrument);
             printf("Selected instrument: %s\n", INSTRUMENT_NAMES[instrument]);
         }
     }
@@ -429,31 +559,440 @@ void key_callback(GLFWwindow *window, int key, int scancode, int action, int mod
 
 void updatePlayback()
 {
-    if (state.isPlaying)
+    if (!engineThreadRunning)
     {
-        float currentTime = (float)glfwGetTime() - state.startTime;
-        float beatsPerSecond = state.tempo / 60.0f;
-        float beatTime = 1.0f / beatsPerSecond;
+        sessionApplyCommands(&session);
+        sessionPublish(&session, 0);
+    }
 
-        int newColumn = ((int)(currentTime / beatTime)) % GRID_COLS;
+    // The playhead only observes the engine's latest snapshot
+    const SessionSnapshot *snapshot = sessionSnapshot(&session);
+    state.currentPlayColumn = snapshot->currentStep;
 
-        if (newColumn != state.currentPlayColumn)
+    // Page the view along with the playhead
+    int col = state.currentPlayColumn;
+    if (snapshot->playing && col >= 0 &&
+        (col < state.view.firstCol || col >= state.view.firstCol + state.view.cols))
+    {
+        state.view.firstCol = col - col % state.view.cols;
+        clampView();
+    }
+}
+
+bool loadSamples()
+{
+    if (keyMapPath)
+    {
+        if (!keyMapLoad(&keyMap, keyMapPath))
+            return false;
+    }
+    else
+    {
+        keyMapInitDefault(&keyMap);
+    }
+
+    // Only the roots some zone plays from
+    static char names[PATTERN_MAX_ROWS][8];
+    const char *noteNames[PATTERN_MAX_ROWS];
+    bool wanted[NUM_INSTRUMENTS * PATTERN_MAX_ROWS] = {false};
+    for (int pitch = 0; pitch < PATTERN_MAX_ROWS; pitch++)
+    {
+        noteName(pitch, names[pitch], sizeof(names[pitch]));
+        noteNames[pitch] = names[pitch];
+        for (int instrument = 0; instrument < NUM_INSTRUMENTS; instrument++)
+        {
+            int root = keyMapRoot(&keyMap, (Instrument)instrument, pitch);
+            if (root >= 0)
+                wanted[instrument * PATTERN_MAX_ROWS + root] = true;
+        }
+    }
+
+    int32_t streamAbove = (int32_t)(streamSeconds * AUDIO_SAMPLE_RATE);
+    if (!sampleBankLoad(&sampleBank, "sounds", INSTRUMENT_DIRS, NUM_INSTRUMENTS, noteNames, PATTERN_MAX_ROWS, wanted,
+                        streamAbove))
+        return false;
+    printf("Loaded %d samples (%.1f KiB resident) in %.2f ms\n",
+           sampleBank.loadedCount, sampleBank.residentBytes / 1024.0,
+           sampleBank.loadSeconds * 1000.0);
+    if (sampleBank.streamCount > 0)
+        printf("Streaming %d of them from disk past their first %.2f s (%.1f MiB not resident)\n",
+               sampleBank.streamCount, (double)SAMPLE_BANK_HEAD_FRAMES / AUDIO_SAMPLE_RATE,
+               sampleBank.streamedBytes / 1048576.0);
+    if (!sampleStreamerInit(&streamer, &sampleBank))
+        fprintf(stderr, "Out of memory for sample streaming; long samples stop after their head\n");
+    return true;
+}
+
+// The streamer first: its prefetch thread reads the bank
+void freeSamples()
+{
+    sampleStreamerFree(&streamer);
+    sampleBankFree(&sampleBank);
+}
+
+// A text pattern or, by its extension, a Standard MIDI File
+bool loadPattern(const char *path)
+{
+    if (!midiFileIsMidiPath(path))
+        return patternLoadText(path, &state.pattern, &state.tempo);
+
+    double start = platformTimeSeconds();
+    MidiImportStats stats;
+    if (!midiFileImport(path, midiStepsPerBeat, &state.pattern, &state.tempo, &stats))
+        return false;
+    printf("Imported %s in %.2f ms: format %d, %d tracks, %lld events, %lld notes",
+           path, (platformTimeSeconds() - start) * 1000.0, stats.format, stats.tracks,
+           (long long)stats.events, (long long)stats.notes);
+    if (stats.merged || stats.drumNotes || stats.lateNotes)
+        printf(" (dropped %lld merged, %lld drums, %lld late)",
+               (long long)stats.merged, (long long)stats.drumNotes, (long long)stats.lateNotes);
+    if (stats.tempoChanges)
+        printf(", ignored %d tempo changes", stats.tempoChanges);
+    printf("\n");
+    return true;
+}
+
+// Headless bounce: the same sequencer and mixer as live playback, driven
+// directly instead of by an audio device, so it runs as fast as the CPU allows
+int renderOffline(const char *patternPath, const char *outPath, int bars)
+{
+    if (!loadPattern(patternPath))
+    {
+        fprintf(stderr, "Failed to load pattern %s\n", patternPath);
+        return 1;
+    }
+    if (useSamples && !loadSamples())
+    {
+        fprintf(stderr, "Failed to load samples\n");
+        return 1;
+    }
+    if (bars <= 0)
+        bars = (state.pattern.cols + 3) / 4;
+
+    WavWriter writer;
+    if (!wavWriterOpen(&writer, outPath, AUDIO_SAMPLE_RATE))
+    {
+        fprintf(stderr, "Failed to open %s for writing\n", outPath);
+        freeSamples();
+        return 1;
+    }
+
+    audioEngineInit(&audio);
+    audioEngineSetPolyphony(&audio, polyphony, stealPolicy);
+    audioEngineSetStreamer(&audio, &streamer);
+    sequencerInit(&sequencer, state.pattern.cols, state.tempo, playColumn, NULL);
+    if (!sessionInit(&session, &state.pattern, &sequencer, state.currentInstrument))
+    {
+        fprintf(stderr, "Out of memory copying the pattern\n");
+        wavWriterClose(&writer);
+        freeSamples();
+        return 1;
+    }
+    // This thread is the engine thread; commands apply at the next block
+    audioEngineSetBlockCallback(&audio, sessionProcessBlock, &session);
+    setPlaying(true);
+
+    // Four steps per bar, then let the last notes ring out. Playback starts
+    // on frame 0, so the sequencer's anchor puts the end of the steps here.
+    int64_t stepsEnd = (int64_t)llround((double)bars * 4 * sequencer.framesPerStep);
+    int64_t totalFrames = stepsEnd;
+    int64_t tailFrames = 0;
+    for (int row = 0; useSamples && row < state.pattern.rows; row++)
+    {
+        // Notes below their root play slower and ring longer
+        for (int instrument = 0; instrument < NUM_INSTRUMENTS; instrument++)
         {
-            state.currentPlayColumn = newColumn;
-            playCurrentColumn();
+            float rate;
+            const SampleRef *sample = sampleForPitch((Instrument)instrument, state.pattern.rowPitch[row], &rate);
+            int64_t frames = sample ? (int64_t)ceil(sample->frames / rate) : 0;
+            if (frames > tailFrames)
+                tailFrames = frames;
         }
     }
+    for (int i = 0; !useSamples && i < SYNTH_PATCH_COUNT; i++)
+    {
+        int64_t frames = (int64_t)ceil(synthPatchLength(&SYNTH_PATCHES[i]) * AUDIO_SAMPLE_RATE);
+        if (frames > tailFrames)
+            tailFrames = frames;
+    }
+    totalFrames += tailFrames;
+
+    double start = platformTimeSeconds();
+    bool ok = true;
+    float block[AUDIO_BLOCK_FRAMES];
+    for (int64_t done = 0, frames; ok && done < totalFrames; done += frames)
+    {
+        // The block reaching the end of the steps stops there, and the stop
+        // applies before the next one, so no step past the last bar sounds
+        int64_t end = done < stepsEnd ? stepsEnd : totalFrames;
+        frames = end - done < AUDIO_BLOCK_FRAMES ? end - done : AUDIO_BLOCK_FRAMES;
+        if (done >= stepsEnd && state.isPlaying)
+            setPlaying(false);
+        // No prefetch thread: reading ahead between blocks never lets it fall behind
+        sampleStreamerPrefetch(&streamer);
+        audioEngineRender(&audio, block, (int)frames);
+        ok = wavWriterWrite(&writer, block, (int)frames);
+    }
+    double elapsed = platformTimeSeconds() - start;
+    ok = wavWriterClose(&writer) && ok;
+    sessionFree(&session);
+
+    if (!ok)
+    {
+        fprintf(stderr, "Failed to write %s\n", outPath);
+        freeSamples();
+        return 1;
+    }
+    double seconds = (double)totalFrames / AUDIO_SAMPLE_RATE;
+    printf("Rendered %d bars (%.2f s) to %s in %.1f ms (%.0fx real time)\n",
+           bars, seconds, outPath, elapsed * 1000.0, elapsed > 0.0 ? seconds / elapsed : 0.0);
+    audioEnginePrintVoices(&audio, stdout);
+    freeSamples();
+    return 0;
+}
+
+// Picks the named backend, or the best one built in
+AudioSink *createSink(const char *name)
+{
+    const char *const *names = audioSinkNames();
+    AudioSink *sink = audioSinkCreateByName(name ? name : names[0]);
+    if (!sink)
+    {
+        fprintf(stderr, "Unknown audio sink '%s'; available:", name ? name : names[0]);
+        for (int i = 0; names[i]; i++)
+            fprintf(stderr, " %s", names[i]);
+        fprintf(stderr, "\n");
+    }
+    return sink;
+}
+
+// Live playback without a window: the real audio thread, paced by the sink,
+// for a fixed time. With the null or wav sink this runs on hosts with no
+// display or sound card.
+int playHeadless(const char *sinkName, const AudioSinkConfig *config, double seconds)
+{
+    if (useSamples && !loadSamples())
+    {
+        fprintf(stderr, "Failed to load samples\n");
+        return 1;
+    }
+    AudioSink *sink = createSink(sinkName);
+    if (!sink)
+    {
+        freeSamples();
+        return 1;
+    }
+
+    audioEngineInit(&audio);
+    audioEngineSetPolyphony(&audio, polyphony, stealPolicy);
+    audioEngineSetStreamer(&audio, &streamer);
+    sequencerInit(&sequencer, state.pattern.cols, state.tempo, playColumn, NULL);
+    if (!sessionInit(&session, &state.pattern, &sequencer, state.currentInstrument))
+    {
+        fprintf(stderr, "Out of memory copying the pattern\n");
+        audioSinkDestroy(sink);
+        freeSamples();
+        return 1;
+    }
+    audioEngineSetBlockCallback(&audio, sessionProcessBlock, &session);
+    if (!sampleStreamerStart(&streamer))
+        fprintf(stderr, "Failed to start the prefetch thread; long samples will underrun\n");
+    if (!audioEngineStart(&audio, sink, config))
+    {
+        fprintf(stderr, "Failed to open audio sink '%s'\n", sink->name);
+        audioSinkDestroy(sink);
+        sessionFree(&session);
+        freeSamples();
+        return 1;
+    }
+    printf("Playing through '%s': %d-frame periods x %d (%.1f ms buffered)\n",
+           sink->name, config->periodFrames, config->periodCount,
+           1000.0 * config->periodFrames * config->periodCount / config->sampleRate);
+
+    double start = platformTimeSeconds();
+    setPlaying(true);
+    audioEngineMark(&audio, AUDIO_MARK_START, start);
+    platformSleepMs((int)(seconds * 1000.0));
+    audioEngineStop(&audio);
+    double elapsed = platformTimeSeconds() - start;
+
+    int64_t frames = atomicLoad64(&audio.frameCounter);
+    printf("Rendered %.2f s of audio in %.2f s\n", (double)frames / config->sampleRate, elapsed);
+    audioEnginePrintStats(&audio, stdout);
+    audioSinkDestroy(sink);
+    sessionFree(&session);
+    freeSamples();
+    return 0;
 }
 
-int main(void)
+int main(int argc, char *argv[])
 {
+    traceInit();
+    TRACE_THREAD("main");
+
+    const char *renderPath = NULL;
+    const char *patternPath = NULL;
+    const char *projectPath = NULL;
+    const char *exportPath = NULL;
+    const char *outPath = "out.wav";
+    int bars = 0; // Whole pattern
+    int steps = GRID_COLS;
+    bool fullRange = false;
+    const char *serverName = NULL;
+    double lookaheadSeconds = SERVER_LOOKAHEAD_SECONDS;
+    const char *sinkName = NULL; // Best available
+    double headlessSeconds = 0.0;
+    bool traceAtExit = false;
+    double maxFps = 60.0;
+    AudioSinkConfig sinkConfig;
+    audioEngineDefaultConfig(&sinkConfig);
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--render") == 0 && i + 1 < argc)
+            renderPath = argv[++i];
+        else if (strcmp(argv[i], "--out") == 0 && i + 1 < argc)
+            outPath = argv[++i];
+        else if (strcmp(argv[i], "--bars") == 0 && i + 1 < argc)
+            bars = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--fps") == 0 && i + 1 < argc)
+            maxFps = atof(argv[++i]);
+        else if (strcmp(argv[i], "--pattern") == 0 && i + 1 < argc)
+            patternPath = argv[++i];
+        else if (strcmp(argv[i], "--project") == 0 && i + 1 < argc)
+            projectPath = argv[++i];
+        else if (strcmp(argv[i], "--export") == 0 && i + 1 < argc)
+            exportPath = argv[++i];
+        else if (strcmp(argv[i], "--midi-steps") == 0 && i + 1 < argc && atoi(argv[i + 1]) > 0)
+            midiStepsPerBeat = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--steps") == 0 && i + 1 < argc)
+            steps = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--full-range") == 0)
+            fullRange = true;
+        else if (strcmp(argv[i], "--samples") == 0)
+            useSamples = true;
+        else if (strcmp(argv[i], "--keymap") == 0 && i + 1 < argc)
+            keyMapPath = argv[++i];
+        else if (strcmp(argv[i], "--stream") == 0 && i + 1 < argc && atof(argv[i + 1]) >= 0.0)
+            streamSeconds = atof(argv[++i]);
+        else if (strcmp(argv[i], "--server") == 0)
+            serverName = i + 1 < argc && argv[i + 1][0] == '/' ? argv[++i] : EVENT_RING_DEFAULT_NAME;
+        else if (strcmp(argv[i], "--lookahead") == 0 && i + 1 < argc && atof(argv[i + 1]) > 0.0 &&
+                 atof(argv[i + 1]) / 1000.0 <= SERVER_LINK_MAX_LOOKAHEAD_SECONDS)
+            lookaheadSeconds = atof(argv[++i]) / 1000.0;
+        else if (strcmp(argv[i], "--sink") == 0 && i + 1 < argc)
+            sinkName = argv[++i];
+        else if (strcmp(argv[i], "--device") == 0 && i + 1 < argc)
+            sinkConfig.device = argv[++i];
+        else if (strcmp(argv[i], "--period") == 0 && i + 1 < argc)
+            sinkConfig.periodFrames = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--periods") == 0 && i + 1 < argc)
+            sinkConfig.periodCount = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--voices") == 0 && i + 1 < argc)
+            polyphony = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--steal") == 0 && i + 1 < argc && voiceStealPolicyParse(argv[i + 1], &stealPolicy))
+            i++;
+        else if (strcmp(argv[i], "--headless") == 0 && i + 1 < argc)
+            headlessSeconds = atof(argv[++i]);
+        else if (strcmp(argv[i], "--trace") == 0)
+        {
+            traceAtExit = true;
+            if (i + 1 < argc && argv[i + 1][0] != '-')
+                tracePath = argv[++i];
+        }
+        else
+        {
+            fprintf(stderr, "Usage: %s [--fps N] [--samples] [--server [/name] [--lookahead MS]] [--project file] [--pattern file | --steps N [--full-range]] [sink options]\n"
+                            "       %s [--samples] --headless SECONDS --pattern file [sink options]\n"
+                            "       %s [--samples] --render pattern.txt [--out out.wav] [--bars N]\n"
+                            "Sink options: --sink NAME --device DEV --period FRAMES --periods N\n"
+                            "--voices N (per pool, at most %d) --steal oldest|quietest|same-pitch\n"
+                            "--keymap file maps notes to root samples for --samples (default: %s for all)\n"
+                            "--stream SECONDS plays samples longer than this from disk (default %g, 0: never)\n"
+                            "--export file.pattern|file.mid writes the project or pattern and exits\n"
+                            "--midi-steps N sets the steps per beat of .mid patterns (default %d)\n"
+                            "--lookahead MS schedules --server steps this far ahead (default %g, at most %.0f)\n"
+                            "--trace [file.json] writes a Chrome trace on exit (default trace.json)\n",
+                    argv[0], argv[0], argv[0], VOICE_POOL_MAX_VOICES, KEYMAP_DEFAULT_ROOT,
+                    SAMPLE_BANK_STREAM_SECONDS, MIDI_DEFAULT_STEPS_PER_BEAT, SERVER_LOOKAHEAD_SECONDS * 1000.0,
+                    SERVER_LINK_MAX_LOOKAHEAD_SECONDS * 1000.0);
+            return 1;
+        }
+    }
+    bool created = fullRange ? patternInitChromatic(&state.pattern, 0, PATTERN_MAX_ROWS - 1, steps)
+                             : patternInitDefault(&state.pattern, steps);
+    if (!created)
+    {
+        fprintf(stderr, "Failed to allocate a pattern of %d steps\n", steps);
+        return -1;
+    }
+    if (renderPath)
+    {
+        int result = renderOffline(renderPath, outPath, bars);
+        patternFree(&state.pattern);
+        return result;
+    }
+    if (patternPath && !loadPattern(patternPath))
+    {
+        fprintf(stderr, "Failed to load pattern %s\n", patternPath);
+        patternFree(&state.pattern);
+        return -1;
+    }
+    if (projectPath)
+    {
+        // A new project starts from --pattern or --steps
+        double start = platformTimeSeconds();
+        if (!projectOpen(&project, projectPath, &state.pattern, &state.tempo, &state.currentInstrument))
+        {
+            patternFree(&state.pattern);
+            return -1;
+        }
+        if (project.exists)
+            printf("Opened %s in %.2f ms\n", projectPath, (platformTimeSeconds() - start) * 1000.0);
+        else
+            printf("New project %s; Ctrl+S saves it\n", projectPath);
+    }
+    if (exportPath)
+    {
+        bool exported = midiFileIsMidiPath(exportPath)
+                            ? midiFileExport(exportPath, &state.pattern, state.tempo, midiStepsPerBeat)
+                            : patternSaveText(exportPath, &state.pattern, state.tempo);
+        if (!exported)
+            fprintf(stderr, "Failed to write %s\n", exportPath);
+        projectClose(&project);
+        patternFree(&state.pattern);
+        return exported ? 0 : 1;
+    }
+    printf("Pattern: %d notes x %d steps, %d active (%.1f KiB)\n",
+           state.pattern.rows, state.pattern.cols, state.pattern.noteCount,
+           patternResidentBytes(&state.pattern) / 1024.0);
+    if (headlessSeconds > 0.0)
+    {
+        int result = playHeadless(sinkName, &sinkConfig, headlessSeconds);
+        if (traceAtExit)
+            traceWriteJson(tracePath);
+        projectClose(&project);
+        patternFree(&state.pattern);
+        return result;
+    }
+
+    // Start with C5 at the top when the pattern is taller than the window
+    int topRow = patternRowForPitch(&state.pattern, 72);
+    state.view.firstRow = topRow > 0 ? topRow : 0;
+    state.view.rows = state.pattern.rows < WINDOW_MAX_ROWS ? state.pattern.rows : WINDOW_MAX_ROWS;
+    state.view.cols = state.pattern.cols < WINDOW_MAX_COLS ? state.pattern.cols : WINDOW_MAX_COLS;
+    clampView();
+
     if (!glfwInit())
     {
         fprintf(stderr, "Failed to initialize GLFW\n");
         return -1;
     }
 
-    GLFWwindow *window = glfwCreateWindow(SCR_WIDTH, SCR_HEIGHT, "Music Grid Sequencer", NULL, NULL);
+    // Window dimensions, with extra space for labels
+    int windowWidth = state.view.cols * CELL_SIZE + 200;
+    int windowHeight = state.view.rows * CELL_SIZE + TIMELINE_HEIGHT + MENU_HEIGHT + 60;
+    glLoaderContextHints();
+    GLFWwindow *window = glfwCreateWindow(windowWidth, windowHeight, "Music Grid Sequencer", NULL, NULL);
     if (!window)
     {
         fprintf(stderr, "Failed to create GLFW window\n");
@@ -462,41 +1001,138 @@ int main(void)
     }
 
     glfwMakeContextCurrent(window);
+
+    if (!glLoaderInit() ||
+        !gridRendererInit(&gridRenderer, GRID_X, GRID_Y, CELL_SIZE) ||
+        !textRendererInit(&textRenderer))
+    {
+        fprintf(stderr, "Failed to initialize the renderers (needs OpenGL 3.3)\n");
+        glfwTerminate();
+        return -1;
+    }
+
     glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
     glfwSetMouseButtonCallback(window, mouse_button_callback);
     glfwSetCursorPosCallback(window, cursor_position_callback);
     glfwSetKeyCallback(window, key_callback);
+    glfwSetScrollCallback(window, scroll_callback);
+    glfwSetWindowRefreshCallback(window, window_refresh_callback);
+
+    if (useSamples && !loadSamples())
+        fprintf(stderr, "Failed to load samples\n");
+    audioEngineInit(&audio);
+    audioEngineSetPolyphony(&audio, polyphony, stealPolicy);
+    audioEngineSetStreamer(&audio, &streamer);
+    if (serverName)
+        sequencerInit(&sequencer, state.pattern.cols, state.tempo, sendColumn, &serverLink);
+    else
+        sequencerInit(&sequencer, state.pattern.cols, state.tempo, playColumn, NULL);
+    if (!sessionInit(&session, &state.pattern, &sequencer, state.currentInstrument))
+    {
+        fprintf(stderr, "Out of memory copying the pattern\n");
+        glfwTerminate();
+        return -1;
+    }
+    if (serverName)
+    {
+        // Steps go to sound_server.py; the local engine only plays previews
+        engineThreadRunning = serverLinkStart(&serverLink, serverName, &session, lookaheadSeconds);
+        if (!engineThreadRunning)
+            fprintf(stderr, "Failed to create event ring %s\n", serverName);
+        else
+            printf("Sending steps to sound_server.py --ring %s\n", serverName);
+    }
+    else
+    {
+        audioEngineSetBlockCallback(&audio, sessionProcessBlock, &session);
+    }
+    AudioSink *sink = createSink(sinkName);
+    if (!sampleStreamerStart(&streamer))
+        fprintf(stderr, "Failed to start the prefetch thread; long samples will underrun\n");
+    if (!audioEngineStart(&audio, sink, &sinkConfig))
+        fprintf(stderr, "Failed to start audio output, continuing without sound\n");
+    else if (!serverName)
+        engineThreadRunning = true;
 
     printf("Controls:\n");
     printf("- Click grid cells to toggle notes\n");
     printf("- Space: Play/Pause\n");
     printf("- Up/Down: Adjust tempo\n");
+    printf("- Wheel, Page Up/Down: Scroll notes\n");
+    printf("- Shift+wheel, Left/Right, Home: Scroll steps\n");
     printf("- Click 'Instrument' or press 1-3: Change instrument\n");
+    printf("- L: Print audio latency statistics\n");
+    printf("- T: Write a Chrome trace to %s\n", tracePath);
     printf("- ESC: Quit\n");
 
-    // Main loop
+    frameSchedulerInit(&scheduler, maxFps);
+    double animationInterval = 1.0 / (maxFps > 0.0 ? maxFps : 60.0);
+
+    // Main loop: sleeps until input, a playhead move or the next animation frame
     while (!glfwWindowShouldClose(window))
     {
+        // The playhead and the cell flash are time based; keep frames coming
+        // while playing and until the stopped playhead has been cleared
+        if (state.isPlaying || state.currentPlayColumn >= 0)
+            frameSchedulerRedrawAt(&scheduler, glfwGetTime() + animationInterval);
+        TRACE_BEGIN(wait, "wait events");
+        bool redraw = frameSchedulerWait(&scheduler);
+        TRACE_END(wait);
+        if (!redraw)
+            continue;
+
+        TRACE_BEGIN(frame, "frame");
+        frameSchedulerBeginFrame(&scheduler);
         glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
         glClear(GL_COLOR_BUFFER_BIT);
 
-        // Set up 2D projection
         int width, height;
         glfwGetFramebufferSize(window, &width, &height);
-        glMatrixMode(GL_PROJECTION);
-        glLoadIdentity();
-        glOrtho(0, width, height, 0, -1, 1);
-        glMatrixMode(GL_MODELVIEW);
-        glLoadIdentity();
+        resizeView(width, height);
 
+        TRACE_BEGIN(playback, "updatePlayback");
         updatePlayback();
-        drawInstrumentMenu();
-        drawGrid();
+        TRACE_END(playback);
+        // Grid and menu add their labels only when the batch is stale; all
+        // of it goes out in one draw call over the grid, the menu last so
+        // it covers the note names
+        bool rebuildLabels = beginLabels();
+        TRACE_BEGIN(grid, "drawGrid");
+        drawGrid(width, height, rebuildLabels);
+        TRACE_END(grid);
+        TRACE_BEGIN(menu, "drawInstrumentMenu");
+        drawInstrumentMenu(rebuildLabels);
+        TRACE_END(menu);
+        TRACE_BEGIN(text, "textRendererDraw");
+        textRendererDraw(&textRenderer, width, height);
+        TRACE_END(text);
 
+        TRACE_BEGIN(swap, "glfwSwapBuffers");
         glfwSwapBuffers(window);
-        glfwPollEvents();
+        TRACE_END(swap);
+        frameSchedulerEndFrame(&scheduler);
+        TRACE_END(frame);
     }
 
+    frameSchedulerPrintStats(&scheduler);
+    // Quitting keeps the edits
+    if (project.path && projectChanged(&project, &state.pattern, state.tempo, state.currentInstrument))
+        saveProject();
+    projectClose(&project);
+
+    serverLinkStop(&serverLink);
+    audioEngineStop(&audio);
+    if (sink)
+        audioEnginePrintStats(&audio, stdout);
+    if (traceAtExit)
+        traceWriteJson(tracePath);
+    audioSinkDestroy(sink);
+    sessionFree(&session);
+    freeSamples();
+
+    textRendererShutdown(&textRenderer);
+    gridRendererShutdown(&gridRenderer);
+    patternFree(&state.pattern);
     glfwTerminate();
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,529 @@
+#include "midi_file.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define DRUM_CHANNEL 9
+#define NO_PROGRAM 0xFF
+#define EXPORT_VELOCITY 100
+#define DEFAULT_TEMPO_MICROS 500000 // 120 BPM, the SMF default
+
+static const uint8_t EXPORT_PROGRAMS[NUM_INSTRUMENTS] = {0, 80, 14};
+
+// Reads through a fixed buffer, so memory does not grow with the file
+typedef struct
+{
+    FILE *file;
+    uint64_t base; // File offset of buffer[0]
+    size_t position;
+    size_t length;
+    bool truncated; // Read past the end
+    uint8_t buffer[MIDI_READ_BUFFER];
+} MidiReader;
+
+static void readerReset(MidiReader *reader)
+{
+    reader->base = 0;
+    reader->position = 0;
+    reader->length = 0;
+    reader->truncated = false;
+}
+
+static uint64_t readerOffset(const MidiReader *reader)
+{
+    return reader->base + reader->position;
+}
+
+static int readByteSlow(MidiReader *reader)
+{
+    reader->base += reader->length;
+    reader->position = 0;
+    reader->length = fread(reader->buffer, 1, sizeof(reader->buffer), reader->file);
+    if (reader->length == 0)
+    {
+        reader->truncated = true;
+        return -1;
+    }
+    return reader->buffer[reader->position++];
+}
+
+static inline int readByte(MidiReader *reader)
+{
+    if (reader->position < reader->length)
+        return reader->buffer[reader->position++];
+    return readByteSlow(reader);
+}
+
+static uint32_t readBig(MidiReader *reader, int bytes)
+{
+    uint32_t value = 0;
+    while (bytes-- > 0)
+        value = value << 8 | (uint8_t)readByte(reader);
+    return value;
+}
+
+// At most four bytes, 28 bits
+static uint32_t readVarLen(MidiReader *reader)
+{
+    uint32_t value = 0;
+    for (int i = 0; i < 4; i++)
+    {
+        int byte = readByte(reader);
+        if (byte < 0)
+            return 0;
+        value = value << 7 | (uint32_t)(byte & 0x7F);
+        if (!(byte & 0x80))
+            return value;
+    }
+    reader->truncated = true; // Malformed; stop the same way
+    return 0;
+}
+
+static void skip(MidiReader *reader, uint64_t bytes)
+{
+    size_t buffered = reader->length - reader->position;
+    if (bytes <= buffered)
+    {
+        reader->position += (size_t)bytes;
+        return;
+    }
+    // Seek over the rest, dropping the buffer
+    bytes -= buffered;
+    reader->base += reader->length + bytes;
+    reader->position = 0;
+    reader->length = 0;
+    if (fseek(reader->file, (long)reader->base, SEEK_SET) != 0)
+        reader->truncated = true;
+}
+
+typedef struct
+{
+    const char *path;
+    int stepsPerBeat;
+    int division;
+    bool place; // Second pass: set the notes
+
+    // First pass
+    bool seenPitch[PATTERN_MAX_ROWS];
+    int64_t lastStep; // -1 until a note is seen
+    uint64_t endStep; // Latest End of Track, so trailing rests survive
+    uint32_t tempoMicros; // First tempo event, 0 if none
+
+    // Second pass
+    int8_t rowOfPitch[PATTERN_MAX_ROWS];
+    bool tempoSeen;
+    Pattern *pattern;
+    MidiImportStats *stats;
+} MidiImport;
+
+static Instrument instrumentForProgram(uint8_t program)
+{
+    if (program == NO_PROGRAM || program < 8)
+        return PIANO;
+    if (program < 16)
+        return BELL;
+    return SYNTH;
+}
+
+// Nearest step
+static uint64_t stepForTick(const MidiImport *import, uint64_t tick)
+{
+    return (tick * (uint64_t)import->stepsPerBeat + (uint64_t)import->division / 2) / (uint64_t)import->division;
+}
+
+static bool noteOn(MidiImport *import, int channel, int pitch, uint64_t tick, uint8_t program)
+{
+    MidiImportStats *stats = import->stats;
+    if (channel == DRUM_CHANNEL)
+    {
+        if (import->place)
+            stats->drumNotes++;
+        return true;
+    }
+    uint64_t step = stepForTick(import, tick);
+    if (step >= PATTERN_MAX_COLS)
+    {
+        if (import->place)
+            stats->lateNotes++;
+        return true;
+    }
+
+    if (!import->place)
+    {
+        import->seenPitch[pitch] = true;
+        if ((int64_t)step > import->lastStep)
+            import->lastStep = (int64_t)step;
+        return true;
+    }
+
+    // The first note-on to land on a cell keeps it
+    int row = import->rowOfPitch[pitch];
+    if (patternIsActive(import->pattern, row, (int)step))
+    {
+        stats->merged++;
+        return true;
+    }
+    stats->notes++;
+    return patternSet(import->pattern, row, (int)step, true, instrumentForProgram(program));
+}
+
+static void tempoEvent(MidiImport *import, uint32_t micros)
+{
+    if (!import->place)
+    {
+        if (import->tempoMicros == 0)
+            import->tempoMicros = micros;
+    }
+    else if (import->tempoSeen)
+    {
+        import->stats->tempoChanges++;
+    }
+    import->tempoSeen = true;
+}
+
+// One MTrk chunk, ending at `end`
+static bool readTrack(MidiReader *reader, MidiImport *import, uint64_t end)
+{
+    uint8_t programs[16];
+    memset(programs, NO_PROGRAM, sizeof(programs));
+    uint64_t tick = 0;
+    int status = 0; // Running status, 0 when there is none
+
+    while (readerOffset(reader) < end)
+    {
+        tick += readVarLen(reader);
+        int byte = readByte(reader);
+        if (reader->truncated)
+            return false;
+        import->stats->events++;
+
+        if (byte == 0xFF)
+        {
+            int type = readByte(reader);
+            uint32_t length = readVarLen(reader);
+            if (type == 0x51 && length == 3)
+            {
+                tempoEvent(import, readBig(reader, 3));
+                length = 0;
+            }
+            skip(reader, length);
+            status = 0; // Meta and sysex events cancel running status
+            if (type == 0x2F)
+            {
+                uint64_t step = stepForTick(import, tick);
+                if (step > import->endStep)
+                    import->endStep = step;
+                break;
+            }
+            continue;
+        }
+        if (byte == 0xF0 || byte == 0xF7)
+        {
+            skip(reader, readVarLen(reader));
+            status = 0;
+            continue;
+        }
+        if (byte >= 0xF0)
+            return false; // System common and real-time messages have no place in a file
+
+        int data1;
+        if (byte & 0x80)
+        {
+            status = byte;
+            data1 = readByte(reader);
+        }
+        else if (status != 0)
+        {
+            data1 = byte;
+        }
+        else
+        {
+            return false;
+        }
+        int type = status & 0xF0;
+        int channel = status & 0x0F;
+        int data2 = type == 0xC0 || type == 0xD0 ? 0 : readByte(reader);
+        if (reader->truncated || (data1 | data2) & 0x80)
+            return false;
+
+        if (type == 0x90 && data2 > 0)
+        {
+            if (!noteOn(import, channel, data1, tick, programs[channel]))
+                return false;
+        }
+        else if (type == 0xC0)
+        {
+            programs[channel] = (uint8_t)data1;
+        }
+    }
+
+    // Past End of Track, if anything; a track that overran its length is broken
+    uint64_t offset = readerOffset(reader);
+    if (offset > end)
+        return false;
+    skip(reader, end - offset);
+    return !reader->truncated;
+}
+
+static bool readFile(MidiReader *reader, MidiImport *import)
+{
+    MidiImportStats *stats = import->stats;
+    char id[4];
+    for (int i = 0; i < 4; i++)
+        id[i] = (char)readByte(reader);
+    uint32_t length = readBig(reader, 4);
+    if (reader->truncated || memcmp(id, "MThd", 4) != 0 || length < 6)
+    {
+        fprintf(stderr, "%s: not a Standard MIDI File\n", import->path);
+        return false;
+    }
+    stats->format = (int)readBig(reader, 2);
+    readBig(reader, 2); // Track count; we read every MTrk there is
+    int division = (int)readBig(reader, 2);
+    skip(reader, length - 6);
+    if (division & 0x8000 || division == 0)
+    {
+        fprintf(stderr, "%s: SMPTE time division is not supported\n", import->path);
+        return false;
+    }
+    stats->division = import->division = division;
+
+    // Chunks until the end of the file; unknown ones are skipped
+    for (;;)
+    {
+        int first = readByte(reader);
+        if (first < 0)
+            return true;
+        id[0] = (char)first;
+        for (int i = 1; i < 4; i++)
+            id[i] = (char)readByte(reader);
+        length = readBig(reader, 4);
+        if (reader->truncated)
+            break;
+        uint64_t end = readerOffset(reader) + length;
+        if (memcmp(id, "MTrk", 4) != 0)
+        {
+            skip(reader, length);
+            continue;
+        }
+        stats->tracks++;
+        if (!readTrack(reader, import, end))
+            break;
+    }
+    fprintf(stderr, "%s: malformed or truncated track %d\n", import->path, stats->tracks);
+    return false;
+}
+
+bool midiFileImport(const char *path, int stepsPerBeat, Pattern *pattern, float *tempo, MidiImportStats *stats)
+{
+    FILE *file = fopen(path, "rb");
+    if (!file)
+        return false;
+    MidiReader *reader = malloc(sizeof(MidiReader));
+    MidiImport *import = calloc(1, sizeof(MidiImport));
+    if (!reader || !import)
+    {
+        free(reader);
+        free(import);
+        fclose(file);
+        return false;
+    }
+
+    // First pass sizes the pattern, second pass fills it
+    reader->file = file;
+    readerReset(reader);
+    memset(stats, 0, sizeof(*stats));
+    import->path = path;
+    import->stepsPerBeat = stepsPerBeat;
+    import->lastStep = -1;
+    import->stats = stats;
+    bool ok = readFile(reader, import);
+    if (ok && import->lastStep < 0)
+    {
+        fprintf(stderr, "%s: no notes\n", path);
+        ok = false;
+    }
+    uint32_t micros = import->tempoMicros ? import->tempoMicros : DEFAULT_TEMPO_MICROS;
+    float fileTempo = 60e6f / (float)micros * (float)stepsPerBeat;
+    if (ok && !patternTempoValid(fileTempo))
+    {
+        fprintf(stderr, "%s: tempo of %.0f steps per minute, must be at most %.0f\n", path, fileTempo,
+                PATTERN_MAX_TEMPO);
+        ok = false;
+    }
+
+    Pattern loaded = {0};
+    if (ok)
+    {
+        uint8_t pitches[PATTERN_MAX_ROWS];
+        int rows = 0;
+        for (int pitch = PATTERN_MAX_ROWS - 1; pitch >= 0; pitch--)
+        {
+            if (!import->seenPitch[pitch])
+                continue;
+            import->rowOfPitch[pitch] = (int8_t)rows;
+            pitches[rows++] = (uint8_t)pitch;
+        }
+        uint64_t cols = (uint64_t)import->lastStep + 1;
+        if (import->endStep > cols)
+            cols = import->endStep < PATTERN_MAX_COLS ? import->endStep : PATTERN_MAX_COLS;
+        ok = patternInit(&loaded, pitches, rows, (int)cols);
+    }
+    if (ok)
+    {
+        rewind(file);
+        readerReset(reader);
+        memset(stats, 0, sizeof(*stats));
+        import->place = true;
+        import->tempoSeen = false;
+        import->pattern = &loaded;
+        ok = readFile(reader, import);
+    }
+
+    if (ok)
+    {
+        patternFree(pattern);
+        *pattern = loaded;
+        *tempo = fileTempo;
+    }
+    else if (loaded.pages)
+    {
+        patternFree(&loaded);
+    }
+    free(import);
+    free(reader);
+    fclose(file);
+    return ok;
+}
+
+// Track events with running status, so runs of note-ons on one channel
+// cost three bytes or fewer each
+typedef struct
+{
+    FILE *file;
+    uint64_t tick;
+    int status;
+} MidiWriter;
+
+static void writeBig(FILE *file, uint32_t value, int bytes)
+{
+    while (bytes-- > 0)
+        putc((int)(value >> (bytes * 8)) & 0xFF, file);
+}
+
+static void writeVarLen(FILE *file, uint32_t value)
+{
+    uint8_t bytes[5];
+    int count = 0;
+    bytes[count++] = value & 0x7F;
+    while (value >>= 7)
+        bytes[count++] = 0x80 | (value & 0x7F);
+    while (count > 0)
+        putc(bytes[--count], file);
+}
+
+static void writeDelta(MidiWriter *writer, uint64_t tick)
+{
+    writeVarLen(writer->file, (uint32_t)(tick - writer->tick));
+    writer->tick = tick;
+}
+
+static void writeEvent(MidiWriter *writer, uint64_t tick, int status, int data1, int data2)
+{
+    writeDelta(writer, tick);
+    if (status != writer->status)
+        putc(status, writer->file);
+    writer->status = status;
+    putc(data1, writer->file);
+    if (data2 >= 0)
+        putc(data2, writer->file);
+}
+
+static void writeMeta(MidiWriter *writer, uint64_t tick, int type, uint32_t value, int bytes)
+{
+    writeDelta(writer, tick);
+    putc(0xFF, writer->file);
+    putc(type, writer->file);
+    writeVarLen(writer->file, (uint32_t)bytes);
+    writeBig(writer->file, value, bytes);
+    writer->status = 0;
+}
+
+// Note-on, or with velocity 0 note-off, for every cell of a column
+static void writeColumn(MidiWriter *writer, const Pattern *pattern, int col, uint64_t tick, int velocity)
+{
+    PatternColumnIter it;
+    patternColumnBegin(pattern, col, &it);
+    int row;
+    Instrument instrument;
+    while (patternColumnNext(&it, &row, &instrument))
+        writeEvent(writer, tick, 0x90 | (int)instrument, pattern->rowPitch[row], velocity);
+}
+
+bool midiFileExport(const char *path, const Pattern *pattern, float tempo, int stepsPerBeat)
+{
+    FILE *file = fopen(path, "wb");
+    if (!file)
+        return false;
+    setvbuf(file, NULL, _IOFBF, MIDI_READ_BUFFER);
+
+    fwrite("MThd", 1, 4, file);
+    writeBig(file, 6, 4);
+    writeBig(file, 0, 2); // Format 0: one track
+    writeBig(file, 1, 2);
+    writeBig(file, MIDI_EXPORT_DIVISION, 2);
+    fwrite("MTrk", 1, 4, file);
+    long lengthOffset = ftell(file);
+    writeBig(file, 0, 4); // Patched below
+
+    MidiWriter writer = {file, 0, 0};
+    double beatsPerMinute = tempo > 0.0f ? (double)tempo / stepsPerBeat : 120.0;
+    double micros = round(60e6 / beatsPerMinute);
+    writeMeta(&writer, 0, 0x51, (uint32_t)fmin(fmax(micros, 1.0), 0xFFFFFF), 3);
+    for (int i = 0; i < NUM_INSTRUMENTS; i++)
+        writeEvent(&writer, 0, 0xC0 | i, EXPORT_PROGRAMS[i], -1);
+
+    // Each column's note-offs go out one step later, before the next
+    // column's note-ons; empty pages are skipped whole
+    int previous = -1;
+    for (int col = 0; col < pattern->cols; col++)
+    {
+        if (!patternPage(pattern, col))
+        {
+            col |= PATTERN_PAGE_COLS - 1;
+            continue;
+        }
+        const PatternPage *page = patternPage(pattern, col);
+        int index = col % PATTERN_PAGE_COLS;
+        if (page->firstNote[index] == page->firstNote[index + 1])
+            continue;
+        if (previous >= 0)
+            writeColumn(&writer, pattern, previous, (uint64_t)(previous + 1) * MIDI_EXPORT_DIVISION / stepsPerBeat, 0);
+        writeColumn(&writer, pattern, col, (uint64_t)col * MIDI_EXPORT_DIVISION / stepsPerBeat, EXPORT_VELOCITY);
+        previous = col;
+    }
+    if (previous >= 0)
+        writeColumn(&writer, pattern, previous, (uint64_t)(previous + 1) * MIDI_EXPORT_DIVISION / stepsPerBeat, 0);
+    // At the pattern's end, so the length survives a round trip
+    writeMeta(&writer, (uint64_t)pattern->cols * MIDI_EXPORT_DIVISION / stepsPerBeat, 0x2F, 0, 0);
+
+    long end = ftell(file);
+    bool ok = !ferror(file) && lengthOffset >= 0 && end >= 0 && fseek(file, lengthOffset, SEEK_SET) == 0;
+    if (ok)
+        writeBig(file, (uint32_t)(end - lengthOffset - 4), 4);
+    ok = ok && !ferror(file);
+    return fclose(file) == 0 && ok;
+}
+
+bool midiFileIsMidiPath(const char *path)
+{
+    const char *dot = strrchr(path, '.');
+    if (!dot)
+        return false;
+    char suffix[6] = {0};
+    for (int i = 0; i < 5 && dot[i + 1]; i++)
+        suffix[i] = (char)(dot[i + 1] | 0x20);
+    return strlen(dot + 1) <= 4 && (strcmp(suffix, "mid") == 0 || strcmp(suffix, "midi") == 0);
+}
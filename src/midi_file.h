@@ -0,0 +1,53 @@
+#ifndef MIDI_FILE_H
+#define MIDI_FILE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "pattern.h"
+
+// Standard MIDI Files in and out of the pattern store. Import streams the
+// file through a fixed buffer twice, like the text loader: the first pass
+// finds the pitches, the length and the tempo, the second places the notes.
+// Memory stays bounded by the buffer and the pattern, whatever the file
+// size, and time is linear in it. Note-ons are quantized to the nearest of
+// `stepsPerBeat` steps per quarter note; durations are dropped, since a
+// cell is a one-shot. The pattern gets one row per pitch used, highest
+// first, runs to the last note or End of Track, whichever is later, and
+// its tempo is in steps per minute (BPM x stepsPerBeat).
+//
+// Instruments travel as channels and General MIDI programs: export puts
+// piano, synth and bell on channels 1-3 with programs 0 (Acoustic Grand),
+// 80 (Square Lead) and 14 (Tubular Bells). Import maps the program last set
+// on the channel by family: pianos (and channels that never got a program,
+// as in General MIDI) play piano, chromatic percussion plays bell, the
+// rest synth. Channel 10 is drums and is skipped.
+
+#define MIDI_DEFAULT_STEPS_PER_BEAT 4
+#define MIDI_EXPORT_DIVISION 480 // Ticks per quarter note
+#define MIDI_READ_BUFFER 65536
+
+typedef struct
+{
+    int format;
+    int tracks;
+    int division;        // Ticks per quarter note
+    int64_t events;      // Channel, meta and sysex events read
+    int64_t notes;       // Note-ons placed in the pattern
+    int64_t merged;      // Landed on a cell another note-on already took
+    int64_t drumNotes;   // Skipped on channel 10
+    int64_t lateNotes;   // Past PATTERN_MAX_COLS steps
+    int tempoChanges;    // After the first; the pattern has one tempo
+} MidiImportStats;
+
+// Replaces pattern and tempo on success. Prints why and changes nothing on
+// failure, which includes a tempo patternTempoValid rejects.
+bool midiFileImport(const char *path, int stepsPerBeat, Pattern *pattern, float *tempo, MidiImportStats *stats);
+
+// A format 0 file: each cell a note one step long at velocity 100
+bool midiFileExport(const char *path, const Pattern *pattern, float tempo, int stepsPerBeat);
+
+// For picking a loader: ends in ".mid" or ".midi", any case
+bool midiFileIsMidiPath(const char *path);
+
+#endif // MIDI_FILE_H
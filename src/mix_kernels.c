@@ -0,0 +1,170 @@
+#include "mix_kernels.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#define MIX_KERNELS_X86 1
+#include <emmintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+static void mixAddScalar(float *dst, const float *src, float gain, int frames)
+{
+    for (int i = 0; i < frames; i++)
+        dst[i] += src[i] * gain;
+}
+
+static void toS16Scalar(int16_t *dst, const float *src, int frames)
+{
+    for (int i = 0; i < frames; i++)
+    {
+        float s = src[i];
+        if (s > 1.0f)
+            s = 1.0f;
+        else if (s < -1.0f)
+            s = -1.0f;
+        dst[i] = (int16_t)(s * 32767.0f);
+    }
+}
+
+#define RESAMPLE_FIRST_TAP (MIX_RESAMPLE_TAPS / 2 - 1)
+#define RESAMPLE_PHASE_SHIFT (32 - MIX_RESAMPLE_PHASE_BITS)
+#define RESAMPLE_PHASE_MASK ((1u << MIX_RESAMPLE_PHASE_BITS) - 1)
+
+static void mixResampleScalar(float *dst, const float *src, uint64_t position, uint64_t step,
+                              const float *filter, float gain, int frames)
+{
+    for (int i = 0; i < frames; i++)
+    {
+        const float *in = src + (int64_t)(position >> 32) - RESAMPLE_FIRST_TAP;
+        const float *taps = filter + ((position >> RESAMPLE_PHASE_SHIFT) & RESAMPLE_PHASE_MASK) * MIX_RESAMPLE_TAPS;
+        float sum = 0.0f;
+        for (int k = 0; k < MIX_RESAMPLE_TAPS; k++)
+            sum += in[k] * taps[k];
+        dst[i] += sum * gain;
+        position += step;
+    }
+}
+
+static const MixKernels SCALAR_KERNELS = {"scalar", mixAddScalar, toS16Scalar, mixResampleScalar};
+
+#ifdef MIX_KERNELS_X86
+static void mixAddSse2(float *dst, const float *src, float gain, int frames)
+{
+    __m128 g = _mm_set1_ps(gain);
+    int i = 0;
+    for (; i + 8 <= frames; i += 8)
+    {
+        __m128 a = _mm_add_ps(_mm_loadu_ps(dst + i), _mm_mul_ps(_mm_loadu_ps(src + i), g));
+        __m128 b = _mm_add_ps(_mm_loadu_ps(dst + i + 4), _mm_mul_ps(_mm_loadu_ps(src + i + 4), g));
+        _mm_storeu_ps(dst + i, a);
+        _mm_storeu_ps(dst + i + 4, b);
+    }
+    mixAddScalar(dst + i, src + i, gain, frames - i);
+}
+
+static void toS16Sse2(int16_t *dst, const float *src, int frames)
+{
+    const __m128 lo = _mm_set1_ps(-1.0f);
+    const __m128 hi = _mm_set1_ps(1.0f);
+    const __m128 scale = _mm_set1_ps(32767.0f);
+    int i = 0;
+    for (; i + 8 <= frames; i += 8)
+    {
+        __m128 a = _mm_mul_ps(_mm_min_ps(_mm_max_ps(_mm_loadu_ps(src + i), lo), hi), scale);
+        __m128 b = _mm_mul_ps(_mm_min_ps(_mm_max_ps(_mm_loadu_ps(src + i + 4), lo), hi), scale);
+        __m128i packed = _mm_packs_epi32(_mm_cvttps_epi32(a), _mm_cvttps_epi32(b));
+        _mm_storeu_si128((__m128i *)(dst + i), packed);
+    }
+    toS16Scalar(dst + i, src + i, frames - i);
+}
+
+// Four output frames at a time: one dot product per register, then a
+// transpose sums the four registers across
+static void mixResampleSse2(float *dst, const float *src, uint64_t position, uint64_t step,
+                            const float *filter, float gain, int frames)
+{
+    __m128 g = _mm_set1_ps(gain);
+    int i = 0;
+    for (; i + 4 <= frames; i += 4)
+    {
+        __m128 sums[4];
+        for (int j = 0; j < 4; j++)
+        {
+            const float *in = src + (int64_t)(position >> 32) - RESAMPLE_FIRST_TAP;
+            const float *taps = filter + ((position >> RESAMPLE_PHASE_SHIFT) & RESAMPLE_PHASE_MASK) * MIX_RESAMPLE_TAPS;
+            __m128 a = _mm_mul_ps(_mm_loadu_ps(in), _mm_load_ps(taps));
+            __m128 b = _mm_mul_ps(_mm_loadu_ps(in + 4), _mm_load_ps(taps + 4));
+            a = _mm_add_ps(a, _mm_mul_ps(_mm_loadu_ps(in + 8), _mm_load_ps(taps + 8)));
+            b = _mm_add_ps(b, _mm_mul_ps(_mm_loadu_ps(in + 12), _mm_load_ps(taps + 12)));
+            sums[j] = _mm_add_ps(a, b);
+            position += step;
+        }
+        _MM_TRANSPOSE4_PS(sums[0], sums[1], sums[2], sums[3]);
+        __m128 total = _mm_add_ps(_mm_add_ps(sums[0], sums[1]), _mm_add_ps(sums[2], sums[3]));
+        _mm_storeu_ps(dst + i, _mm_add_ps(_mm_loadu_ps(dst + i), _mm_mul_ps(total, g)));
+    }
+    mixResampleScalar(dst + i, src, position, step, filter, gain, frames - i);
+}
+
+static const MixKernels SSE2_KERNELS = {"sse2", mixAddSse2, toS16Sse2, mixResampleSse2};
+
+// Compiled with AVX2 enabled in mix_kernels_avx2.c
+void mixAddAvx2(float *dst, const float *src, float gain, int frames);
+void toS16Avx2(int16_t *dst, const float *src, int frames);
+void mixResampleAvx2(float *dst, const float *src, uint64_t position, uint64_t step,
+                     const float *filter, float gain, int frames);
+
+static const MixKernels AVX2_KERNELS = {"avx2", mixAddAvx2, toS16Avx2, mixResampleAvx2};
+
+static bool cpuHasAvx2(void)
+{
+#ifdef _MSC_VER
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7)
+        return false;
+    __cpuid(info, 1);
+    bool osxsave = (info[2] & (1 << 27)) != 0;
+    bool avx = (info[2] & (1 << 28)) != 0;
+    if (!osxsave || !avx || (_xgetbv(0) & 6) != 6) // OS saves YMM state
+        return false;
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#else
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2");
+#endif
+}
+#endif
+
+const MixKernels *mixKernelsByName(const char *name)
+{
+    if (strcmp(name, "scalar") == 0)
+        return &SCALAR_KERNELS;
+#ifdef MIX_KERNELS_X86
+    if (strcmp(name, "sse2") == 0)
+        return &SSE2_KERNELS;
+    if (strcmp(name, "avx2") == 0)
+        return cpuHasAvx2() ? &AVX2_KERNELS : NULL;
+#endif
+    return NULL;
+}
+
+const MixKernels *mixKernels(void)
+{
+    static const MixKernels *selected;
+    if (!selected)
+    {
+#ifdef MIX_KERNELS_X86
+        selected = cpuHasAvx2() ? &AVX2_KERNELS : &SSE2_KERNELS;
+#else
+        selected = &SCALAR_KERNELS;
+#endif
+    }
+    return selected;
+}
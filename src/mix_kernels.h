@@ -0,0 +1,42 @@
+#ifndef MIX_KERNELS_H
+#define MIX_KERNELS_H
+
+#include <stdint.h>
+
+// Inner loops of the audio path. The scalar set is the reference; the
+// vector sets must produce bit-identical int16 output and float sums that
+// match it to rounding. Pointers need no particular alignment.
+
+// dst[i] += src[i] * gain
+typedef void (*MixAddFn)(float *dst, const float *src, float gain, int frames);
+// dst[i] = (int16_t)(clamp(src[i], -1, 1) * 32767), truncating
+typedef void (*ConvertS16Fn)(int16_t *dst, const float *src, int frames);
+
+// Polyphase FIR resampling: `position` is a 32.32 fixed-point frame
+// position in src, advanced by `step` per output frame. Each output frame
+// adds gain x the dot product of the MIX_RESAMPLE_TAPS source frames from
+// (position >> 32) - MIX_RESAMPLE_TAPS / 2 + 1 on with the filter row of
+// the position's phase, the top MIX_RESAMPLE_PHASE_BITS of its fraction.
+// `filter` holds 1 << MIX_RESAMPLE_PHASE_BITS rows of MIX_RESAMPLE_TAPS
+// floats, 16-byte aligned. Reads up to MIX_RESAMPLE_TAPS / 2 frames either
+// side of the positions visited.
+#define MIX_RESAMPLE_TAPS 16
+#define MIX_RESAMPLE_PHASE_BITS 8
+typedef void (*MixResampleFn)(float *dst, const float *src, uint64_t position, uint64_t step,
+                              const float *filter, float gain, int frames);
+
+typedef struct
+{
+    const char *name;
+    MixAddFn mixAdd;
+    ConvertS16Fn toS16;
+    MixResampleFn mixResample;
+} MixKernels;
+
+// Best set the CPU supports, chosen on first call
+const MixKernels *mixKernels(void);
+
+// "scalar", "sse2" or "avx2"; NULL if unknown or unsupported on this CPU
+const MixKernels *mixKernelsByName(const char *name);
+
+#endif // MIX_KERNELS_H
@@ -0,0 +1,470 @@
+#include "pattern.h"
+
+#include <ctype.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// C major, top row first
+const uint8_t DEFAULT_ROW_PITCHES[GRID_ROWS] = {72, 71, 69, 67, 65, 64, 62, 60};
+
+const char *SAMPLE_NOTE_NAMES[SAMPLE_NOTE_COUNT] = {
+    "C5", "B4", "A4", "G4", "F4", "E4", "D4", "C4"};
+
+const char *INSTRUMENT_NAMES[NUM_INSTRUMENTS] = {
+    "Piano",
+    "Synth",
+    "Bell"};
+
+// Sample directories under sounds/
+const char *INSTRUMENT_DIRS[NUM_INSTRUMENTS] = {
+    "piano",
+    "synth",
+    "bell"};
+
+static const char INSTRUMENT_LETTERS[NUM_INSTRUMENTS] = {'p', 's', 'b'};
+
+static const char *PITCH_CLASS_NAMES[12] = {
+    "C", "C#", "D", "D#", "E", "F", "F#", "G", "G#", "A", "A#", "B"};
+
+int noteParse(const char *name)
+{
+    static const int NATURAL_CLASSES[7] = {9, 11, 0, 2, 4, 5, 7}; // A..G
+    char letter = (char)toupper((unsigned char)name[0]);
+    if (letter < 'A' || letter > 'G')
+        return -1;
+    int pitchClass = NATURAL_CLASSES[letter - 'A'];
+    const char *p = name + 1;
+    if (*p == '#')
+    {
+        pitchClass++;
+        p++;
+    }
+
+    // MIDI 60 is C4, so octave -1 starts at 0
+    char *end;
+    long octave = strtol(p, &end, 10);
+    if (end == p || *end != '\0')
+        return -1;
+    long pitch = (octave + 1) * 12 + pitchClass;
+    return pitch >= 0 && pitch < PATTERN_MAX_ROWS ? (int)pitch : -1;
+}
+
+void noteName(int pitch, char *buffer, size_t size)
+{
+    snprintf(buffer, size, "%s%d", PITCH_CLASS_NAMES[pitch % 12], pitch / 12 - 1);
+}
+
+float noteFrequency(int pitch)
+{
+    return 440.0f * powf(2.0f, (float)(pitch - 69) / 12.0f);
+}
+
+bool patternInit(Pattern *pattern, const uint8_t *rowPitches, int rows, int cols)
+{
+    memset(pattern, 0, sizeof(*pattern));
+    if (rows < 1 || rows > PATTERN_MAX_ROWS || cols < 1 || cols > PATTERN_MAX_COLS)
+        return false;
+    pattern->pageCount = (cols + PATTERN_PAGE_COLS - 1) / PATTERN_PAGE_COLS;
+    pattern->pages = calloc((size_t)pattern->pageCount, sizeof(PatternPage *));
+    if (!pattern->pages)
+        return false;
+    pattern->rows = rows;
+    pattern->cols = cols;
+    memcpy(pattern->rowPitch, rowPitches, (size_t)rows);
+    return true;
+}
+
+bool patternInitDefault(Pattern *pattern, int cols)
+{
+    return patternInit(pattern, DEFAULT_ROW_PITCHES, GRID_ROWS, cols);
+}
+
+bool patternInitChromatic(Pattern *pattern, int lowPitch, int highPitch, int cols)
+{
+    uint8_t pitches[PATTERN_MAX_ROWS];
+    if (lowPitch < 0 || highPitch >= PATTERN_MAX_ROWS || lowPitch > highPitch)
+        return false;
+    int rows = highPitch - lowPitch + 1;
+    for (int row = 0; row < rows; row++)
+        pitches[row] = (uint8_t)(highPitch - row);
+    return patternInit(pattern, pitches, rows, cols);
+}
+
+static int pageNoteCount(const PatternPage *page)
+{
+    return page ? page->firstNote[PATTERN_PAGE_COLS] : 0;
+}
+
+PatternPage *patternPageCopy(const PatternPage *page)
+{
+    PatternPage *copy = malloc(sizeof(PatternPage));
+    uint8_t *instruments = malloc((size_t)page->capacity);
+    if (!copy || !instruments)
+    {
+        free(copy);
+        free(instruments);
+        return NULL;
+    }
+    *copy = *page;
+    memcpy(instruments, page->instruments, (size_t)page->capacity);
+    copy->instruments = instruments;
+    return copy;
+}
+
+void patternPageFree(PatternPage *page)
+{
+    if (!page)
+        return;
+    free(page->instruments);
+    free(page);
+}
+
+static void freePage(Pattern *pattern, int index)
+{
+    patternPageFree(pattern->pages[index]);
+    pattern->pages[index] = NULL;
+}
+
+void patternFree(Pattern *pattern)
+{
+    if (pattern->pages)
+    {
+        for (int i = 0; i < pattern->pageCount; i++)
+            freePage(pattern, i);
+        free(pattern->pages);
+    }
+    memset(pattern, 0, sizeof(*pattern));
+}
+
+bool patternCopy(Pattern *dst, const Pattern *src)
+{
+    if (!patternInit(dst, src->rowPitch, src->rows, src->cols))
+        return false;
+    for (int i = 0; i < src->pageCount; i++)
+    {
+        if (!src->pages[i])
+            continue;
+        dst->pages[i] = patternPageCopy(src->pages[i]);
+        if (!dst->pages[i])
+        {
+            patternFree(dst);
+            return false;
+        }
+    }
+    dst->noteCount = src->noteCount;
+    dst->version = src->version;
+    return true;
+}
+
+void patternClear(Pattern *pattern)
+{
+    for (int i = 0; i < pattern->pageCount; i++)
+        freePage(pattern, i);
+    pattern->noteCount = 0;
+    pattern->version++;
+}
+
+bool patternSet(Pattern *pattern, int row, int col, bool active, Instrument instrument)
+{
+    int pageIndex = col / PATTERN_PAGE_COLS;
+    int pageCol = col % PATTERN_PAGE_COLS;
+    PatternPage *page = pattern->pages[pageIndex];
+    if (!page)
+    {
+        if (!active)
+            return true;
+        page = calloc(1, sizeof(PatternPage));
+        if (!page)
+            return false;
+        pattern->pages[pageIndex] = page;
+    }
+
+    uint64_t *word = &page->occupancy[pageCol][row / 64];
+    uint64_t bit = (uint64_t)1 << (row % 64);
+    int rank = patternNoteRank(page, row, col);
+    int pageNotes = page->firstNote[PATTERN_PAGE_COLS];
+
+    if (*word & bit)
+    {
+        if (active)
+        {
+            page->instruments[rank] = (uint8_t)instrument;
+        }
+        else
+        {
+            memmove(page->instruments + rank, page->instruments + rank + 1, (size_t)(pageNotes - rank - 1));
+            *word &= ~bit;
+            for (int c = pageCol + 1; c <= PATTERN_PAGE_COLS; c++)
+                page->firstNote[c]--;
+            pattern->noteCount--;
+            if (pageNotes == 1)
+                freePage(pattern, pageIndex);
+        }
+    }
+    else if (active)
+    {
+        if (pageNotes == page->capacity)
+        {
+            int capacity = page->capacity ? page->capacity * 2 : 16;
+            uint8_t *instruments = realloc(page->instruments, (size_t)capacity);
+            if (!instruments)
+                return false;
+            page->instruments = instruments;
+            page->capacity = capacity;
+        }
+        memmove(page->instruments + rank + 1, page->instruments + rank, (size_t)(pageNotes - rank));
+        page->instruments[rank] = (uint8_t)instrument;
+        *word |= bit;
+        for (int c = pageCol + 1; c <= PATTERN_PAGE_COLS; c++)
+            page->firstNote[c]++;
+        pattern->noteCount++;
+    }
+    pattern->version++;
+    if (pattern->pages[pageIndex])
+        pattern->pages[pageIndex]->version = pattern->version;
+    return true;
+}
+
+PatternPage *patternSwapPage(Pattern *pattern, int index, PatternPage *page)
+{
+    PatternPage *old = pattern->pages[index];
+    pattern->pages[index] = page;
+    pattern->noteCount += pageNoteCount(page) - pageNoteCount(old);
+    pattern->version++;
+    if (page)
+        page->version = pattern->version;
+    return old;
+}
+
+int patternRowForPitch(const Pattern *pattern, int pitch)
+{
+    for (int row = 0; row < pattern->rows; row++)
+    {
+        if (pattern->rowPitch[row] == pitch)
+            return row;
+    }
+    return -1;
+}
+
+size_t patternResidentBytes(const Pattern *pattern)
+{
+    size_t bytes = sizeof(PatternPage *) * (size_t)pattern->pageCount;
+    for (int i = 0; i < pattern->pageCount; i++)
+    {
+        if (pattern->pages[i])
+            bytes += sizeof(PatternPage) + (size_t)pattern->pages[i]->capacity;
+    }
+    return bytes;
+}
+
+static int instrumentForLetter(char c)
+{
+    for (int i = 0; i < NUM_INSTRUMENTS; i++)
+    {
+        if (INSTRUMENT_LETTERS[i] == c)
+            return i;
+    }
+    return -1;
+}
+
+// Reads one line of any length into a growing buffer; returns false at EOF
+static bool readLine(FILE *file, char **buffer, size_t *capacity)
+{
+    size_t length = 0;
+    int c;
+    while ((c = getc(file)) != EOF && c != '\n')
+    {
+        if (length + 1 >= *capacity)
+        {
+            size_t grown = *capacity ? *capacity * 2 : 256;
+            char *bigger = realloc(*buffer, grown);
+            if (!bigger)
+                return false;
+            *buffer = bigger;
+            *capacity = grown;
+        }
+        (*buffer)[length++] = (char)c;
+    }
+    if (c == EOF && length == 0)
+        return false;
+    if (!*buffer)
+    {
+        *buffer = malloc(1);
+        if (!*buffer)
+            return false;
+        *capacity = 1;
+    }
+    (*buffer)[length] = '\0';
+    return true;
+}
+
+// Splits "<key> <value>" in place. A comment starts with a '#' at the start
+// of a word, so sharps like "F#4" survive. Returns the number of fields
+// found (0, 1 or 2; 3 means trailing junk).
+static int splitLine(char *line, char **key, char **value)
+{
+    char *fields[3] = {NULL, NULL, NULL};
+    int count = 0;
+    char *p = line;
+    while (count < 3)
+    {
+        while (isspace((unsigned char)*p))
+            p++;
+        if (!*p || *p == '#')
+            break;
+        fields[count++] = p;
+        while (*p && !isspace((unsigned char)*p))
+            p++;
+        if (*p)
+            *p++ = '\0';
+    }
+    *key = fields[0];
+    *value = fields[1];
+    return count;
+}
+
+bool patternLoadText(const char *path, Pattern *pattern, float *tempo)
+{
+    FILE *file = fopen(path, "r");
+    if (!file)
+        return false;
+
+    // First pass sizes the pattern, second pass fills it
+    uint8_t pitches[PATTERN_MAX_ROWS];
+    bool seen[PATTERN_MAX_ROWS] = {false};
+    int rows = 0;
+    size_t cols = 0;
+    char *line = NULL;
+    size_t capacity = 0;
+    int lineNumber = 0;
+    float fileTempo = *tempo;
+    bool ok = true;
+    while (ok && readLine(file, &line, &capacity))
+    {
+        lineNumber++;
+        char *key, *value;
+        int fields = splitLine(line, &key, &value);
+        if (fields == 0)
+            continue;
+        ok = fields == 2;
+        if (!ok)
+            continue;
+        if (strcmp(key, "tempo") == 0)
+        {
+            char *end;
+            fileTempo = strtof(value, &end);
+            if (*end != '\0' || !patternTempoValid(fileTempo))
+            {
+                fprintf(stderr, "%s:%d: tempo must be above 0 and at most %.0f\n", path, lineNumber, PATTERN_MAX_TEMPO);
+                free(line);
+                fclose(file);
+                return false;
+            }
+            continue;
+        }
+
+        int pitch = noteParse(key);
+        ok = pitch >= 0 && !seen[pitch] && rows < PATTERN_MAX_ROWS;
+        if (!ok)
+            break;
+        seen[pitch] = true;
+        pitches[rows++] = (uint8_t)pitch;
+        size_t steps = strlen(value);
+        if (steps > cols)
+            cols = steps;
+    }
+    if (ok && (rows == 0 || cols == 0 || cols > PATTERN_MAX_COLS))
+    {
+        fprintf(stderr, "%s: no notes or too many steps\n", path);
+        free(line);
+        fclose(file);
+        return false;
+    }
+
+    Pattern loaded = {0};
+    if (ok)
+    {
+        ok = patternInit(&loaded, pitches, rows, (int)cols);
+        lineNumber = 0;
+        rewind(file);
+    }
+    int row = 0;
+    while (ok && readLine(file, &line, &capacity))
+    {
+        lineNumber++;
+        char *key, *value;
+        if (splitLine(line, &key, &value) == 0)
+            continue;
+        if (strcmp(key, "tempo") == 0)
+            continue;
+
+        for (int col = 0; ok && value[col]; col++)
+        {
+            if (value[col] == '.')
+                continue;
+            int instrument = instrumentForLetter(value[col]);
+            ok = instrument >= 0 && patternSet(&loaded, row, col, true, (Instrument)instrument);
+        }
+        row++;
+    }
+
+    if (ok)
+    {
+        patternFree(pattern);
+        *pattern = loaded;
+        *tempo = fileTempo;
+    }
+    else
+    {
+        fprintf(stderr, "%s:%d: malformed pattern line\n", path, lineNumber);
+        if (loaded.pages)
+            patternFree(&loaded);
+    }
+    free(line);
+    fclose(file);
+    return ok;
+}
+
+bool patternSaveText(const char *path, const Pattern *pattern, float tempo)
+{
+    FILE *file = fopen(path, "w");
+    if (!file)
+        return false;
+
+    fprintf(file, "# LSD-VIS pattern: . = off, p = piano, s = synth, b = bell\n");
+    fprintf(file, "tempo %.3f\n", tempo); // Project tempos are in thousandths
+    char *steps = malloc((size_t)pattern->cols + 1);
+    if (!steps)
+    {
+        fclose(file);
+        return false;
+    }
+
+    // One row at a time keeps the buffer to a single line however tall the pattern
+    for (int row = 0; row < pattern->rows; row++)
+    {
+        memset(steps, '.', (size_t)pattern->cols);
+        steps[pattern->cols] = '\0';
+        for (int col = 0; col < pattern->cols; col += PATTERN_PAGE_COLS)
+        {
+            if (!patternPage(pattern, col))
+                continue;
+            int end = col + PATTERN_PAGE_COLS < pattern->cols ? col + PATTERN_PAGE_COLS : pattern->cols;
+            for (int c = col; c < end; c++)
+            {
+                if (patternIsActive(pattern, row, c))
+                    steps[c] = INSTRUMENT_LETTERS[patternInstrument(pattern, row, c)];
+            }
+        }
+
+        char name[8];
+        noteName(pattern->rowPitch[row], name, sizeof(name));
+        fprintf(file, "%-3s %s\n", name, steps);
+    }
+    free(steps);
+
+    bool ok = !ferror(file);
+    return fclose(file) == 0 && ok;
+}
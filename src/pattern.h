@@ -0,0 +1,198 @@
+#ifndef PATTERN_H
+#define PATTERN_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+#define GRID_COLS 32 // Default timeline length
+#define GRID_ROWS 8  // Default number of notes (C4-C5 major scale)
+
+#define PATTERN_MAX_ROWS 128  // Full MIDI note range
+#define PATTERN_ROW_WORDS 2   // 64-bit occupancy words per column
+#define PATTERN_PAGE_COLS 64  // Columns per lazily allocated page
+#define PATTERN_MAX_COLS (1 << 20)
+#define PATTERN_MAX_TEMPO 10000.0f // Steps per minute
+
+// Instruments
+typedef enum
+{
+    PIANO,
+    SYNTH,
+    BELL,
+    NUM_INSTRUMENTS
+} Instrument;
+
+// Sparse, column-major note storage. Columns are grouped into pages that are
+// only allocated while they hold notes. A page keeps one occupancy bitmask
+// per column plus one instrument byte per active cell, ordered by column
+// then row, so memory follows the note count rather than rows x steps and
+// triggering a step is a count-trailing-zeros walk over two words.
+typedef struct
+{
+    uint64_t occupancy[PATTERN_PAGE_COLS][PATTERN_ROW_WORDS];
+    uint16_t firstNote[PATTERN_PAGE_COLS + 1]; // Index of each column's first instrument
+    uint8_t *instruments;
+    int capacity;
+    uint32_t version; // The pattern's version at the page's last edit
+} PatternPage;
+
+typedef struct
+{
+    int rows;
+    int cols;
+    uint8_t rowPitch[PATTERN_MAX_ROWS]; // MIDI note of each row, top row first
+    int pageCount;
+    PatternPage **pages; // NULL for empty pages
+    int noteCount;
+    uint32_t version; // Bumped on every edit
+} Pattern;
+
+extern const uint8_t DEFAULT_ROW_PITCHES[GRID_ROWS];
+extern const char *INSTRUMENT_NAMES[NUM_INSTRUMENTS];
+extern const char *INSTRUMENT_DIRS[NUM_INSTRUMENTS];
+
+// Notes that ship as WAV files in sounds/<instrument>/
+#define SAMPLE_NOTE_COUNT 8
+extern const char *SAMPLE_NOTE_NAMES[SAMPLE_NOTE_COUNT];
+
+// "C4", "F#5", ... (sharps only); returns -1 if the name is not a MIDI note
+int noteParse(const char *name);
+void noteName(int pitch, char *buffer, size_t size);
+float noteFrequency(int pitch);
+
+bool patternInit(Pattern *pattern, const uint8_t *rowPitches, int rows, int cols);
+// Default 8-row C major grid
+bool patternInitDefault(Pattern *pattern, int cols);
+// One row per semitone from highPitch down to lowPitch
+bool patternInitChromatic(Pattern *pattern, int lowPitch, int highPitch, int cols);
+void patternFree(Pattern *pattern);
+// Deep copy into an uninitialized dst, version included
+bool patternCopy(Pattern *dst, const Pattern *src);
+void patternClear(Pattern *pattern);
+
+// Returns false if a page could not be allocated
+bool patternSet(Pattern *pattern, int row, int col, bool active, Instrument instrument);
+
+// Deep copy of a page; NULL if out of memory
+PatternPage *patternPageCopy(const PatternPage *page);
+void patternPageFree(PatternPage *page);
+// Puts `page` (NULL for an empty page) in place of page `index` and returns
+// the one it replaces, for the caller to free. Never allocates or frees, so
+// a real-time thread can apply pages built elsewhere.
+PatternPage *patternSwapPage(Pattern *pattern, int index, PatternPage *page);
+int patternRowForPitch(const Pattern *pattern, int pitch);
+size_t patternResidentBytes(const Pattern *pattern);
+
+static inline int patternCtz64(uint64_t bits)
+{
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanForward64(&index, bits);
+    return (int)index;
+#else
+    return __builtin_ctzll(bits);
+#endif
+}
+
+static inline int patternPopcount64(uint64_t bits)
+{
+#ifdef _MSC_VER
+    return (int)__popcnt64(bits);
+#else
+    return __builtin_popcountll(bits);
+#endif
+}
+
+static inline const PatternPage *patternPage(const Pattern *pattern, int col)
+{
+    return pattern->pages[col / PATTERN_PAGE_COLS];
+}
+
+static inline bool patternIsActive(const Pattern *pattern, int row, int col)
+{
+    const PatternPage *page = patternPage(pattern, col);
+    return page && ((page->occupancy[col % PATTERN_PAGE_COLS][row / 64] >> (row % 64)) & 1u);
+}
+
+// Index of (row, col) in its page's instrument array, active or not
+static inline int patternNoteRank(const PatternPage *page, int row, int col)
+{
+    const uint64_t *words = page->occupancy[col % PATTERN_PAGE_COLS];
+    int rank = page->firstNote[col % PATTERN_PAGE_COLS];
+    for (int w = 0; w < row / 64; w++)
+        rank += patternPopcount64(words[w]);
+    uint64_t below = ((uint64_t)1 << (row % 64)) - 1;
+    return rank + patternPopcount64(words[row / 64] & below);
+}
+
+static inline Instrument patternInstrument(const Pattern *pattern, int row, int col)
+{
+    const PatternPage *page = patternPage(pattern, col);
+    if (!page || !patternIsActive(pattern, row, col))
+        return PIANO;
+    return (Instrument)page->instruments[patternNoteRank(page, row, col)];
+}
+
+// Visits the active cells of one column in row order:
+//     PatternColumnIter it;
+//     patternColumnBegin(pattern, col, &it);
+//     while (patternColumnNext(&it, &row, &instrument)) { ... }
+typedef struct
+{
+    const uint64_t *words;
+    const uint8_t *instruments;
+    int word;
+    uint64_t bits;
+} PatternColumnIter;
+
+static inline void patternColumnBegin(const Pattern *pattern, int col, PatternColumnIter *it)
+{
+    const PatternPage *page = patternPage(pattern, col);
+    if (!page)
+    {
+        it->words = NULL;
+        it->instruments = NULL;
+        it->word = PATTERN_ROW_WORDS;
+        it->bits = 0;
+        return;
+    }
+    it->words = page->occupancy[col % PATTERN_PAGE_COLS];
+    it->instruments = page->instruments + page->firstNote[col % PATTERN_PAGE_COLS];
+    it->word = 0;
+    it->bits = it->words[0];
+}
+
+static inline bool patternColumnNext(PatternColumnIter *it, int *row, Instrument *instrument)
+{
+    while (it->bits == 0)
+    {
+        if (++it->word >= PATTERN_ROW_WORDS)
+            return false;
+        it->bits = it->words[it->word];
+    }
+    *row = it->word * 64 + patternCtz64(it->bits);
+    it->bits &= it->bits - 1;
+    *instrument = (Instrument)*it->instruments++;
+    return true;
+}
+
+// Above zero and no faster than a step every 6 ms; rejects NaN and infinity
+static inline bool patternTempoValid(float tempo)
+{
+    return tempo > 0.0f && tempo <= PATTERN_MAX_TEMPO;
+}
+
+// Text pattern files: a "tempo <bpm>" line followed by one line per row,
+// "<note> <steps>", where each step is '.' (off) or the instrument's
+// letter (p = piano, s = synth, b = bell) and notes are spelled with sharps
+// ("F#4"). A word starting with '#' begins a comment. The pattern is sized
+// from the file: one row per note line, as many steps as the longest line.
+// A bad tempo fails the load; without a tempo line *tempo is left as is.
+bool patternLoadText(const char *path, Pattern *pattern, float *tempo);
+bool patternSaveText(const char *path, const Pattern *pattern, float tempo);
+
+#endif // PATTERN_H
@@ -0,0 +1,428 @@
+#include "platform.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <malloc.h>
+
+struct PlatformThread
+{
+    HANDLE handle;
+    PlatformThreadFn fn;
+    void *arg;
+};
+
+static DWORD WINAPI threadTrampoline(LPVOID param)
+{
+    PlatformThread *thread = (PlatformThread *)param;
+    thread->fn(thread->arg);
+    return 0;
+}
+
+PlatformThread *platformThreadStart(PlatformThreadFn fn, void *arg)
+{
+    PlatformThread *thread = calloc(1, sizeof(PlatformThread));
+    if (!thread)
+        return NULL;
+    thread->fn = fn;
+    thread->arg = arg;
+    thread->handle = CreateThread(NULL, 0, threadTrampoline, thread, 0, NULL);
+    if (!thread->handle)
+    {
+        free(thread);
+        return NULL;
+    }
+    return thread;
+}
+
+void platformThreadJoin(PlatformThread *thread)
+{
+    if (!thread)
+        return;
+    WaitForSingleObject(thread->handle, INFINITE);
+    CloseHandle(thread->handle);
+    free(thread);
+}
+
+bool platformThreadSetRealtime(void)
+{
+    return SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_TIME_CRITICAL) != 0;
+}
+
+void platformSleepMs(int ms)
+{
+    Sleep((DWORD)ms);
+}
+
+void platformYield(void)
+{
+    SwitchToThread();
+}
+
+double platformTimeSeconds(void)
+{
+    static LARGE_INTEGER frequency;
+    LARGE_INTEGER counter;
+    if (frequency.QuadPart == 0)
+        QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&counter);
+    return (double)counter.QuadPart / (double)frequency.QuadPart;
+}
+
+double platformThreadCpuSeconds(void)
+{
+    FILETIME creation, exit, kernel, user;
+    if (!GetThreadTimes(GetCurrentThread(), &creation, &exit, &kernel, &user))
+        return 0.0;
+    // 100 ns units
+    uint64_t k = ((uint64_t)kernel.dwHighDateTime << 32) | kernel.dwLowDateTime;
+    uint64_t u = ((uint64_t)user.dwHighDateTime << 32) | user.dwLowDateTime;
+    return (double)(k + u) * 1e-7;
+}
+
+void *platformAlignedAlloc(size_t alignment, size_t size)
+{
+    return _aligned_malloc(size, alignment);
+}
+
+void platformAlignedFree(void *ptr)
+{
+    _aligned_free(ptr);
+}
+
+int platformCpuCount(void)
+{
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return info.dwNumberOfProcessors > 0 ? (int)info.dwNumberOfProcessors : 1;
+}
+
+bool platformMakeDirectory(const char *path)
+{
+    return CreateDirectoryA(path, NULL) || GetLastError() == ERROR_ALREADY_EXISTS;
+}
+
+struct PlatformSharedMemory
+{
+    HANDLE mapping;
+    void *data;
+    size_t size;
+};
+
+static PlatformSharedMemory *mapSharedMemory(HANDLE mapping, size_t size)
+{
+    PlatformSharedMemory *shm = calloc(1, sizeof(PlatformSharedMemory));
+    void *data = mapping ? MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, size) : NULL;
+    if (!shm || !data)
+    {
+        if (data)
+            UnmapViewOfFile(data);
+        if (mapping)
+            CloseHandle(mapping);
+        free(shm);
+        return NULL;
+    }
+    shm->mapping = mapping;
+    shm->data = data;
+    shm->size = size;
+    return shm;
+}
+
+// Mapping names have no leading slash on Windows
+static const char *mappingName(const char *name)
+{
+    return name[0] == '/' ? name + 1 : name;
+}
+
+PlatformSharedMemory *platformSharedMemoryCreate(const char *name, size_t size)
+{
+    HANDLE mapping = CreateFileMappingA(INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE,
+                                        (DWORD)((unsigned long long)size >> 32), (DWORD)size, mappingName(name));
+    PlatformSharedMemory *shm = mapSharedMemory(mapping, size);
+    if (shm)
+        memset(shm->data, 0, size);
+    return shm;
+}
+
+PlatformSharedMemory *platformSharedMemoryOpen(const char *name, size_t size)
+{
+    return mapSharedMemory(OpenFileMappingA(FILE_MAP_ALL_ACCESS, FALSE, mappingName(name)), size);
+}
+
+void platformSharedMemoryClose(PlatformSharedMemory *shm)
+{
+    if (!shm)
+        return;
+    UnmapViewOfFile(shm->data);
+    CloseHandle(shm->mapping); // The name goes away with the last handle
+    free(shm);
+}
+
+struct PlatformFileMap
+{
+    const void *data;
+    size_t size;
+};
+
+PlatformFileMap *platformFileMapOpen(const char *path)
+{
+    HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE)
+        return NULL;
+    LARGE_INTEGER size;
+    HANDLE mapping = NULL;
+    if (GetFileSizeEx(file, &size) && size.QuadPart > 0)
+        mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    CloseHandle(file); // The mapping keeps the file open
+    if (!mapping)
+        return NULL;
+
+    PlatformFileMap *map = calloc(1, sizeof(PlatformFileMap));
+    const void *data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    CloseHandle(mapping); // The view keeps the mapping alive
+    if (!map || !data)
+    {
+        if (data)
+            UnmapViewOfFile(data);
+        free(map);
+        return NULL;
+    }
+    map->data = data;
+    map->size = (size_t)size.QuadPart;
+    return map;
+}
+
+void platformFileMapClose(PlatformFileMap *map)
+{
+    if (!map)
+        return;
+    UnmapViewOfFile(map->data);
+    free(map);
+}
+
+#else
+#include <pthread.h>
+#include <fcntl.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+struct PlatformThread
+{
+    pthread_t handle;
+    PlatformThreadFn fn;
+    void *arg;
+};
+
+static void *threadTrampoline(void *param)
+{
+    PlatformThread *thread = (PlatformThread *)param;
+    thread->fn(thread->arg);
+    return NULL;
+}
+
+PlatformThread *platformThreadStart(PlatformThreadFn fn, void *arg)
+{
+    PlatformThread *thread = calloc(1, sizeof(PlatformThread));
+    if (!thread)
+        return NULL;
+    thread->fn = fn;
+    thread->arg = arg;
+    if (pthread_create(&thread->handle, NULL, threadTrampoline, thread) != 0)
+    {
+        free(thread);
+        return NULL;
+    }
+    return thread;
+}
+
+void platformThreadJoin(PlatformThread *thread)
+{
+    if (!thread)
+        return;
+    pthread_join(thread->handle, NULL);
+    free(thread);
+}
+
+bool platformThreadSetRealtime(void)
+{
+    struct sched_param param = {.sched_priority = sched_get_priority_min(SCHED_FIFO) + 10};
+    return pthread_setschedparam(pthread_self(), SCHED_FIFO, &param) == 0;
+}
+
+void platformSleepMs(int ms)
+{
+    struct timespec ts = {.tv_sec = ms / 1000, .tv_nsec = (long)(ms % 1000) * 1000000L};
+    nanosleep(&ts, NULL);
+}
+
+void platformYield(void)
+{
+    sched_yield();
+}
+
+double platformTimeSeconds(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+double platformThreadCpuSeconds(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+void *platformAlignedAlloc(size_t alignment, size_t size)
+{
+    void *ptr = NULL;
+    if (posix_memalign(&ptr, alignment, size) != 0)
+        return NULL;
+    return ptr;
+}
+
+void platformAlignedFree(void *ptr)
+{
+    free(ptr);
+}
+
+int platformCpuCount(void)
+{
+    long count = sysconf(_SC_NPROCESSORS_ONLN);
+    return count > 0 ? (int)count : 1;
+}
+
+bool platformMakeDirectory(const char *path)
+{
+    struct stat info;
+    return mkdir(path, 0777) == 0 || (stat(path, &info) == 0 && S_ISDIR(info.st_mode));
+}
+
+struct PlatformSharedMemory
+{
+    void *data;
+    size_t size;
+    char *unlinkName; // Set for the creator
+};
+
+static PlatformSharedMemory *mapSharedMemory(int fd, size_t size, const char *unlinkName)
+{
+    PlatformSharedMemory *shm = calloc(1, sizeof(PlatformSharedMemory));
+    void *data = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (!shm || data == MAP_FAILED)
+    {
+        if (data != MAP_FAILED)
+            munmap(data, size);
+        free(shm);
+        return NULL;
+    }
+    shm->data = data;
+    shm->size = size;
+    if (unlinkName)
+        shm->unlinkName = strdup(unlinkName);
+    return shm;
+}
+
+PlatformSharedMemory *platformSharedMemoryCreate(const char *name, size_t size)
+{
+    int fd = shm_open(name, O_CREAT | O_RDWR | O_TRUNC, 0600);
+    if (fd < 0)
+        return NULL;
+    if (ftruncate(fd, (off_t)size) != 0)
+    {
+        close(fd);
+        shm_unlink(name);
+        return NULL;
+    }
+    return mapSharedMemory(fd, size, name);
+}
+
+PlatformSharedMemory *platformSharedMemoryOpen(const char *name, size_t size)
+{
+    int fd = shm_open(name, O_RDWR, 0);
+    if (fd < 0)
+        return NULL;
+    struct stat info;
+    if (fstat(fd, &info) == 0 && info.st_size > 0)
+        size = (size_t)info.st_size;
+    return mapSharedMemory(fd, size, NULL);
+}
+
+void platformSharedMemoryClose(PlatformSharedMemory *shm)
+{
+    if (!shm)
+        return;
+    munmap(shm->data, shm->size);
+    if (shm->unlinkName)
+    {
+        shm_unlink(shm->unlinkName);
+        free(shm->unlinkName);
+    }
+    free(shm);
+}
+
+struct PlatformFileMap
+{
+    void *data;
+    size_t size;
+};
+
+PlatformFileMap *platformFileMapOpen(const char *path)
+{
+    int fd = open(path, O_RDONLY);
+    if (fd < 0)
+        return NULL;
+    struct stat info;
+    void *data = MAP_FAILED;
+    if (fstat(fd, &info) == 0 && info.st_size > 0)
+        data = mmap(NULL, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd); // The mapping keeps the file open
+
+    PlatformFileMap *map = calloc(1, sizeof(PlatformFileMap));
+    if (!map || data == MAP_FAILED)
+    {
+        if (data != MAP_FAILED)
+            munmap(data, (size_t)info.st_size);
+        free(map);
+        return NULL;
+    }
+    map->data = data;
+    map->size = (size_t)info.st_size;
+    return map;
+}
+
+void platformFileMapClose(PlatformFileMap *map)
+{
+    if (!map)
+        return;
+    munmap(map->data, map->size);
+    free(map);
+}
+#endif
+
+void *platformSharedMemoryData(PlatformSharedMemory *shm)
+{
+    return shm->data;
+}
+
+size_t platformSharedMemorySize(PlatformSharedMemory *shm)
+{
+    return shm->size;
+}
+
+const void *platformFileMapData(PlatformFileMap *map)
+{
+    return map->data;
+}
+
+size_t platformFileMapSize(PlatformFileMap *map)
+{
+    return map->size;
+}
@@ -0,0 +1,141 @@
+#ifndef PLATFORM_H
+#define PLATFORM_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Thin OS layer so the engine modules never include <windows.h> or
+// <pthread.h> directly.
+
+typedef struct PlatformThread PlatformThread;
+typedef void (*PlatformThreadFn)(void *arg);
+
+PlatformThread *platformThreadStart(PlatformThreadFn fn, void *arg);
+void platformThreadJoin(PlatformThread *thread);
+// Best effort; returns false if the OS refused (e.g. no rtprio on Linux)
+bool platformThreadSetRealtime(void);
+
+void platformSleepMs(int ms);
+void platformYield(void); // Gives up the rest of the time slice
+double platformTimeSeconds(void); // Monotonic, high resolution
+double platformThreadCpuSeconds(void); // CPU time consumed by the calling thread
+
+void *platformAlignedAlloc(size_t alignment, size_t size);
+void platformAlignedFree(void *ptr);
+
+int platformCpuCount(void); // Online logical CPUs, at least 1
+// Succeeds if the directory exists afterwards; parents must exist
+bool platformMakeDirectory(const char *path);
+
+// Named shared memory visible to other processes: POSIX shm on Unix, a
+// pagefile-backed file mapping on Windows. Names start with '/'.
+typedef struct PlatformSharedMemory PlatformSharedMemory;
+
+// Creates (or truncates) a zero-filled region
+PlatformSharedMemory *platformSharedMemoryCreate(const char *name, size_t size);
+// Maps an existing region; size is read back from the OS where possible
+PlatformSharedMemory *platformSharedMemoryOpen(const char *name, size_t size);
+void *platformSharedMemoryData(PlatformSharedMemory *shm);
+size_t platformSharedMemorySize(PlatformSharedMemory *shm);
+// Unmaps; the creator also removes the name
+void platformSharedMemoryClose(PlatformSharedMemory *shm);
+
+// A whole file mapped read-only, e.g. to use a binary format in place
+typedef struct PlatformFileMap PlatformFileMap;
+
+// NULL if the file cannot be opened or is empty
+PlatformFileMap *platformFileMapOpen(const char *path);
+const void *platformFileMapData(PlatformFileMap *map);
+size_t platformFileMapSize(PlatformFileMap *map);
+void platformFileMapClose(PlatformFileMap *map);
+
+// Atomics shared between the UI thread and the audio thread.
+// Loads are acquire, stores are release, read-modify-writes are full barriers.
+#if defined(_MSC_VER)
+#include <intrin.h>
+
+static inline int32_t atomicLoad32(volatile int32_t *p)
+{
+    return (int32_t)_InterlockedCompareExchange((volatile long *)p, 0, 0);
+}
+
+static inline void atomicStore32(volatile int32_t *p, int32_t value)
+{
+    _InterlockedExchange((volatile long *)p, (long)value);
+}
+
+static inline int32_t atomicFetchAdd32(volatile int32_t *p, int32_t value)
+{
+    return (int32_t)_InterlockedExchangeAdd((volatile long *)p, (long)value);
+}
+
+static inline int32_t atomicExchange32(volatile int32_t *p, int32_t value)
+{
+    return (int32_t)_InterlockedExchange((volatile long *)p, (long)value);
+}
+
+static inline int64_t atomicLoad64(volatile int64_t *p)
+{
+    return _InterlockedCompareExchange64((volatile long long *)p, 0, 0);
+}
+
+static inline void atomicStore64(volatile int64_t *p, int64_t value)
+{
+    int64_t old = *p;
+    int64_t seen;
+    while ((seen = _InterlockedCompareExchange64((volatile long long *)p, value, old)) != old)
+    {
+        old = seen;
+    }
+}
+#else
+static inline int32_t atomicLoad32(volatile int32_t *p)
+{
+    return __atomic_load_n(p, __ATOMIC_ACQUIRE);
+}
+
+static inline void atomicStore32(volatile int32_t *p, int32_t value)
+{
+    __atomic_store_n(p, value, __ATOMIC_RELEASE);
+}
+
+static inline int32_t atomicFetchAdd32(volatile int32_t *p, int32_t value)
+{
+    return __atomic_fetch_add(p, value, __ATOMIC_SEQ_CST);
+}
+
+static inline int32_t atomicExchange32(volatile int32_t *p, int32_t value)
+{
+    return __atomic_exchange_n(p, value, __ATOMIC_SEQ_CST);
+}
+
+static inline int64_t atomicLoad64(volatile int64_t *p)
+{
+    return __atomic_load_n(p, __ATOMIC_ACQUIRE);
+}
+
+static inline void atomicStore64(volatile int64_t *p, int64_t value)
+{
+    __atomic_store_n(p, value, __ATOMIC_RELEASE);
+}
+#endif
+
+// For short critical sections shared with the audio thread, where a mutex
+// could put the audio thread to sleep
+static inline void platformSpinLock(volatile int32_t *lock)
+{
+    while (atomicExchange32(lock, 1))
+    {
+        while (atomicLoad32(lock))
+        {
+        }
+    }
+}
+
+static inline void platformSpinUnlock(volatile int32_t *lock)
+{
+    atomicStore32(lock, 0);
+}
+
+#endif // PLATFORM_H
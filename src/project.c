@@ -0,0 +1,424 @@
+#include "project.h"
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "platform.h"
+
+_Static_assert(sizeof(ProjectHeader) == 256, "ProjectHeader is part of the file format");
+_Static_assert(sizeof(ProjectPageEntry) == 16, "ProjectPageEntry is part of the file format");
+_Static_assert(sizeof(ProjectPageChunk) == 1216, "ProjectPageChunk is part of the file format");
+_Static_assert(sizeof(ProjectPageChunk) % PROJECT_CHUNK_ALIGN == 0, "Chunk capacities stay aligned");
+
+#define PAGE_MAX_NOTES (PATTERN_PAGE_COLS * PATTERN_MAX_ROWS)
+
+static uint64_t alignUp(uint64_t bytes)
+{
+    return (bytes + PROJECT_CHUNK_ALIGN - 1) & ~(uint64_t)(PROJECT_CHUNK_ALIGN - 1);
+}
+
+static uint64_t chunkBytes(uint32_t capacity)
+{
+    return sizeof(ProjectPageChunk) + (uint64_t)capacity;
+}
+
+// Room for a quarter more notes, so most edits rewrite the chunk in place
+static uint32_t chunkCapacity(int notes)
+{
+    return (uint32_t)alignUp((uint64_t)notes + (uint64_t)notes / 4 + 1);
+}
+
+static int pageNotes(const PatternPage *page)
+{
+    return page->firstNote[PATTERN_PAGE_COLS];
+}
+
+static uint64_t tableOffset(void)
+{
+    return sizeof(ProjectHeader);
+}
+
+static uint64_t firstChunkOffset(int pageCount)
+{
+    return alignUp(tableOffset() + sizeof(ProjectPageEntry) * (uint64_t)pageCount);
+}
+
+// Occupancy bits must sit inside the pattern and agree with firstNote
+static const char *checkChunk(const ProjectPageChunk *chunk, const ProjectHeader *header, int pageIndex, uint32_t noteCount)
+{
+    uint64_t rowMask[PATTERN_ROW_WORDS];
+    for (int w = 0; w < PATTERN_ROW_WORDS; w++)
+    {
+        int rowsInWord = (int)header->rows - w * 64;
+        rowMask[w] = rowsInWord >= 64 ? ~(uint64_t)0 : rowsInWord <= 0 ? 0 : ((uint64_t)1 << rowsInWord) - 1;
+    }
+
+    if (chunk->firstNote[0] != 0 || chunk->firstNote[PATTERN_PAGE_COLS] != noteCount)
+        return "page note counts disagree";
+    for (int c = 0; c < PATTERN_PAGE_COLS; c++)
+    {
+        bool inside = (uint64_t)pageIndex * PATTERN_PAGE_COLS + (uint64_t)c < header->cols;
+        int notes = 0;
+        for (int w = 0; w < PATTERN_ROW_WORDS; w++)
+        {
+            uint64_t bits = chunk->occupancy[c][w];
+            if (bits & ~(inside ? rowMask[w] : 0))
+                return "note outside the pattern";
+            notes += patternPopcount64(bits);
+        }
+        if (chunk->firstNote[c + 1] - chunk->firstNote[c] != notes)
+            return "page note counts disagree";
+    }
+
+    const uint8_t *instruments = (const uint8_t *)(chunk + 1);
+    for (uint32_t i = 0; i < noteCount; i++)
+    {
+        if (instruments[i] >= NUM_INSTRUMENTS)
+            return "unknown instrument";
+    }
+    return NULL;
+}
+
+// Returns why the mapped file cannot be used, or NULL
+static const char *checkProject(const uint8_t *data, size_t size)
+{
+    const ProjectHeader *header = (const ProjectHeader *)data;
+    if (size < sizeof(ProjectHeader) || memcmp(header->magic, PROJECT_MAGIC, sizeof(header->magic)) != 0)
+        return "not a project file";
+    if (header->version != PROJECT_VERSION)
+        return "unsupported project version";
+    if (header->byteOrder != PROJECT_BYTE_ORDER || header->headerBytes != sizeof(ProjectHeader))
+        return "written on an incompatible machine";
+    if (header->rows < 1 || header->rows > PATTERN_MAX_ROWS || header->cols < 1 || header->cols > PATTERN_MAX_COLS ||
+        header->pageCount != (header->cols + PATTERN_PAGE_COLS - 1) / PATTERN_PAGE_COLS ||
+        header->instrument >= NUM_INSTRUMENTS || !patternTempoValid((float)header->tempoMilliBpm / 1000.0f))
+        return "bad header";
+    for (uint32_t row = 0; row < header->rows; row++)
+    {
+        if (header->rowPitch[row] >= PATTERN_MAX_ROWS)
+            return "bad header";
+    }
+    if (header->pageTableOffset % sizeof(uint64_t) != 0 ||
+        header->pageTableOffset + sizeof(ProjectPageEntry) * (uint64_t)header->pageCount > size)
+        return "truncated page table";
+
+    const ProjectPageEntry *entries = (const ProjectPageEntry *)(data + header->pageTableOffset);
+    uint64_t totalNotes = 0;
+    for (uint32_t i = 0; i < header->pageCount; i++)
+    {
+        const ProjectPageEntry *entry = &entries[i];
+        if (entry->offset == 0)
+            continue;
+        // The capacity past the used notes may not exist on disk yet
+        if (entry->offset % PROJECT_CHUNK_ALIGN != 0 || entry->noteCount < 1 || entry->noteCount > entry->capacity ||
+            entry->capacity > PAGE_MAX_NOTES || entry->offset + chunkBytes(entry->capacity) > header->fileBytes ||
+            entry->offset + chunkBytes(entry->noteCount) > size)
+            return "bad page entry";
+        const char *error = checkChunk((const ProjectPageChunk *)(data + entry->offset), header, (int)i, entry->noteCount);
+        if (error)
+            return error;
+        totalNotes += entry->noteCount;
+    }
+    if (totalNotes != header->noteCount)
+        return "note count disagrees";
+    return NULL;
+}
+
+static char *copyString(const char *s)
+{
+    size_t bytes = strlen(s) + 1;
+    char *copy = malloc(bytes);
+    if (copy)
+        memcpy(copy, s, bytes);
+    return copy;
+}
+
+// Sizes the save state for pageCount pages, all empty on disk
+static bool resetEntries(Project *project, int pageCount)
+{
+    ProjectPageEntry *entries = calloc((size_t)pageCount, sizeof(ProjectPageEntry));
+    uint32_t *versions = calloc((size_t)pageCount, sizeof(uint32_t));
+    if (!entries || !versions)
+    {
+        free(entries);
+        free(versions);
+        return false;
+    }
+    free(project->entries);
+    free(project->savedVersions);
+    project->entries = entries;
+    project->savedVersions = versions;
+    project->pageCount = pageCount;
+    return true;
+}
+
+static bool loadPages(Pattern *pattern, const uint8_t *data, const ProjectPageEntry *entries)
+{
+    for (int i = 0; i < pattern->pageCount; i++)
+    {
+        if (entries[i].offset == 0)
+            continue;
+        const ProjectPageChunk *chunk = (const ProjectPageChunk *)(data + entries[i].offset);
+        PatternPage *page = malloc(sizeof(PatternPage));
+        uint8_t *instruments = malloc(entries[i].noteCount);
+        if (!page || !instruments)
+        {
+            free(page);
+            free(instruments);
+            return false;
+        }
+        memcpy(page->occupancy, chunk->occupancy, sizeof(page->occupancy));
+        memcpy(page->firstNote, chunk->firstNote, sizeof(page->firstNote));
+        memcpy(instruments, chunk + 1, entries[i].noteCount);
+        page->instruments = instruments;
+        page->capacity = (int)entries[i].noteCount;
+        page->version = 0;
+        pattern->pages[i] = page;
+    }
+    return true;
+}
+
+bool projectOpen(Project *project, const char *path, Pattern *pattern, float *tempo, Instrument *instrument)
+{
+    memset(project, 0, sizeof(*project));
+    project->path = copyString(path);
+    if (!project->path)
+        return false;
+
+    FILE *probe = fopen(path, "rb");
+    if (!probe)
+    {
+        if (errno == ENOENT)
+            return true; // New project
+        fprintf(stderr, "%s: %s\n", path, strerror(errno));
+        projectClose(project);
+        return false;
+    }
+    fclose(probe);
+
+    PlatformFileMap *map = platformFileMapOpen(path);
+    const uint8_t *data = map ? platformFileMapData(map) : NULL;
+    const char *error = map ? checkProject(data, platformFileMapSize(map)) : "not a project file";
+    if (error)
+    {
+        fprintf(stderr, "%s: %s\n", path, error);
+        platformFileMapClose(map);
+        projectClose(project);
+        return false;
+    }
+
+    const ProjectHeader *header = (const ProjectHeader *)data;
+    const ProjectPageEntry *entries = (const ProjectPageEntry *)(data + header->pageTableOffset);
+    Pattern loaded = {0};
+    bool ok = patternInit(&loaded, header->rowPitch, (int)header->rows, (int)header->cols) &&
+              resetEntries(project, loaded.pageCount) && loadPages(&loaded, data, entries);
+    if (!ok)
+    {
+        fprintf(stderr, "%s: out of memory\n", path);
+        if (loaded.pages)
+            patternFree(&loaded);
+        platformFileMapClose(map);
+        projectClose(project);
+        return false;
+    }
+    loaded.noteCount = (int)header->noteCount;
+    memcpy(project->entries, entries, sizeof(ProjectPageEntry) * (size_t)loaded.pageCount);
+    project->exists = true;
+    project->fileBytes = header->fileBytes;
+    project->wastedBytes = header->wastedBytes;
+    project->savedPatternVersion = loaded.version;
+    project->savedTempo = (float)header->tempoMilliBpm / 1000.0f;
+    project->savedInstrument = (Instrument)header->instrument;
+    platformFileMapClose(map);
+
+    patternFree(pattern);
+    *pattern = loaded;
+    *tempo = project->savedTempo;
+    *instrument = project->savedInstrument;
+    return true;
+}
+
+void projectClose(Project *project)
+{
+    free(project->path);
+    free(project->entries);
+    free(project->savedVersions);
+    memset(project, 0, sizeof(*project));
+}
+
+bool projectChanged(const Project *project, const Pattern *pattern, float tempo, Instrument instrument)
+{
+    return !project->exists || pattern->version != project->savedPatternVersion ||
+           tempo != project->savedTempo || instrument != project->savedInstrument;
+}
+
+// Offsets stay far below 2 GiB: a full-size pattern is about 160 MiB
+static bool writeAt(FILE *file, uint64_t offset, const void *data, size_t bytes)
+{
+    return fseek(file, (long)offset, SEEK_SET) == 0 && fwrite(data, 1, bytes, file) == bytes;
+}
+
+static bool writeChunk(FILE *file, uint64_t offset, const PatternPage *page)
+{
+    ProjectPageChunk chunk;
+    memset(&chunk, 0, sizeof(chunk));
+    memcpy(chunk.occupancy, page->occupancy, sizeof(chunk.occupancy));
+    memcpy(chunk.firstNote, page->firstNote, sizeof(chunk.firstNote));
+    return writeAt(file, offset, &chunk, sizeof(chunk)) &&
+           fwrite(page->instruments, 1, (size_t)pageNotes(page), file) == (size_t)pageNotes(page);
+}
+
+static bool writeHeader(FILE *file, const Project *project, const Pattern *pattern, float tempo, Instrument instrument)
+{
+    ProjectHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, PROJECT_MAGIC, sizeof(header.magic));
+    header.version = PROJECT_VERSION;
+    header.byteOrder = PROJECT_BYTE_ORDER;
+    header.headerBytes = sizeof(ProjectHeader);
+    header.rows = (uint32_t)pattern->rows;
+    header.cols = (uint32_t)pattern->cols;
+    header.tempoMilliBpm = (uint32_t)(tempo * 1000.0f + 0.5f);
+    header.instrument = (uint32_t)instrument;
+    header.noteCount = (uint32_t)pattern->noteCount;
+    header.pageCount = (uint32_t)pattern->pageCount;
+    header.pageTableOffset = tableOffset();
+    header.fileBytes = project->fileBytes;
+    header.wastedBytes = project->wastedBytes;
+    memcpy(header.rowPitch, pattern->rowPitch, sizeof(header.rowPitch));
+    return fflush(file) == 0 && writeAt(file, 0, &header, sizeof(header));
+}
+
+static void markSaved(Project *project, const Pattern *pattern, float tempo, Instrument instrument)
+{
+    project->exists = true;
+    project->savedPatternVersion = pattern->version;
+    project->savedTempo = tempo;
+    project->savedInstrument = instrument;
+}
+
+// Writes every page to a temporary file that then replaces the project
+static bool saveAll(Project *project, const Pattern *pattern, float tempo, Instrument instrument)
+{
+    size_t pathBytes = strlen(project->path);
+    char *tempPath = malloc(pathBytes + 5);
+    if (!tempPath || !resetEntries(project, pattern->pageCount))
+    {
+        free(tempPath);
+        return false;
+    }
+    memcpy(tempPath, project->path, pathBytes);
+    memcpy(tempPath + pathBytes, ".tmp", 5);
+
+    FILE *file = fopen(tempPath, "wb");
+    bool ok = file != NULL;
+    project->exists = false;
+    project->fileBytes = firstChunkOffset(pattern->pageCount);
+    project->wastedBytes = 0;
+    for (int i = 0; ok && i < pattern->pageCount; i++)
+    {
+        const PatternPage *page = pattern->pages[i];
+        if (!page)
+            continue;
+        ProjectPageEntry *entry = &project->entries[i];
+        entry->offset = project->fileBytes;
+        entry->noteCount = (uint32_t)pageNotes(page);
+        entry->capacity = chunkCapacity(pageNotes(page));
+        project->fileBytes += chunkBytes(entry->capacity);
+        project->savedVersions[i] = page->version;
+        ok = writeChunk(file, entry->offset, page);
+        project->savedChunks++;
+        project->savedBytes += chunkBytes(entry->noteCount);
+    }
+    project->savedBytes += firstChunkOffset(pattern->pageCount) - tableOffset() + sizeof(ProjectHeader);
+    ok = ok && writeAt(file, tableOffset(), project->entries, sizeof(ProjectPageEntry) * (size_t)pattern->pageCount) &&
+         writeHeader(file, project, pattern, tempo, instrument);
+    if (file)
+        ok = fclose(file) == 0 && ok;
+#ifdef _WIN32
+    // rename() does not replace an existing file here
+    if (ok)
+        remove(project->path);
+#endif
+    ok = ok && rename(tempPath, project->path) == 0;
+    if (!ok)
+        remove(tempPath);
+    free(tempPath);
+    if (ok)
+        markSaved(project, pattern, tempo, instrument);
+    return ok;
+}
+
+// Rewrites the chunks of pages edited since the last save: in place while
+// they fit, otherwise appended. Entries go out after the chunks they point
+// at and the header last.
+static bool saveChanged(Project *project, const Pattern *pattern, float tempo, Instrument instrument)
+{
+    FILE *file = fopen(project->path, "r+b");
+    if (!file)
+        return false;
+
+    int *changed = malloc(sizeof(int) * (size_t)pattern->pageCount);
+    bool ok = changed != NULL;
+    int changedCount = 0;
+    for (int i = 0; ok && i < pattern->pageCount; i++)
+    {
+        const PatternPage *page = pattern->pages[i];
+        ProjectPageEntry *entry = &project->entries[i];
+        if (!page)
+        {
+            if (entry->offset)
+            {
+                project->wastedBytes += chunkBytes(entry->capacity);
+                memset(entry, 0, sizeof(*entry));
+                changed[changedCount++] = i;
+            }
+            continue;
+        }
+        if (entry->offset && page->version == project->savedVersions[i])
+            continue;
+
+        if (!entry->offset || (uint32_t)pageNotes(page) > entry->capacity)
+        {
+            if (entry->offset)
+                project->wastedBytes += chunkBytes(entry->capacity);
+            entry->offset = project->fileBytes;
+            entry->capacity = chunkCapacity(pageNotes(page));
+            project->fileBytes += chunkBytes(entry->capacity);
+        }
+        entry->noteCount = (uint32_t)pageNotes(page);
+        project->savedVersions[i] = page->version;
+        ok = writeChunk(file, entry->offset, page);
+        changed[changedCount++] = i;
+        project->savedChunks++;
+        project->savedBytes += chunkBytes(entry->noteCount);
+    }
+
+    ok = ok && fflush(file) == 0;
+    for (int i = 0; ok && i < changedCount; i++)
+    {
+        uint64_t offset = tableOffset() + sizeof(ProjectPageEntry) * (uint64_t)changed[i];
+        ok = writeAt(file, offset, &project->entries[changed[i]], sizeof(ProjectPageEntry));
+    }
+    project->savedBytes += sizeof(ProjectPageEntry) * (uint64_t)changedCount + sizeof(ProjectHeader);
+    free(changed);
+    ok = ok && writeHeader(file, project, pattern, tempo, instrument);
+    ok = fclose(file) == 0 && ok;
+    if (ok)
+        markSaved(project, pattern, tempo, instrument);
+    else
+        project->exists = false; // Rewrite everything next time
+    return ok;
+}
+
+bool projectSave(Project *project, const Pattern *pattern, float tempo, Instrument instrument)
+{
+    project->savedChunks = 0;
+    project->savedBytes = 0;
+    bool compact = project->wastedBytes * 2 > project->fileBytes;
+    if (!project->exists || compact || project->pageCount != pattern->pageCount)
+        return saveAll(project, pattern, tempo, instrument);
+    return saveChanged(project, pattern, tempo, instrument);
+}
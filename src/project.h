@@ -0,0 +1,97 @@
+#ifndef PROJECT_H
+#define PROJECT_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "pattern.h"
+
+// Binary project files: the pattern, tempo and selected instrument. The
+// file is laid out to be used straight from a read-only mapping, in host
+// byte order (little-endian everywhere we build):
+//
+//     ProjectHeader     at 0
+//     ProjectPageEntry  [pageCount] at pageTableOffset, one per pattern page
+//     page chunks       64-byte aligned: a ProjectPageChunk, then
+//                       `capacity` instrument bytes, of which the first
+//                       noteCount are used
+//
+// A chunk's arrays are a PatternPage's, so opening maps the file, checks
+// it and copies each chunk into its page; nothing is parsed. Empty pages
+// have no chunk. Saving rewrites only the chunks of pages edited since the
+// last save, in place, or appended at the end when a page outgrows its
+// chunk, then the changed table entries, then the header. Once abandoned
+// chunks make up half the file, the next save compacts it through a
+// temporary file instead.
+
+#define PROJECT_MAGIC "LSDPROJ" // With its NUL, the first 8 bytes
+#define PROJECT_VERSION 1
+#define PROJECT_BYTE_ORDER 0x01020304u
+#define PROJECT_CHUNK_ALIGN 64
+
+typedef struct
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t byteOrder; // PROJECT_BYTE_ORDER as written
+    uint32_t headerBytes;
+    uint32_t rows;
+    uint32_t cols;
+    uint32_t tempoMilliBpm;
+    uint32_t instrument; // Selected for new notes
+    uint32_t noteCount;
+    uint32_t pageCount;
+    uint32_t reserved0;
+    uint64_t pageTableOffset;
+    uint64_t fileBytes;   // End of the last chunk
+    uint64_t wastedBytes; // In chunks no entry points at any more
+    uint8_t rowPitch[PATTERN_MAX_ROWS];
+    uint8_t reserved[56];
+} ProjectHeader; // 256 bytes
+
+typedef struct
+{
+    uint64_t offset;    // Of the page's chunk; 0 for an empty page
+    uint32_t noteCount; // Equal to the chunk's firstNote[PATTERN_PAGE_COLS]
+    uint32_t capacity;  // Instrument bytes after the chunk
+} ProjectPageEntry;
+
+typedef struct
+{
+    uint64_t occupancy[PATTERN_PAGE_COLS][PATTERN_ROW_WORDS];
+    uint16_t firstNote[PATTERN_PAGE_COLS + 1];
+    uint8_t reserved[62];
+} ProjectPageChunk; // 1216 bytes
+
+// What the file on disk holds, so a save knows which chunks changed
+typedef struct
+{
+    char *path;
+    bool exists; // The file matches entries below
+    int pageCount;
+    ProjectPageEntry *entries;
+    uint32_t *savedVersions; // Page version each chunk was written from
+    uint64_t fileBytes;
+    uint64_t wastedBytes;
+    uint32_t savedPatternVersion;
+    float savedTempo;
+    Instrument savedInstrument;
+
+    // What the last save wrote
+    int savedChunks;
+    uint64_t savedBytes;
+} Project;
+
+// Opens `path` into pattern, tempo and instrument. A missing file is a new
+// project: the arguments are left as they are and the first save writes
+// them. Returns false, printing why and changing nothing, if the file is
+// unreadable or not a valid project.
+bool projectOpen(Project *project, const char *path, Pattern *pattern, float *tempo, Instrument *instrument);
+void projectClose(Project *project);
+
+// Anything to save since the last open or save
+bool projectChanged(const Project *project, const Pattern *pattern, float tempo, Instrument instrument);
+// Writes what changed; see above
+bool projectSave(Project *project, const Pattern *pattern, float tempo, Instrument instrument);
+
+#endif // PROJECT_H
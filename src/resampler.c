@@ -0,0 +1,91 @@
+#include "resampler.h"
+
+#include <math.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef _MSC_VER
+#define RESAMPLER_ALIGN __declspec(align(64))
+#else
+#define RESAMPLER_ALIGN __attribute__((aligned(64)))
+#endif
+
+static RESAMPLER_ALIGN float shortTaps[RESAMPLER_SHORT_BANKS][RESAMPLER_PHASES][MIX_RESAMPLE_TAPS];
+static RESAMPLER_ALIGN float longTaps[RESAMPLER_BANKS - RESAMPLER_SHORT_BANKS][RESAMPLER_MAX_SEGMENTS]
+                                     [RESAMPLER_PHASES][MIX_RESAMPLE_TAPS];
+static ResamplerFilter banks[RESAMPLER_BANKS];
+static bool banksReady;
+
+// Zeroth-order modified Bessel function, by its power series
+static double besselI0(double x)
+{
+    double sum = 1.0;
+    double term = 1.0;
+    for (int k = 1; k < 32; k++)
+    {
+        term *= (x / (2.0 * k)) * (x / (2.0 * k));
+        sum += term;
+    }
+    return sum;
+}
+
+static void buildBank(ResamplerFilter *bank, float *tables, int segments, double cutoff)
+{
+    const double pi = 3.14159265358979323846;
+    const int length = segments * MIX_RESAMPLE_TAPS;
+    const double halfWidth = length / 2;
+    double windowScale = 1.0 / besselI0(RESAMPLER_KAISER_BETA);
+    for (int phase = 0; phase < RESAMPLER_PHASES; phase++)
+    {
+        // Tap k reads the source frame (k - first) frames from the integer
+        // part of the position; d is its distance from the exact position
+        double fraction = (double)phase / RESAMPLER_PHASES;
+        double taps[RESAMPLER_MAX_SEGMENTS * MIX_RESAMPLE_TAPS];
+        double total = 0.0;
+        for (int k = 0; k < length; k++)
+        {
+            double d = (double)(k - (length / 2 - 1)) - fraction;
+            double x = d / halfWidth;
+            double window = x * x < 1.0 ? besselI0(RESAMPLER_KAISER_BETA * sqrt(1.0 - x * x)) * windowScale : 0.0;
+            double sinc = d == 0.0 ? 1.0 : sin(pi * cutoff * d) / (pi * cutoff * d);
+            taps[k] = sinc * window;
+            total += taps[k];
+        }
+        for (int k = 0; k < length; k++)
+        {
+            size_t segment = (size_t)(k / MIX_RESAMPLE_TAPS) * RESAMPLER_PHASES * MIX_RESAMPLE_TAPS;
+            tables[segment + (size_t)phase * MIX_RESAMPLE_TAPS + k % MIX_RESAMPLE_TAPS] = (float)(taps[k] / total);
+        }
+    }
+    bank->taps = tables;
+    bank->segments = segments;
+}
+
+void resamplerInit(void)
+{
+    if (banksReady)
+        return;
+    for (int k = 0; k < RESAMPLER_BANKS; k++)
+    {
+        double cutoff = RESAMPLER_CUTOFF * pow(2.0, -0.5 * k);
+        if (k < RESAMPLER_SHORT_BANKS)
+        {
+            buildBank(&banks[k], &shortTaps[k][0][0], 1, cutoff);
+            continue;
+        }
+        // Taps in proportion to 1 / cutoff, to hold the transition band
+        // at what the last short bank has
+        int segments = (int)ceil(pow(2.0, 0.5 * (k - RESAMPLER_SHORT_BANKS + 1)));
+        buildBank(&banks[k], &longTaps[k - RESAMPLER_SHORT_BANKS][0][0][0], segments, cutoff);
+    }
+    banksReady = true;
+}
+
+const ResamplerFilter *resamplerFilter(float rate)
+{
+    // The first bank whose cutoff is at most 1 / rate
+    int bank = rate * RESAMPLER_CUTOFF <= 1.0f ? 0 : (int)ceilf(2.0f * log2f(rate * RESAMPLER_CUTOFF));
+    if (bank >= RESAMPLER_BANKS)
+        bank = RESAMPLER_BANKS - 1;
+    return &banks[bank];
+}
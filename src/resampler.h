@@ -0,0 +1,64 @@
+#ifndef RESAMPLER_H
+#define RESAMPLER_H
+
+#include <stdint.h>
+
+#include "mix_kernels.h"
+
+// Filter tables for playing a sample at another pitch through the
+// mixResample kernels. Each bank is a Kaiser-windowed sinc over
+// MIX_RESAMPLE_TAPS source frames at 1 << MIX_RESAMPLE_PHASE_BITS
+// fractional positions, normalized to unity gain. Playing faster than
+// recorded needs a lower cutoff to keep the shifted-down content from
+// aliasing, so bank k cuts at 2^(-k/2) of the source Nyquist and a rate
+// uses the first bank low enough for it. Rates past RESAMPLER_MAX_RATE
+// share the last bank.
+//
+// A transition band only so narrow fits in MIX_RESAMPLE_TAPS, so banks
+// past 2^3 take more taps as their cutoff drops, up to four times as many.
+// A filter is stored as segments of MIX_RESAMPLE_TAPS taps, each a table
+// the kernels take as is, and resamplerMix runs one pass per segment.
+
+#define RESAMPLER_PHASES (1 << MIX_RESAMPLE_PHASE_BITS)
+#define RESAMPLER_BANKS 11 // Rates up to 2^5
+#define RESAMPLER_SHORT_BANKS 7 // Rates up to 2^3, one segment each
+#define RESAMPLER_MAX_RATE 32.0f
+#define RESAMPLER_MAX_SEGMENTS 4
+#define RESAMPLER_REACH (RESAMPLER_MAX_SEGMENTS * MIX_RESAMPLE_TAPS / 2) // Source frames read either side
+#define RESAMPLER_CUTOFF 0.95f // Of Nyquist for the first bank, leaving a transition band
+#define RESAMPLER_KAISER_BETA 8.0
+
+typedef struct
+{
+    const float *taps; // [segments][RESAMPLER_PHASES][MIX_RESAMPLE_TAPS]
+    int segments;
+} ResamplerFilter;
+
+// Builds the banks once; safe to call again
+void resamplerInit(void);
+
+// The filter for playing at `rate` source frames per output frame
+const ResamplerFilter *resamplerFilter(float rate);
+
+// mixResample through a filter of any length: segment j covers the source
+// frames MIX_RESAMPLE_TAPS * j on from the first the whole filter reads
+static inline void resamplerMix(MixResampleFn mixResample, float *dst, const float *src, uint64_t position,
+                                uint64_t step, const ResamplerFilter *filter, float gain, int frames)
+{
+    const float *taps = filter->taps;
+    int offset = (1 - filter->segments) * MIX_RESAMPLE_TAPS / 2;
+    for (int j = 0; j < filter->segments; j++)
+    {
+        mixResample(dst, src + offset, position, step, taps, gain, frames);
+        offset += MIX_RESAMPLE_TAPS;
+        taps += RESAMPLER_PHASES * MIX_RESAMPLE_TAPS;
+    }
+}
+
+// 32.32 fixed-point step for mixResample
+static inline uint64_t resamplerStep(float rate)
+{
+    return (uint64_t)((double)rate * 4294967296.0 + 0.5);
+}
+
+#endif // RESAMPLER_H
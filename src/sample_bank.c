@@ -0,0 +1,153 @@
+#include "sample_bank.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "platform.h"
+#include "wav.h"
+
+#define FLOATS_PER_ALIGNMENT (SAMPLE_BANK_ALIGNMENT / sizeof(float))
+
+static size_t alignFrames(size_t frames)
+{
+    return (frames + FLOATS_PER_ALIGNMENT - 1) / FLOATS_PER_ALIGNMENT * FLOATS_PER_ALIGNMENT;
+}
+
+// Zeros ahead of each sample, in whole alignment units
+static size_t guardFrames(void)
+{
+    return alignFrames(SAMPLE_BANK_GUARD_FRAMES);
+}
+
+// The guard, the sample and at least the guard again after it
+static size_t paddedFrames(int32_t frames)
+{
+    return guardFrames() + alignFrames((size_t)frames + SAMPLE_BANK_GUARD_FRAMES);
+}
+
+// Maps the file behind a long sample; false leaves it to be loaded whole
+static bool mapStream(SampleStream *stream, const char *path, const WavInfo *info)
+{
+    stream->map = platformFileMapOpen(path);
+    if (!stream->map)
+        return false;
+    size_t size = platformFileMapSize(stream->map);
+    size_t frameBytes = 2 * (size_t)info->channels;
+    size_t available = size > (size_t)info->dataOffset ? (size - (size_t)info->dataOffset) / frameBytes : 0;
+    stream->info = *info;
+    stream->frames = available < (size_t)info->frames ? (int32_t)available : info->frames;
+    stream->residentFrames = SAMPLE_BANK_HEAD_FRAMES;
+    if (stream->frames > SAMPLE_BANK_HEAD_FRAMES)
+        return true;
+    platformFileMapClose(stream->map);
+    stream->map = NULL;
+    return false;
+}
+
+bool sampleBankLoad(SampleBank *bank, const char *root,
+                    const char *const *instrumentDirs, int instrumentCount,
+                    const char *const *noteNames, int noteCount, const bool *wanted, int32_t streamAbove)
+{
+    memset(bank, 0, sizeof(*bank));
+    double start = platformTimeSeconds();
+
+    int slotCount = instrumentCount * noteCount;
+    bank->instrumentCount = instrumentCount;
+    bank->noteCount = noteCount;
+    bank->slots = calloc((size_t)slotCount, sizeof(SampleRef));
+    bank->streams = calloc((size_t)slotCount, sizeof(SampleStream));
+    FILE **files = calloc((size_t)slotCount, sizeof(FILE *));
+    WavInfo *infos = calloc((size_t)slotCount, sizeof(WavInfo));
+    if (!bank->slots || !bank->streams || !files || !infos)
+    {
+        free(files);
+        free(infos);
+        sampleBankFree(bank);
+        return false;
+    }
+
+    // Pass 1: parse headers to size the arena
+    size_t totalFrames = 0;
+    for (int slot = 0; slot < slotCount; slot++)
+    {
+        bank->slots[slot].stream = -1;
+        if (wanted && !wanted[slot])
+            continue;
+        char path[512];
+        snprintf(path, sizeof(path), "%s/%s/%s.wav", root,
+                 instrumentDirs[slot / noteCount], noteNames[slot % noteCount]);
+        files[slot] = fopen(path, "rb");
+        if (!files[slot] || !wavReadInfo(files[slot], &infos[slot]))
+        {
+            fprintf(stderr, "Failed to load %s\n", path);
+            if (files[slot])
+                fclose(files[slot]);
+            files[slot] = NULL;
+            continue;
+        }
+        SampleStream *stream = &bank->streams[bank->streamCount];
+        if (streamAbove > 0 && infos[slot].frames > streamAbove && mapStream(stream, path, &infos[slot]))
+        {
+            bank->slots[slot].stream = bank->streamCount++;
+            bank->streamedBytes += (size_t)(stream->frames - stream->residentFrames) * sizeof(float);
+            totalFrames += paddedFrames(stream->residentFrames);
+            continue;
+        }
+        totalFrames += paddedFrames(infos[slot].frames);
+    }
+
+    // Pass 2: decode straight into the arena
+    if (totalFrames > 0)
+    {
+        bank->residentBytes = totalFrames * sizeof(float);
+        bank->arena = platformAlignedAlloc(SAMPLE_BANK_ALIGNMENT, bank->residentBytes);
+        if (bank->arena)
+            memset(bank->arena, 0, bank->residentBytes);
+        else
+            bank->residentBytes = 0;
+    }
+
+    float *cursor = bank->arena;
+    for (int slot = 0; slot < slotCount; slot++)
+    {
+        if (!files[slot])
+            continue;
+        SampleRef *ref = &bank->slots[slot];
+        if (cursor && ref->stream >= 0)
+        {
+            // The head, and real frames in the guard after it for the filters
+            const SampleStream *stream = &bank->streams[ref->stream];
+            ref->samples = cursor + guardFrames();
+            ref->frames = stream->frames;
+            ref->residentFrames = stream->residentFrames;
+            wavReadFrames(files[slot], &infos[slot], cursor + guardFrames(), stream->residentFrames + SAMPLE_BANK_GUARD_FRAMES);
+            cursor += paddedFrames(stream->residentFrames);
+            bank->loadedCount++;
+        }
+        else if (cursor)
+        {
+            ref->samples = cursor + guardFrames();
+            ref->frames = wavReadFrames(files[slot], &infos[slot], cursor + guardFrames(), infos[slot].frames);
+            ref->residentFrames = ref->frames;
+            cursor += paddedFrames(infos[slot].frames);
+            bank->loadedCount++;
+        }
+        fclose(files[slot]);
+    }
+
+    free(files);
+    free(infos);
+    bank->loadSeconds = platformTimeSeconds() - start;
+    return bank->loadedCount > 0;
+}
+
+void sampleBankFree(SampleBank *bank)
+{
+    for (int i = 0; i < bank->streamCount; i++)
+        platformFileMapClose(bank->streams[i].map);
+    free(bank->streams);
+    platformAlignedFree(bank->arena);
+    free(bank->slots);
+    memset(bank, 0, sizeof(*bank));
+}
@@ -0,0 +1,74 @@
+#ifndef SAMPLE_BANK_H
+#define SAMPLE_BANK_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "platform.h"
+#include "wav.h"
+
+// All note samples decoded once into a single aligned float arena.
+// Each sample starts on a SAMPLE_BANK_ALIGNMENT boundary with at least
+// SAMPLE_BANK_GUARD_FRAMES zero frames before and after it, so mix kernels
+// may read whole vectors past the end and resampling filters a few frames
+// either side.
+//
+// Samples longer than the load's stream threshold keep only their first
+// SAMPLE_BANK_HEAD_FRAMES in the arena, followed by the next guard's worth
+// of real frames rather than zeros. The file stays mapped and the rest is
+// decoded from it ahead of the voices by the sample streamer.
+#define SAMPLE_BANK_ALIGNMENT 64
+#define SAMPLE_BANK_GUARD_FRAMES 32 // At least RESAMPLER_REACH
+#define SAMPLE_BANK_HEAD_FRAMES 16384 // 0.37 s at 44.1 kHz: the prefetcher's head start
+#define SAMPLE_BANK_STREAM_SECONDS 2.0 // Default threshold
+
+typedef struct
+{
+    const float *samples; // NULL if the file failed to load
+    int32_t frames;
+    int32_t residentFrames; // Of frames, from the start; all unless streamed
+    int stream;             // Index into the bank's streams, or -1
+} SampleRef;
+
+// The part of a sample left on disk
+typedef struct
+{
+    PlatformFileMap *map;
+    WavInfo info; // dataOffset is into the mapping
+    int32_t frames;
+    int32_t residentFrames;
+} SampleStream;
+
+typedef struct
+{
+    float *arena;
+    size_t residentBytes;
+    int instrumentCount;
+    int noteCount;
+    SampleRef *slots; // [instrument * noteCount + row]
+    int loadedCount;
+    double loadSeconds;
+
+    SampleStream *streams;
+    int streamCount;
+    size_t streamedBytes; // Left on disk, as decoded floats
+} SampleBank;
+
+// Loads <root>/<instrumentDirs[i]>/<noteNames[row]>.wav for every pair, or
+// only the pairs set in `wanted` ([instrument * noteCount + row]) if it is
+// not NULL. Samples of more than streamAbove frames are streamed (0 keeps
+// everything resident); one that can't be mapped is loaded whole instead.
+// Missing or unreadable files leave an empty slot and are reported on
+// stderr; returns false only if nothing could be loaded.
+bool sampleBankLoad(SampleBank *bank, const char *root,
+                    const char *const *instrumentDirs, int instrumentCount,
+                    const char *const *noteNames, int noteCount, const bool *wanted, int32_t streamAbove);
+void sampleBankFree(SampleBank *bank);
+
+static inline const SampleRef *sampleBankGet(const SampleBank *bank, int instrument, int row)
+{
+    return &bank->slots[instrument * bank->noteCount + row];
+}
+
+#endif // SAMPLE_BANK_H
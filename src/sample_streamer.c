@@ -0,0 +1,187 @@
+#include "sample_streamer.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "trace.h"
+
+// Odd while claimed; kept non-negative so it shifts cleanly into a tag
+static int32_t nextGeneration(int32_t generation)
+{
+    return (generation + 1) & INT32_MAX;
+}
+
+// Chunks after the head, with one to spare in case a resampled voice's
+// last position rounds onto the final frame
+static int32_t chunkCount(const SampleStream *stream)
+{
+    return (stream->frames - stream->residentFrames) / SAMPLE_STREAM_CHUNK_FRAMES + 1;
+}
+
+bool sampleStreamerInit(SampleStreamer *streamer, const SampleBank *bank)
+{
+    memset(streamer, 0, sizeof(*streamer));
+    streamer->bank = bank;
+    if (bank->streamCount == 0)
+        return true;
+
+    size_t buffers = SAMPLE_STREAM_SLOTS * SAMPLE_STREAM_WINDOW + SAMPLE_STREAM_CACHE_CHUNKS;
+    streamer->arena = platformAlignedAlloc(SAMPLE_BANK_ALIGNMENT, buffers * SAMPLE_STREAM_BUFFER_FRAMES * sizeof(float));
+    if (!streamer->arena)
+        return false;
+
+    float *cursor = streamer->arena;
+    for (int i = 0; i < SAMPLE_STREAM_SLOTS; i++)
+    {
+        streamer->slots[i].buffers = cursor;
+        cursor += SAMPLE_STREAM_WINDOW * SAMPLE_STREAM_BUFFER_FRAMES;
+        for (int entry = 0; entry < SAMPLE_STREAM_WINDOW; entry++)
+            streamer->slots[i].tags[entry] = -1;
+    }
+    for (int i = 0; i < SAMPLE_STREAM_CACHE_CHUNKS; i++)
+    {
+        streamer->cacheBuffers[i] = cursor;
+        cursor += SAMPLE_STREAM_BUFFER_FRAMES;
+        streamer->cacheKeys[i] = -1;
+    }
+    return true;
+}
+
+void sampleStreamerFree(SampleStreamer *streamer)
+{
+    sampleStreamerStop(streamer);
+    platformAlignedFree(streamer->arena);
+    memset(streamer, 0, sizeof(*streamer));
+}
+
+// Frames [first - guard, first + chunk + guard) of the sample, zero past
+// either end of it
+static void decodeChunk(const SampleStream *stream, int32_t chunk, float *dst)
+{
+    int32_t first = stream->residentFrames + chunk * SAMPLE_STREAM_CHUNK_FRAMES - SAMPLE_BANK_GUARD_FRAMES;
+    int32_t count = SAMPLE_STREAM_BUFFER_FRAMES;
+    if (first + count > stream->frames)
+        count = stream->frames > first ? stream->frames - first : 0;
+    wavDecodeFrames(&stream->info, platformFileMapData(stream->map), first, count, dst);
+    memset(dst + count, 0, sizeof(float) * (size_t)(SAMPLE_STREAM_BUFFER_FRAMES - count));
+}
+
+static void fillChunk(SampleStreamer *streamer, int stream, int32_t chunk, float *dst)
+{
+    int64_t key = (int64_t)stream << 32 | chunk;
+    for (int i = 0; i < SAMPLE_STREAM_CACHE_CHUNKS; i++)
+    {
+        if (streamer->cacheKeys[i] == key)
+        {
+            memcpy(dst, streamer->cacheBuffers[i], sizeof(float) * SAMPLE_STREAM_BUFFER_FRAMES);
+            atomicStore32(&streamer->stats.cacheHits, streamer->stats.cacheHits + 1);
+            return;
+        }
+    }
+
+    TRACE_BEGIN(decode, "stream chunk");
+    int victim = streamer->cacheNext;
+    streamer->cacheNext = (victim + 1) % SAMPLE_STREAM_CACHE_CHUNKS;
+    decodeChunk(&streamer->bank->streams[stream], chunk, streamer->cacheBuffers[victim]);
+    streamer->cacheKeys[victim] = key;
+    memcpy(dst, streamer->cacheBuffers[victim], sizeof(float) * SAMPLE_STREAM_BUFFER_FRAMES);
+    atomicStore32(&streamer->stats.cacheMisses, streamer->stats.cacheMisses + 1);
+    TRACE_END(decode);
+}
+
+int sampleStreamerPrefetch(SampleStreamer *streamer)
+{
+    int filled = 0;
+    for (int i = 0; streamer->arena && i < SAMPLE_STREAM_SLOTS; i++)
+    {
+        SampleStreamSlot *slot = &streamer->slots[i];
+        int32_t generation = atomicLoad32(&slot->generation);
+        if (!(generation & 1))
+            continue;
+        // Both written before the generation; if the slot has been claimed
+        // again since, the fills below carry a stale tag and go unused
+        int stream = atomicLoad32(&slot->stream);
+        int32_t need = atomicLoad32(&slot->needChunk);
+        int32_t chunks = chunkCount(&streamer->bank->streams[stream]);
+        for (int32_t chunk = need; chunk < need + SAMPLE_STREAM_WINDOW && chunk < chunks; chunk++)
+        {
+            // The entry holds a chunk before `need` or nothing: free to overwrite
+            int entry = chunk % SAMPLE_STREAM_WINDOW;
+            int64_t tag = (int64_t)generation << 32 | chunk;
+            if (atomicLoad64(&slot->tags[entry]) == tag)
+                continue;
+            fillChunk(streamer, stream, chunk, slot->buffers + (size_t)entry * SAMPLE_STREAM_BUFFER_FRAMES);
+            atomicStore64(&slot->tags[entry], tag);
+            filled++;
+        }
+    }
+    if (filled)
+        atomicStore32(&streamer->stats.chunksFilled, streamer->stats.chunksFilled + filled);
+    return filled;
+}
+
+static void prefetchThreadMain(void *arg)
+{
+    SampleStreamer *streamer = arg;
+    TRACE_THREAD("prefetch");
+    while (atomicLoad32(&streamer->running))
+    {
+        if (sampleStreamerPrefetch(streamer) == 0)
+            platformSleepMs(SAMPLE_STREAM_POLL_MS);
+    }
+}
+
+bool sampleStreamerStart(SampleStreamer *streamer)
+{
+    if (!streamer->arena || streamer->thread)
+        return true;
+    atomicStore32(&streamer->running, 1);
+    streamer->thread = platformThreadStart(prefetchThreadMain, streamer);
+    if (!streamer->thread)
+    {
+        atomicStore32(&streamer->running, 0);
+        return false;
+    }
+    return true;
+}
+
+void sampleStreamerStop(SampleStreamer *streamer)
+{
+    if (!streamer->thread)
+        return;
+    atomicStore32(&streamer->running, 0);
+    platformThreadJoin(streamer->thread);
+    streamer->thread = NULL;
+}
+
+int sampleStreamerClaim(SampleStreamer *streamer, int stream)
+{
+    for (int i = 0; streamer->arena && i < SAMPLE_STREAM_SLOTS; i++)
+    {
+        if (streamer->claimed[i])
+            continue;
+        SampleStreamSlot *slot = &streamer->slots[i];
+        streamer->claimed[i] = true;
+        slot->missedChunk = -1;
+        atomicStore32(&slot->stream, stream);
+        atomicStore32(&slot->needChunk, 0);
+        atomicStore32(&slot->generation, nextGeneration(slot->generation));
+        return i;
+    }
+    atomicStore32(&streamer->stats.noSlot, streamer->stats.noSlot + 1);
+    return -1;
+}
+
+void sampleStreamerRelease(SampleStreamer *streamer, int slot)
+{
+    streamer->claimed[slot] = false;
+    atomicStore32(&streamer->slots[slot].generation, nextGeneration(streamer->slots[slot].generation));
+}
+
+void sampleStreamerPrintStats(SampleStreamer *streamer, FILE *out)
+{
+    SampleStreamStats *stats = &streamer->stats;
+    fprintf(out, "  streaming: %d chunks read ahead, cache hits %d, misses %d, underruns %d, voices cut for want of a slot %d\n",
+            atomicLoad32(&stats->chunksFilled), atomicLoad32(&stats->cacheHits), atomicLoad32(&stats->cacheMisses),
+            atomicLoad32(&stats->underruns), atomicLoad32(&stats->noSlot));
+}
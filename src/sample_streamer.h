@@ -0,0 +1,117 @@
+#ifndef SAMPLE_STREAMER_H
+#define SAMPLE_STREAMER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "platform.h"
+#include "sample_bank.h"
+
+// Plays the streamed part of long samples without the audio thread ever
+// touching the disk. A voice that starts a streamed sample claims a slot:
+// a window of SAMPLE_STREAM_WINDOW chunk buffers that the prefetch thread
+// keeps filled with the chunks just ahead of the voice, decoded from the
+// sample's mapping. The voice plays its resident head meanwhile. On the
+// audio thread a chunk is a tag check and a pointer; one the prefetcher
+// hasn't reached yet is an underrun and plays as silence.
+//
+// The audio thread owns claiming and releasing slots and publishes, per
+// slot, a generation (odd while claimed), the sample and the first chunk
+// it still needs. The single prefetch thread fills a buffer only once the
+// chunk it held is behind that, and tags it with the generation, so a
+// fill for a voice that has since ended never passes for the new one's.
+// Decoded chunks also go through a small cache on the prefetch side, so
+// retriggering a sample reads its file once.
+//
+// Each chunk buffer has SAMPLE_BANK_GUARD_FRAMES of the neighbouring
+// chunks' frames on either side, so resampling filters near its edges
+// read real data and kernels may overread.
+
+#define SAMPLE_STREAM_CHUNK_FRAMES 4096
+#define SAMPLE_STREAM_WINDOW 4        // Chunks read ahead per voice
+#define SAMPLE_STREAM_SLOTS 32        // Voices streaming at once
+#define SAMPLE_STREAM_CACHE_CHUNKS 64 // Decoded chunks kept for retriggers
+#define SAMPLE_STREAM_POLL_MS 2       // Prefetcher sleep when there was nothing to do
+#define SAMPLE_STREAM_BUFFER_FRAMES (SAMPLE_STREAM_CHUNK_FRAMES + 2 * SAMPLE_BANK_GUARD_FRAMES)
+
+typedef struct
+{
+    volatile int32_t generation;
+    volatile int32_t stream;    // Index into the bank's streams
+    volatile int32_t needChunk; // Chunks before it may be overwritten
+    volatile int64_t tags[SAMPLE_STREAM_WINDOW]; // generation << 32 | chunk held, or -1
+    float *buffers; // [SAMPLE_STREAM_WINDOW][SAMPLE_STREAM_BUFFER_FRAMES]
+    int32_t missedChunk; // Audio thread only: last underrun, counted once
+} SampleStreamSlot;
+
+typedef struct
+{
+    volatile int32_t chunksFilled; // Into voice windows
+    volatile int32_t cacheHits;    // Copied from the decoded-chunk cache
+    volatile int32_t cacheMisses;  // Decoded from the mapping, which may fault pages in from disk
+    volatile int32_t underruns;    // Chunks a voice reached before the prefetcher did
+    volatile int32_t noSlot;       // Voices cut after their head, every slot being in use
+} SampleStreamStats;
+
+typedef struct
+{
+    const SampleBank *bank;
+    SampleStreamSlot slots[SAMPLE_STREAM_SLOTS];
+    bool claimed[SAMPLE_STREAM_SLOTS]; // Audio thread only
+    float *arena;                      // Slot buffers, then cache buffers
+
+    // Prefetch thread only: decoded chunks, evicted round robin
+    int64_t cacheKeys[SAMPLE_STREAM_CACHE_CHUNKS]; // stream << 32 | chunk, or -1
+    float *cacheBuffers[SAMPLE_STREAM_CACHE_CHUNKS];
+    int cacheNext;
+
+    PlatformThread *thread;
+    volatile int32_t running;
+    SampleStreamStats stats;
+} SampleStreamer;
+
+// Sets up slots for the bank's streams; a no-op (returning true) if it has
+// none. The bank must outlive the streamer.
+bool sampleStreamerInit(SampleStreamer *streamer, const SampleBank *bank);
+void sampleStreamerFree(SampleStreamer *streamer);
+
+// The prefetch thread: runs passes until stopped, sleeping when idle.
+// Not needed when the audio is rendered offline, which calls
+// sampleStreamerPrefetch between blocks instead.
+bool sampleStreamerStart(SampleStreamer *streamer);
+void sampleStreamerStop(SampleStreamer *streamer);
+// One pass over the claimed slots; returns the chunks filled
+int sampleStreamerPrefetch(SampleStreamer *streamer);
+
+// Audio thread only. Claim returns a slot for `stream`, or -1 (counted) if
+// all are in use; release hands it back once the voice ends.
+int sampleStreamerClaim(SampleStreamer *streamer, int stream);
+void sampleStreamerRelease(SampleStreamer *streamer, int slot);
+
+// Audio thread only: chunk `chunk` of the slot's sample, frame 0 of it at
+// the returned pointer, or NULL if it isn't ready (counted as an underrun)
+static inline const float *sampleStreamerChunk(SampleStreamer *streamer, int slot, int32_t chunk)
+{
+    SampleStreamSlot *s = &streamer->slots[slot];
+    int entry = chunk % SAMPLE_STREAM_WINDOW;
+    if (atomicLoad64(&s->tags[entry]) != ((int64_t)s->generation << 32 | chunk))
+    {
+        if (s->missedChunk != chunk)
+            atomicStore32(&streamer->stats.underruns, streamer->stats.underruns + 1);
+        s->missedChunk = chunk;
+        return NULL;
+    }
+    return s->buffers + (size_t)entry * SAMPLE_STREAM_BUFFER_FRAMES + SAMPLE_BANK_GUARD_FRAMES;
+}
+
+// Audio thread only: the voice has moved on to `chunk`
+static inline void sampleStreamerAdvance(SampleStreamer *streamer, int slot, int32_t chunk)
+{
+    if (streamer->slots[slot].needChunk != chunk)
+        atomicStore32(&streamer->slots[slot].needChunk, chunk);
+}
+
+void sampleStreamerPrintStats(SampleStreamer *streamer, FILE *out);
+
+#endif // SAMPLE_STREAMER_H
@@ -0,0 +1,99 @@
+#include "sequencer.h"
+
+#include <math.h>
+
+static double framesPerStepFor(int32_t tempoMilliBpm)
+{
+    // One grid column per beat
+    return (double)AUDIO_SAMPLE_RATE * 60000.0 / (double)tempoMilliBpm;
+}
+
+static int64_t stepStartFrame(const Sequencer *seq, int64_t step)
+{
+    // Computed from the anchor each time so rounding never accumulates
+    return seq->anchorFrame + (int64_t)llround((double)(step - seq->anchorStep) * seq->framesPerStep);
+}
+
+void sequencerInit(Sequencer *seq, int stepCount, float tempo, SequencerStepFn onStep, void *user)
+{
+    *seq = (Sequencer){0};
+    seq->stepCount = stepCount;
+    seq->onStep = onStep;
+    seq->user = user;
+    seq->currentStep = -1;
+    seq->tempoMilliBpm = (int32_t)lroundf(tempo * 1000.0f);
+    seq->appliedTempoMilliBpm = seq->tempoMilliBpm;
+    seq->framesPerStep = framesPerStepFor(seq->tempoMilliBpm);
+}
+
+void sequencerSetPlaying(Sequencer *seq, bool playing)
+{
+    atomicStore32(&seq->playRequested, playing ? 1 : 0);
+}
+
+void sequencerSetTempo(Sequencer *seq, float bpm)
+{
+    atomicStore32(&seq->tempoMilliBpm, (int32_t)lroundf(bpm * 1000.0f));
+}
+
+int sequencerCurrentStep(Sequencer *seq)
+{
+    return atomicLoad32(&seq->currentStep);
+}
+
+void sequencerShiftFrames(Sequencer *seq, int64_t delta)
+{
+    seq->anchorFrame += delta;
+    seq->nextStepFrame += delta;
+}
+
+void sequencerProcessBlock(void *user, AudioEngine *engine, int64_t blockStart, int frames)
+{
+    Sequencer *seq = user;
+    bool wantPlaying = atomicLoad32(&seq->playRequested) != 0;
+    bool restart = false;
+
+    if (wantPlaying != seq->playing)
+    {
+        seq->playing = wantPlaying;
+        if (!wantPlaying)
+        {
+            atomicStore32(&seq->currentStep, -1);
+            return;
+        }
+        // Step 0 lands on the first frame of this block
+        seq->anchorFrame = blockStart;
+        seq->anchorStep = 0;
+        seq->nextStep = 0;
+        seq->nextStepFrame = blockStart;
+        restart = true;
+    }
+    if (!seq->playing)
+        return;
+
+    int32_t tempo = atomicLoad32(&seq->tempoMilliBpm);
+    if (tempo > 0 && tempo != seq->appliedTempoMilliBpm)
+    {
+        // Re-anchor on the boundary that is already scheduled; only the
+        // steps after it move
+        seq->anchorFrame = seq->nextStepFrame;
+        seq->anchorStep = seq->nextStep;
+        seq->appliedTempoMilliBpm = tempo;
+        seq->framesPerStep = framesPerStepFor(tempo);
+    }
+
+    int64_t blockEnd = blockStart + frames;
+    while (seq->nextStepFrame < blockEnd)
+    {
+        int step = (int)(seq->nextStep % seq->stepCount);
+        int offset = (int)(seq->nextStepFrame - blockStart);
+        seq->onStep(seq->user, engine, step, offset);
+        atomicStore32(&seq->currentStep, step);
+        if (engine)
+            audioEngineNoteStep(engine, seq->nextStepFrame, restart);
+        restart = false;
+
+        seq->nextStep++;
+        seq->nextStepFrame = stepStartFrame(seq, seq->nextStep);
+    }
+}
@@ -0,0 +1,60 @@
+#ifndef SEQUENCER_H
+#define SEQUENCER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "audio_engine.h"
+
+// Step clock driven by the audio engine's sample counter. Step n starts on
+// an exact sample frame derived from tempo, independent of the render loop;
+// other threads only read the published current step. Each block triggers
+// every step that starts inside it, at its frame offset. The engine thread
+// decides how far ahead that is: the audio thread works one block ahead of
+// the sink, the server link `lookahead` ahead of the server's clock. A new
+// tempo re-anchors on the first boundary not yet triggered and spaces the
+// steps after it; every boundary is computed from the anchor, so nothing
+// drifts.
+
+// Audio thread: trigger the notes of `step`, `offset` frames into the block
+typedef void (*SequencerStepFn)(void *user, AudioEngine *engine, int step, int offset);
+
+typedef struct
+{
+    // Requests, read at the start of each block
+    volatile int32_t playRequested;
+    volatile int32_t tempoMilliBpm;
+
+    // Published by the audio thread; -1 while stopped
+    volatile int32_t currentStep;
+
+    // Audio thread only
+    bool playing;
+    int32_t appliedTempoMilliBpm;
+    double framesPerStep;
+    int64_t anchorFrame; // Frame where anchorStep started
+    int64_t anchorStep;
+    int64_t nextStep;
+    int64_t nextStepFrame;
+    int stepCount;
+    SequencerStepFn onStep;
+    void *user;
+} Sequencer;
+
+void sequencerInit(Sequencer *seq, int stepCount, float tempo, SequencerStepFn onStep, void *user);
+
+// Any one thread, e.g. the Session applying commands; take effect at the
+// next block
+void sequencerSetPlaying(Sequencer *seq, bool playing);
+void sequencerSetTempo(Sequencer *seq, float bpm);
+int sequencerCurrentStep(Sequencer *seq);
+
+// Audio thread only: the frames passed to sequencerProcessBlock jump by
+// `delta`, e.g. onto a new server's clock; steps keep their place relative
+// to the next block
+void sequencerShiftFrames(Sequencer *seq, int64_t delta);
+
+// AudioBlockCallback; register with audioEngineSetBlockCallback(engine, sequencerProcessBlock, seq)
+void sequencerProcessBlock(void *user, AudioEngine *engine, int64_t blockStart, int frames);
+
+#endif // SEQUENCER_H
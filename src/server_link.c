@@ -0,0 +1,106 @@
+#include "server_link.h"
+
+#include <string.h>
+
+#include "audio_engine.h"
+#include "trace.h"
+
+#define SERVER_LINK_POLL_MS 2
+
+static void schedulerMain(void *arg)
+{
+    ServerLink *link = arg;
+    bool wasPlaying = false;
+    TRACE_THREAD("server link");
+    while (atomicLoad32(&link->running))
+    {
+        TRACE_BEGIN(schedule, "schedule steps");
+        int64_t consumerFrame = eventRingConsumerFrame(&link->ring);
+        if (consumerFrame < link->consumerFrame)
+        {
+            // A new server on a clock of its own: carry the steps over to it
+            sequencerShiftFrames(link->sequencer, consumerFrame - link->scheduledUntil);
+            link->scheduledUntil = consumerFrame;
+            serverLinkAllOff(link);
+        }
+        link->consumerFrame = consumerFrame;
+        // Never schedule into the past, e.g. when the server starts late
+        if (link->scheduledUntil < consumerFrame)
+            link->scheduledUntil = consumerFrame;
+
+        int64_t target = consumerFrame > 0 ? consumerFrame + link->lookaheadFrames : 0;
+        while (link->scheduledUntil < target)
+        {
+            int64_t frames = target - link->scheduledUntil;
+            if (frames > AUDIO_BLOCK_FRAMES)
+                frames = AUDIO_BLOCK_FRAMES;
+            link->blockStart = link->scheduledUntil;
+            sessionProcessBlock(link->session, NULL, link->blockStart, (int)frames);
+            link->scheduledUntil += frames;
+        }
+
+        // Notes already sent keep ringing on the server until released
+        bool playing = link->sequencer->playing;
+        if (wasPlaying && !playing)
+            serverLinkAllOff(link);
+        wasPlaying = playing;
+        TRACE_END(schedule);
+
+        platformSleepMs(SERVER_LINK_POLL_MS);
+    }
+}
+
+bool serverLinkStart(ServerLink *link, const char *name, Session *session, double lookaheadSeconds)
+{
+    memset(link, 0, sizeof(*link));
+    if (!eventRingCreate(&link->ring, name, EVENT_RING_DEFAULT_CAPACITY, AUDIO_SAMPLE_RATE))
+        return false;
+    link->session = session;
+    link->sequencer = session->sequencer;
+    link->lookaheadFrames = (int64_t)(lookaheadSeconds * AUDIO_SAMPLE_RATE);
+    atomicStore32(&link->running, 1);
+    link->thread = platformThreadStart(schedulerMain, link);
+    if (!link->thread)
+    {
+        eventRingClose(&link->ring);
+        return false;
+    }
+    return true;
+}
+
+void serverLinkStop(ServerLink *link)
+{
+    if (!link->thread)
+        return;
+    atomicStore32(&link->running, 0);
+    platformThreadJoin(link->thread);
+    link->thread = NULL;
+    serverLinkAllOff(link);
+    eventRingClose(&link->ring);
+}
+
+static void push(ServerLink *link, RingEvent *event)
+{
+    if (!eventRingPush(&link->ring, event))
+        atomicFetchAdd32(&link->droppedEvents, 1);
+}
+
+void serverLinkNoteOn(ServerLink *link, int offset, float frequency, int instrument, int32_t lengthFrames)
+{
+    RingEvent event = {0};
+    event.frame = link->blockStart + offset;
+    event.frequency = frequency;
+    event.length = lengthFrames;
+    event.type = RING_EVENT_NOTE_ON;
+    event.instrument = (uint8_t)instrument;
+    event.velocity = 100;
+    push(link, &event);
+}
+
+void serverLinkAllOff(ServerLink *link)
+{
+    RingEvent event = {0};
+    event.frame = link->scheduledUntil;
+    event.type = RING_EVENT_ALL_OFF;
+    push(link, &event);
+}
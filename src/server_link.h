@@ -0,0 +1,51 @@
+#ifndef SERVER_LINK_H
+#define SERVER_LINK_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "audio_engine.h"
+#include "event_ring.h"
+#include "platform.h"
+#include "session.h"
+
+// Drives a Session from sound_server.py's clock instead of the local audio
+// engine. A scheduling thread, the session's engine thread in this mode,
+// keeps the sequencer `lookahead` frames ahead of the server's published
+// frame, and the sequencer's step callback pushes time-stamped events into
+// the ring with serverLinkNoteOn.
+//
+// A published frame of 0 means no server has attached yet, and nothing is
+// scheduled. A frame that goes backwards is a restarted server: scheduling
+// moves onto its clock, and an all-off at its frame releases whatever the
+// old clock left scheduled.
+
+// Longest lookahead the ring holds at an event per block scheduled
+#define SERVER_LINK_MAX_LOOKAHEAD_SECONDS ((double)EVENT_RING_DEFAULT_CAPACITY * AUDIO_BLOCK_FRAMES / AUDIO_SAMPLE_RATE)
+
+typedef struct
+{
+    EventRing ring;
+    Session *session;
+    Sequencer *sequencer; // The session's
+    PlatformThread *thread;
+    volatile int32_t running;
+    int64_t lookaheadFrames;
+    int64_t scheduledUntil; // Scheduling thread only
+    int64_t consumerFrame;  // Last seen, scheduling thread only
+    int64_t blockStart;     // Frame of offset 0 during a step callback
+    volatile int32_t droppedEvents;
+} ServerLink;
+
+// Creates the ring under `name`; lookaheadSeconds is above 0 and at most
+// SERVER_LINK_MAX_LOOKAHEAD_SECONDS; the session sequencer's onStep must call
+// serverLinkNoteOn with this link as `user`
+bool serverLinkStart(ServerLink *link, const char *name, Session *session, double lookaheadSeconds);
+void serverLinkStop(ServerLink *link);
+
+// From the step callback: a note `offset` frames into the current window
+void serverLinkNoteOn(ServerLink *link, int offset, float frequency, int instrument, int32_t lengthFrames);
+// Releases everything the server is holding
+void serverLinkAllOff(ServerLink *link);
+
+#endif // SERVER_LINK_H
@@ -0,0 +1,137 @@
+#include "session.h"
+
+#include <string.h>
+
+#define SNAPSHOT_FRESH 4 // Set in middle when it holds an unread snapshot
+#define SNAPSHOT_INDEX 3
+
+bool sessionInit(Session *session, const Pattern *pattern, Sequencer *sequencer, Instrument instrument)
+{
+    memset(session, 0, sizeof(*session));
+    if (!patternCopy(&session->pattern, pattern))
+        return false;
+    session->sequencer = sequencer;
+    session->instrument = instrument;
+    session->back = 0;
+    session->middle = 1;
+    session->front = 2;
+
+    // Every slot starts as the initial state, so readers never see garbage
+    sessionPublish(session, 0);
+    for (int i = 0; i < 3; i++)
+        session->snapshots[i] = session->snapshots[session->middle & SNAPSHOT_INDEX];
+    return true;
+}
+
+// No engine thread may be running; frees the pages of applied commands
+// (the ones they replaced) and of pending ones (never swapped in) alike
+void sessionFree(Session *session)
+{
+    for (int i = 0; i < SESSION_COMMAND_QUEUE_SIZE; i++)
+        patternPageFree(session->commands[i].page);
+    patternFree(&session->pattern);
+}
+
+// Frees the pages the engine has swapped out since the last call
+static void reclaimPages(Session *session, int32_t read)
+{
+    for (; session->commandReclaimed != read; session->commandReclaimed++)
+    {
+        SessionCommand *slot = &session->commands[session->commandReclaimed & (SESSION_COMMAND_QUEUE_SIZE - 1)];
+        patternPageFree(slot->page);
+        slot->page = NULL;
+    }
+}
+
+bool sessionSend(Session *session, const SessionCommand *command)
+{
+    int32_t write = session->commandWrite; // Only this thread writes it
+    int32_t read = atomicLoad32(&session->commandRead);
+    reclaimPages(session, read);
+    if (write - read >= SESSION_COMMAND_QUEUE_SIZE)
+        return false;
+
+    session->commands[write & (SESSION_COMMAND_QUEUE_SIZE - 1)] = *command;
+    atomicStore32(&session->commandWrite, write + 1);
+    return true;
+}
+
+const SessionSnapshot *sessionSnapshot(Session *session)
+{
+    if (atomicLoad32(&session->middle) & SNAPSHOT_FRESH)
+        session->front = atomicExchange32(&session->middle, session->front) & SNAPSHOT_INDEX;
+    return &session->snapshots[session->front];
+}
+
+bool sessionSendPage(Session *session, const Pattern *replica, int col)
+{
+    int index = col / PATTERN_PAGE_COLS;
+    const PatternPage *page = replica->pages[index];
+    SessionCommand command = {.type = SESSION_SET_PAGE, .value = index};
+    if (page && !(command.page = patternPageCopy(page)))
+        return false;
+    if (sessionSend(session, &command))
+        return true;
+    patternPageFree(command.page);
+    return false;
+}
+
+static void applyCommand(Session *session, SessionCommand *command)
+{
+    Pattern *pattern = &session->pattern;
+    switch (command->type)
+    {
+    case SESSION_SET_PAGE:
+        // The old page goes back in the slot for the UI to free
+        if (command->value >= 0 && command->value < pattern->pageCount)
+            command->page = patternSwapPage(pattern, command->value, command->page);
+        break;
+    case SESSION_SET_INSTRUMENT:
+        if (command->value >= 0 && command->value < NUM_INSTRUMENTS)
+            session->instrument = (Instrument)command->value;
+        break;
+    case SESSION_SET_TEMPO:
+        sequencerSetTempo(session->sequencer, command->tempo);
+        break;
+    case SESSION_SET_PLAYING:
+        sequencerSetPlaying(session->sequencer, command->value != 0);
+        break;
+    }
+}
+
+void sessionApplyCommands(Session *session)
+{
+    int32_t read = session->commandRead; // Only this thread writes it
+    int32_t write = atomicLoad32(&session->commandWrite);
+    while (read != write)
+    {
+        applyCommand(session, &session->commands[read & (SESSION_COMMAND_QUEUE_SIZE - 1)]);
+        session->appliedCommands++;
+        read++;
+    }
+    atomicStore32(&session->commandRead, read);
+}
+
+void sessionPublish(Session *session, int64_t frame)
+{
+    const Sequencer *seq = session->sequencer;
+    SessionSnapshot *snapshot = &session->snapshots[session->back];
+    snapshot->sequence = ++session->published;
+    snapshot->frame = frame;
+    snapshot->playing = seq->playing;
+    snapshot->currentStep = seq->currentStep;
+    snapshot->tempo = (float)seq->tempoMilliBpm / 1000.0f;
+    snapshot->instrument = session->instrument;
+    snapshot->patternVersion = session->pattern.version;
+    snapshot->noteCount = session->pattern.noteCount;
+    snapshot->appliedCommands = session->appliedCommands;
+    session->back = atomicExchange32(&session->middle, session->back | SNAPSHOT_FRESH) & SNAPSHOT_INDEX;
+}
+
+void sessionProcessBlock(void *user, AudioEngine *engine, int64_t blockStart, int frames)
+{
+    Session *session = user;
+    sessionApplyCommands(session);
+    sequencerProcessBlock(session->sequencer, engine, blockStart, frames);
+    sessionPublish(session, blockStart + frames);
+}
@@ -0,0 +1,103 @@
+#ifndef SESSION_H
+#define SESSION_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "audio_engine.h"
+#include "pattern.h"
+#include "platform.h"
+#include "sequencer.h"
+
+// The song as the engine thread plays it. The engine thread (the audio
+// thread, or the server link's scheduling thread) is the only one that
+// touches the pattern and transport below. The UI sends edits as commands
+// over a wait-free single-producer queue; they are applied in order at
+// the start of the next block. After every block the engine publishes an
+// immutable snapshot through a triple buffer. Neither side ever waits for
+// the other. The UI keeps its own replica of the pattern, edited alongside
+// every command it sends, for drawing and hit tests.
+//
+// The engine thread never allocates or frees. A note edit sends a copy of
+// the replica's whole page, made on the UI thread; the engine swaps it in
+// and leaves the page it replaced in the command's slot, which the UI
+// frees once the engine has moved past it.
+
+#define SESSION_COMMAND_QUEUE_SIZE 256 // Must be a power of two
+
+typedef enum
+{
+    SESSION_SET_PAGE,       // value = page index, page = its new contents (NULL when empty)
+    SESSION_SET_INSTRUMENT, // value = Instrument
+    SESSION_SET_TEMPO,      // tempo in BPM
+    SESSION_SET_PLAYING     // value = play (1) or stop (0)
+} SessionCommandType;
+
+typedef struct
+{
+    SessionCommandType type;
+    int row;
+    int col;
+    int value;
+    float tempo;
+    PatternPage *page; // Owned by the queue once sent; the replaced page after it applies
+} SessionCommand;
+
+typedef struct
+{
+    uint32_t sequence; // Bumped on every publish
+    int64_t frame;     // First frame after the block
+    bool playing;
+    int currentStep; // -1 while stopped
+    float tempo;
+    Instrument instrument;
+    uint32_t patternVersion; // Of the engine's pattern
+    int noteCount;
+    int32_t appliedCommands;
+} SessionSnapshot;
+
+typedef struct
+{
+    SessionCommand commands[SESSION_COMMAND_QUEUE_SIZE];
+    volatile int32_t commandWrite;
+    volatile int32_t commandRead;
+    int32_t commandReclaimed; // UI only: slots before it have had their pages freed
+
+    // Triple buffer: the engine fills its back slot and swaps it into the
+    // middle with the fresh bit set; the reader swaps its front slot for
+    // the middle one when the bit is set
+    SessionSnapshot snapshots[3];
+    volatile int32_t middle;
+    int back;  // Engine thread only
+    int front; // Reader only
+
+    // Engine thread only
+    Pattern pattern;
+    Instrument instrument;
+    Sequencer *sequencer;
+    int32_t appliedCommands;
+    uint32_t published;
+} Session;
+
+// Copies the pattern; the sequencer's step callback reads session->pattern
+bool sessionInit(Session *session, const Pattern *pattern, Sequencer *sequencer, Instrument instrument);
+void sessionFree(Session *session);
+
+// UI thread. Returns false, dropping the command, if the queue is full;
+// the caller then keeps any page it carried.
+bool sessionSend(Session *session, const SessionCommand *command);
+// UI thread: sends a copy of the replica's page holding `col`. Returns
+// false if the copy can't be allocated or the queue is full.
+bool sessionSendPage(Session *session, const Pattern *replica, int col);
+// The latest published snapshot; valid until the next call
+const SessionSnapshot *sessionSnapshot(Session *session);
+
+// Engine thread, or the UI thread while no engine thread runs
+void sessionApplyCommands(Session *session);
+void sessionPublish(Session *session, int64_t frame);
+
+// AudioBlockCallback: applies the queued commands, runs the sequencer for
+// the block and publishes the result
+void sessionProcessBlock(void *user, AudioEngine *engine, int64_t blockStart, int frames);
+
+#endif // SESSION_H
@@ -0,0 +1,235 @@
+#include "synth.h"
+
+#include <math.h>
+#include <stdint.h>
+#include <string.h>
+
+// Harmonic tables and envelopes from tools/bake_samples.c. The recipes give
+// the envelope as fractions of a 0.5 s note; here they are absolute times,
+// and the gate ends where the recipe's release segment began.
+const SynthPatch SYNTH_PATCHES[SYNTH_PATCH_COUNT] = {
+    {"piano", {{1.0f, 1.0f}, {0.6f, 2.0f}, {0.4f, 3.0f}, {0.2f, 4.0f}}, 4, 0.010f, 0.05f, 0.3f, 0.15f, 0.35f},
+    {"synth", {{1.0f, 1.0f}, {0.5f, 1.01f}, {0.5f, 0.99f}, {0.3f, 2.0f}}, 4, 0.050f, 0.05f, 0.6f, 0.10f, 0.40f},
+    {"bell", {{1.0f, 1.0f}, {0.7f, 2.4f}, {0.5f, 3.0f}, {0.3f, 4.7f}}, 4, 0.005f, 0.05f, 0.2f, 0.25f, 0.25f}};
+
+// One sine cycle plus a guard point for interpolation
+static float sineTable[SYNTH_TABLE_SIZE + 1];
+static bool sineTableReady;
+
+static void buildSineTable(void)
+{
+    if (sineTableReady)
+        return;
+    for (int i = 0; i <= SYNTH_TABLE_SIZE; i++)
+        sineTable[i] = (float)sin(2.0 * 3.14159265358979323846 * i / SYNTH_TABLE_SIZE);
+    sineTableReady = true;
+}
+
+void synthInit(Synth *synth, int sampleRate)
+{
+    memset(synth, 0, sizeof(*synth));
+    synth->sampleRate = sampleRate;
+    voicePoolInit(&synth->pool, VOICE_POOL_DEFAULT_VOICES, VOICE_STEAL_OLDEST);
+    buildSineTable();
+}
+
+void synthSetPolyphony(Synth *synth, int voices, VoiceStealPolicy policy)
+{
+    voicePoolInit(&synth->pool, voices, policy);
+}
+
+static int32_t secondsToFrames(const Synth *synth, float seconds)
+{
+    int32_t frames = (int32_t)lroundf(seconds * (float)synth->sampleRate);
+    return frames > 0 ? frames : 1;
+}
+
+// Sets up a linear ramp from the current level to `target`
+static void enterStage(const Synth *synth, SynthVoice *voice, SynthStage stage)
+{
+    const SynthPatch *patch = voice->patch;
+    voice->stage = stage;
+    switch (stage)
+    {
+    case SYNTH_ATTACK:
+        voice->stageFrames = secondsToFrames(synth, patch->attack);
+        voice->slope = (1.0f - voice->level) / (float)voice->stageFrames;
+        break;
+    case SYNTH_DECAY:
+        voice->stageFrames = secondsToFrames(synth, patch->decay);
+        voice->slope = (patch->sustain - voice->level) / (float)voice->stageFrames;
+        break;
+    case SYNTH_SUSTAIN:
+        voice->stageFrames = INT32_MAX; // Left by the gate
+        voice->slope = 0.0f;
+        break;
+    case SYNTH_RELEASE:
+        voice->stageFrames = secondsToFrames(synth, patch->release);
+        voice->slope = -voice->level / (float)voice->stageFrames;
+        break;
+    case SYNTH_DONE:
+        voice->stageFrames = INT32_MAX;
+        voice->slope = 0.0f;
+        voice->level = 0.0f;
+        break;
+    }
+}
+
+// A quick release from wherever the envelope is
+static void fadeOut(const Synth *synth, SynthVoice *voice)
+{
+    if (voice->delay > 0)
+    {
+        // Never sounded: run out the fade in silence
+        voice->delay = 0;
+        voice->level = 0.0f;
+    }
+    voice->stage = SYNTH_RELEASE;
+    voice->stageFrames = secondsToFrames(synth, VOICE_POOL_FADE_SECONDS);
+    voice->slope = -voice->level / (float)voice->stageFrames;
+}
+
+void synthNoteOn(Synth *synth, const SynthPatch *patch, float frequency, float gain, int offset)
+{
+    // Same patch and frequency is the same pitch for retriggering
+    uint32_t frequencyBits;
+    memcpy(&frequencyBits, &frequency, sizeof(frequencyBits));
+    uint64_t key = ((uint64_t)(uintptr_t)patch << 32) ^ frequencyBits;
+
+    int fadeSlot;
+    int slot = voicePoolAlloc(&synth->pool, key, &fadeSlot);
+    if (fadeSlot >= 0)
+        fadeOut(synth, &synth->voices[fadeSlot]);
+    SynthVoice *voice = &synth->voices[slot];
+
+    // Normalize so the partials can never sum past full scale
+    float total = 0.0f;
+    for (int p = 0; p < patch->partialCount; p++)
+        total += patch->partials[p].amplitude;
+
+    memset(voice, 0, sizeof(*voice));
+    voice->patch = patch;
+    voice->partialCount = patch->partialCount;
+    for (int p = 0; p < patch->partialCount; p++)
+    {
+        double cycles = (double)frequency * patch->partials[p].ratio / synth->sampleRate;
+        voice->increment[p] = (uint32_t)(cycles * 4294967296.0);
+        voice->amplitude[p] = patch->partials[p].amplitude / total * gain;
+    }
+    voice->gain = gain;
+    voice->gateFrames = secondsToFrames(synth, patch->gate);
+    voice->delay = offset;
+    enterStage(synth, voice, SYNTH_ATTACK);
+    synth->pool.slots[slot].level = gain;
+}
+
+// Renders `frames` frames of one voice into out without crossing a stage
+// or gate boundary
+static void renderSegment(SynthVoice *voice, float *out, int frames)
+{
+    const int shift = 32 - SYNTH_TABLE_BITS;
+    const float fracScale = 1.0f / (float)(1u << shift);
+    float level = voice->level;
+    float slope = voice->slope;
+
+    for (int p = 0; p < voice->partialCount; p++)
+    {
+        // Each partial ramps the envelope from the same start level
+        uint32_t phase = voice->phase[p];
+        uint32_t increment = voice->increment[p];
+        float amplitude = voice->amplitude[p];
+        float env = level;
+        for (int i = 0; i < frames; i++)
+        {
+            uint32_t index = phase >> shift;
+            float frac = (float)(phase & ((1u << shift) - 1)) * fracScale;
+            float a = sineTable[index];
+            float s = a + (sineTable[index + 1] - a) * frac;
+            out[i] += s * amplitude * env;
+            env += slope;
+            phase += increment;
+        }
+        voice->phase[p] = phase;
+    }
+    voice->level = level + slope * (float)frames;
+}
+
+// Returns false once the voice has finished
+static bool renderVoice(const Synth *synth, SynthVoice *voice, float *out, int frames)
+{
+    int start = 0;
+    if (voice->delay > 0)
+    {
+        if (voice->delay >= frames)
+        {
+            voice->delay -= frames;
+            return true;
+        }
+        start = voice->delay;
+        voice->delay = 0;
+    }
+
+    while (start < frames)
+    {
+        int n = frames - start;
+        if (n > voice->stageFrames)
+            n = voice->stageFrames;
+        if (voice->stage < SYNTH_RELEASE && n > voice->gateFrames)
+            n = voice->gateFrames;
+
+        if (n > 0)
+        {
+            renderSegment(voice, out + start, n);
+            start += n;
+            voice->stageFrames -= n;
+            if (voice->stage < SYNTH_RELEASE)
+                voice->gateFrames -= n;
+        }
+
+        if (voice->stage < SYNTH_RELEASE && voice->gateFrames == 0)
+        {
+            enterStage(synth, voice, SYNTH_RELEASE);
+        }
+        else if (voice->stageFrames == 0)
+        {
+            switch (voice->stage)
+            {
+            case SYNTH_ATTACK:
+                voice->level = 1.0f;
+                enterStage(synth, voice, SYNTH_DECAY);
+                break;
+            case SYNTH_DECAY:
+                voice->level = voice->patch->sustain;
+                enterStage(synth, voice, SYNTH_SUSTAIN);
+                break;
+            default:
+                enterStage(synth, voice, SYNTH_DONE);
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+void synthRender(Synth *synth, float *out, int frames)
+{
+    VoicePool *pool = &synth->pool;
+    for (int i = 0; i < pool->activeCount;)
+    {
+        int slot = pool->active[i];
+        SynthVoice *voice = &synth->voices[slot];
+        if (!renderVoice(synth, voice, out, frames))
+        {
+            // Finished: the last active slot takes its place
+            voicePoolFree(pool, slot);
+            continue;
+        }
+        pool->slots[slot].level = voice->level * voice->gain;
+        i++;
+    }
+}
+
+float synthPatchLength(const SynthPatch *patch)
+{
+    return patch->gate + patch->release;
+}
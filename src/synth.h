@@ -0,0 +1,89 @@
+#ifndef SYNTH_H
+#define SYNTH_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "voice_pool.h"
+
+// Block-based additive synth: the voice models of tools/bake_samples.c
+// rendered live on the audio thread, so any pitch plays without sample
+// memory. Each partial is a phase-accumulator oscillator reading a shared
+// sine table; each voice has a linear ADSR.
+
+#define SYNTH_MAX_PARTIALS 4
+#define SYNTH_TABLE_BITS 11
+#define SYNTH_TABLE_SIZE (1 << SYNTH_TABLE_BITS)
+
+typedef struct
+{
+    float amplitude;
+    float ratio; // Frequency multiple of the fundamental
+} SynthPartial;
+
+typedef struct
+{
+    const char *name;
+    SynthPartial partials[SYNTH_MAX_PARTIALS];
+    int partialCount;
+    float attack;  // Seconds
+    float decay;   // Seconds
+    float sustain; // Level, 0-1
+    float release; // Seconds
+    float gate;    // Seconds from note-on until the release starts
+} SynthPatch;
+
+// Indexed by Instrument: piano, synth, bell
+#define SYNTH_PATCH_COUNT 3
+extern const SynthPatch SYNTH_PATCHES[SYNTH_PATCH_COUNT];
+
+typedef enum
+{
+    SYNTH_ATTACK,
+    SYNTH_DECAY,
+    SYNTH_SUSTAIN,
+    SYNTH_RELEASE,
+    SYNTH_DONE
+} SynthStage;
+
+typedef struct
+{
+    const SynthPatch *patch;
+    uint32_t phase[SYNTH_MAX_PARTIALS]; // Full turn = 2^32
+    uint32_t increment[SYNTH_MAX_PARTIALS];
+    float amplitude[SYNTH_MAX_PARTIALS]; // Normalized, gain applied
+    int partialCount;
+
+    SynthStage stage;
+    float level;
+    float slope;         // Level change per frame in this stage
+    int32_t stageFrames; // Frames left in this stage
+    int32_t gateFrames;  // Frames left until the release
+    int32_t delay;       // Frames of silence before the first sample
+    float gain;
+} SynthVoice;
+
+typedef struct
+{
+    int sampleRate;
+    SynthVoice voices[VOICE_POOL_MAX_SLOTS]; // Indexed by pool slot
+    VoicePool pool;
+} Synth;
+
+// With VOICE_POOL_DEFAULT_VOICES, stealing the oldest
+void synthInit(Synth *synth, int sampleRate);
+// Resizes the pool, silencing every voice; not while rendering
+void synthSetPolyphony(Synth *synth, int voices, VoiceStealPolicy policy);
+
+// Starts a voice `offset` frames into the next rendered block. When the
+// pool steals a voice for it, that one fades out over
+// VOICE_POOL_FADE_SECONDS.
+void synthNoteOn(Synth *synth, const SynthPatch *patch, float frequency, float gain, int offset);
+
+// Adds the next `frames` frames of every voice into out
+void synthRender(Synth *synth, float *out, int frames);
+
+// Seconds from note-on until a voice of this patch falls silent
+float synthPatchLength(const SynthPatch *patch);
+
+#endif // SYNTH_H
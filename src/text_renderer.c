@@ -0,0 +1,189 @@
+#include "text_renderer.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "font8x8.h"
+
+// Atlas of 16 x 6 glyph cells: the font in ASCII order, then one solid
+// cell that rectangles sample
+#define ATLAS_COLUMNS 16
+#define ATLAS_ROWS 6
+#define ATLAS_WIDTH (ATLAS_COLUMNS * FONT_GLYPH_SIZE)
+#define ATLAS_HEIGHT (ATLAS_ROWS * FONT_GLYPH_SIZE)
+#define ATLAS_SOLID_CELL FONT_GLYPH_COUNT
+
+static GLuint createAtlas(void)
+{
+    unsigned char pixels[ATLAS_HEIGHT][ATLAS_WIDTH];
+    for (int glyph = 0; glyph <= ATLAS_SOLID_CELL; glyph++)
+    {
+        int cellX = (glyph % ATLAS_COLUMNS) * FONT_GLYPH_SIZE;
+        int cellY = (glyph / ATLAS_COLUMNS) * FONT_GLYPH_SIZE;
+        for (int y = 0; y < FONT_GLYPH_SIZE; y++)
+        {
+            for (int x = 0; x < FONT_GLYPH_SIZE; x++)
+            {
+                bool on = glyph == ATLAS_SOLID_CELL || (FONT8X8[glyph][y] >> x) & 1;
+                pixels[cellY + y][cellX + x] = on ? 255 : 0;
+            }
+        }
+    }
+
+    GLuint texture;
+    glGenTextures(1, &texture);
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, ATLAS_WIDTH, ATLAS_HEIGHT, 0, GL_RED, GL_UNSIGNED_BYTE, pixels);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    return texture;
+}
+
+// aRect, aAtlas, aColor
+static const GlLoaderInstanceAttrib INSTANCE_ATTRIBS[] = {
+    {4, offsetof(TextQuad, x)},
+    {4, offsetof(TextQuad, u)},
+    {3, offsetof(TextQuad, r)}};
+
+bool textRendererInit(TextRenderer *renderer)
+{
+    memset(renderer, 0, sizeof(*renderer));
+
+    renderer->program = glLoaderBuildProgram("shaders/text_vertex.glsl", "shaders/text_fragment.glsl");
+    if (!renderer->program)
+        return false;
+    renderer->transformLoc = glGetUniformLocation(renderer->program, "transform");
+    renderer->atlasLoc = glGetUniformLocation(renderer->program, "atlas");
+    renderer->atlas = createAtlas();
+
+    renderer->quadVbo = glLoaderCreateQuadVbo();
+    glGenBuffers(1, &renderer->instanceVbo);
+    renderer->vao = glLoaderCreateInstancedVao(renderer->quadVbo, renderer->instanceVbo, sizeof(TextQuad),
+                                               INSTANCE_ATTRIBS, 3);
+    return true;
+}
+
+void textRendererShutdown(TextRenderer *renderer)
+{
+    if (renderer->vao)
+        glDeleteVertexArrays(1, &renderer->vao);
+    GLuint buffers[] = {renderer->quadVbo, renderer->instanceVbo};
+    for (int i = 0; i < 2; i++)
+    {
+        if (buffers[i])
+            glDeleteBuffers(1, &buffers[i]);
+    }
+    if (renderer->atlas)
+        glDeleteTextures(1, &renderer->atlas);
+    if (renderer->program)
+        glDeleteProgram(renderer->program);
+    free(renderer->quads);
+    memset(renderer, 0, sizeof(*renderer));
+}
+
+void textRendererClear(TextRenderer *renderer)
+{
+    renderer->quadCount = 0;
+    renderer->uploaded = false;
+}
+
+static TextQuad *addQuad(TextRenderer *renderer)
+{
+    if (renderer->quadCount == renderer->quadCapacity)
+    {
+        int grown = renderer->quadCapacity ? renderer->quadCapacity * 2 : 256;
+        TextQuad *bigger = realloc(renderer->quads, sizeof(TextQuad) * (size_t)grown);
+        if (!bigger)
+            return NULL;
+        renderer->quads = bigger;
+        renderer->quadCapacity = grown;
+    }
+    renderer->uploaded = false;
+    return &renderer->quads[renderer->quadCount++];
+}
+
+static void setColor(TextQuad *quad, const float color[3])
+{
+    quad->r = color[0];
+    quad->g = color[1];
+    quad->b = color[2];
+}
+
+void textRendererAddText(TextRenderer *renderer, const char *text, float x, float y, float scale, const float color[3])
+{
+    // Snap to whole pixels so nearest sampling keeps the glyphs crisp
+    float size = FONT_GLYPH_SIZE * scale;
+    float penX = floorf(x + 0.5f);
+    float top = floorf(y - size * 0.5f + 0.5f);
+    for (const char *c = text; *c; c++, penX += size)
+    {
+        int glyph = (unsigned char)*c - FONT_FIRST_CHAR;
+        if (glyph == 0)
+            continue; // Space
+        if (glyph < 0 || glyph >= FONT_GLYPH_COUNT)
+            glyph = '?' - FONT_FIRST_CHAR;
+
+        TextQuad *quad = addQuad(renderer);
+        if (!quad)
+            return;
+        quad->x = penX;
+        quad->y = top;
+        quad->width = size;
+        quad->height = size;
+        quad->u = (float)(glyph % ATLAS_COLUMNS) / ATLAS_COLUMNS;
+        quad->v = (float)(glyph / ATLAS_COLUMNS) / ATLAS_ROWS;
+        quad->uWidth = 1.0f / ATLAS_COLUMNS;
+        quad->vHeight = 1.0f / ATLAS_ROWS;
+        setColor(quad, color);
+    }
+}
+
+void textRendererAddRect(TextRenderer *renderer, float x, float y, float width, float height, const float color[3])
+{
+    TextQuad *quad = addQuad(renderer);
+    if (!quad)
+        return;
+    quad->x = x;
+    quad->y = y;
+    quad->width = width;
+    quad->height = height;
+    // Every fragment samples the middle of the solid cell
+    quad->u = ((ATLAS_SOLID_CELL % ATLAS_COLUMNS) + 0.5f) / ATLAS_COLUMNS;
+    quad->v = ((ATLAS_SOLID_CELL / ATLAS_COLUMNS) + 0.5f) / ATLAS_ROWS;
+    quad->uWidth = 0.0f;
+    quad->vHeight = 0.0f;
+    setColor(quad, color);
+}
+
+void textRendererDraw(TextRenderer *renderer, int fbWidth, int fbHeight)
+{
+    if (renderer->quadCount == 0)
+        return;
+
+    if (!renderer->uploaded)
+    {
+        glLoaderUploadInstances(renderer->instanceVbo, &renderer->instanceVboBytes, renderer->quads,
+                                sizeof(TextQuad) * (size_t)renderer->quadCount);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        renderer->uploaded = true;
+    }
+
+    float transform[16];
+    glLoaderPixelProjection(transform, fbWidth, fbHeight);
+
+    glUseProgram(renderer->program);
+    glUniformMatrix4fv(renderer->transformLoc, 1, GL_FALSE, transform);
+    glUniform1i(renderer->atlasLoc, 0);
+    glBindTexture(GL_TEXTURE_2D, renderer->atlas);
+    glBindVertexArray(renderer->vao);
+    glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, renderer->quadCount);
+
+    glBindVertexArray(0);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glUseProgram(0);
+}
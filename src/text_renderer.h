@@ -0,0 +1,54 @@
+#ifndef TEXT_RENDERER_H
+#define TEXT_RENDERER_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "gl_loader.h"
+
+// Batched UI text and flat rectangles. Glyphs come from the built-in 8x8
+// font, baked into one texture atlas at init. Every glyph and rectangle
+// is an instance in one buffer, drawn with a single instanced call in the
+// order it was added. The batch persists between frames: callers clear
+// and rebuild it only when what it shows changes, and the instance
+// buffer is uploaded only after such a rebuild.
+
+typedef struct
+{
+    float x, y, width, height; // Pixels
+    float u, v, uWidth, vHeight; // Atlas texture coordinates
+    float r, g, b;
+} TextQuad;
+
+typedef struct
+{
+    GLuint program;
+    GLint transformLoc;
+    GLint atlasLoc;
+    GLuint atlas;
+
+    GLuint quadVbo;
+    GLuint vao;
+    GLuint instanceVbo;
+    size_t instanceVboBytes;
+
+    TextQuad *quads;
+    int quadCount;
+    int quadCapacity;
+    bool uploaded; // The instance buffer matches quads
+} TextRenderer;
+
+bool textRendererInit(TextRenderer *renderer);
+void textRendererShutdown(TextRenderer *renderer);
+
+// Empties the batch
+void textRendererClear(TextRenderer *renderer);
+
+// Appends a line of text with its left edge at x and vertically centered
+// on y; each glyph is 8 * scale pixels square
+void textRendererAddText(TextRenderer *renderer, const char *text, float x, float y, float scale, const float color[3]);
+void textRendererAddRect(TextRenderer *renderer, float x, float y, float width, float height, const float color[3]);
+
+void textRendererDraw(TextRenderer *renderer, int fbWidth, int fbHeight);
+
+#endif // TEXT_RENDERER_H
@@ -0,0 +1,146 @@
+#include "trace.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#ifdef TRACE_ENABLED
+
+#if defined(_MSC_VER)
+#define TRACE_THREAD_LOCAL __declspec(thread)
+#else
+#define TRACE_THREAD_LOCAL _Thread_local
+#endif
+
+typedef struct
+{
+    const char *name;
+    double start;
+    double duration; // Negative for an instant event
+} TraceEvent;
+
+typedef struct
+{
+    const char *threadName;
+    int tid;
+    volatile int32_t written; // Total events; only the owning thread writes it
+    TraceEvent events[TRACE_RING_EVENTS];
+} TraceRing;
+
+static double traceEpoch;
+static TraceRing *rings[TRACE_MAX_THREADS];
+static volatile int32_t ringCount;
+static TRACE_THREAD_LOCAL TraceRing *threadRing;
+
+void traceInit(void)
+{
+    traceEpoch = platformTimeSeconds();
+}
+
+void traceRegisterThread(const char *name)
+{
+    if (threadRing)
+        return;
+    TraceRing *ring = calloc(1, sizeof(TraceRing));
+    if (!ring)
+        return;
+    int slot = atomicFetchAdd32(&ringCount, 1);
+    if (slot >= TRACE_MAX_THREADS)
+    {
+        free(ring);
+        return;
+    }
+    ring->threadName = name;
+    ring->tid = slot + 1;
+    threadRing = ring;
+    rings[slot] = ring;
+}
+
+static void push(const char *name, double start, double duration)
+{
+    TraceRing *ring = threadRing;
+    if (!ring)
+        return;
+    int32_t index = ring->written;
+    TraceEvent *event = &ring->events[index & (TRACE_RING_EVENTS - 1)];
+    event->name = name;
+    event->start = start;
+    event->duration = duration;
+    atomicStore32(&ring->written, index + 1);
+}
+
+void traceEnd(const TraceScope *scope)
+{
+    push(scope->name, scope->start, platformTimeSeconds() - scope->start);
+}
+
+void traceInstant(const char *name)
+{
+    push(name, platformTimeSeconds(), -1.0);
+}
+
+static void writeEvent(FILE *file, const TraceRing *ring, const TraceEvent *event, bool *first)
+{
+    double ts = (event->start - traceEpoch) * 1e6;
+    fprintf(file, "%s\n{\"name\":\"%s\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,", *first ? "" : ",", event->name, ring->tid, ts);
+    if (event->duration < 0.0)
+        fprintf(file, "\"ph\":\"i\",\"s\":\"t\"}");
+    else
+        fprintf(file, "\"ph\":\"X\",\"dur\":%.3f}", event->duration * 1e6);
+    *first = false;
+}
+
+bool traceWriteJson(const char *path)
+{
+    FILE *file = fopen(path, "w");
+    if (!file)
+    {
+        fprintf(stderr, "Failed to open %s for the trace\n", path);
+        return false;
+    }
+
+    static TraceEvent copy[TRACE_RING_EVENTS]; // Export runs on one thread
+    bool first = true;
+    int exported = 0;
+    fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+    int count = atomicLoad32(&ringCount);
+    for (int r = 0; r < count && r < TRACE_MAX_THREADS; r++)
+    {
+        TraceRing *ring = rings[r];
+        if (!ring)
+            continue;
+        fprintf(file, "%s\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"%s\"}}",
+                first ? "" : ",", ring->tid, ring->threadName);
+        first = false;
+
+        // Copy the newest events, then drop any the owner overwrote meanwhile
+        int32_t end = atomicLoad32(&ring->written);
+        int32_t begin = end > TRACE_RING_EVENTS ? end - TRACE_RING_EVENTS : 0;
+        for (int32_t i = begin; i < end; i++)
+            copy[i - begin] = ring->events[i & (TRACE_RING_EVENTS - 1)];
+        int32_t after = atomicLoad32(&ring->written);
+        // The owner may be mid-way through writing event `after` as well
+        int32_t safe = after + 1 - TRACE_RING_EVENTS > begin ? after + 1 - TRACE_RING_EVENTS : begin;
+        for (int32_t i = safe; i < end; i++)
+            writeEvent(file, ring, &copy[i - begin], &first);
+        exported += end - safe;
+    }
+    fprintf(file, "\n]}\n");
+    bool ok = fclose(file) == 0;
+    if (ok)
+        printf("Wrote %d trace events to %s\n", exported, path);
+    return ok;
+}
+
+#else
+
+void traceInit(void)
+{
+}
+
+bool traceWriteJson(const char *path)
+{
+    fprintf(stderr, "Tracing was compiled out; configure with -DENABLE_TRACE=ON to write %s\n", path);
+    return false;
+}
+
+#endif // TRACE_ENABLED
@@ -0,0 +1,61 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdbool.h>
+
+#include "platform.h"
+
+// Scoped timing markers for the main loop and the audio thread, exported as
+// Chrome trace JSON (chrome://tracing, ui.perfetto.dev). Each registered
+// thread writes complete events into its own fixed ring without locks, so
+// recording never blocks and always holds the most recent events; an export
+// copies whatever the rings hold at that moment.
+//
+// Build with TRACE_ENABLED (the CMake option ENABLE_TRACE, on by default)
+// for the markers; without it they compile to nothing and traceWriteJson
+// only reports that tracing is off.
+
+#define TRACE_RING_EVENTS 16384 // Per thread; must be a power of two
+#define TRACE_MAX_THREADS 8
+
+// Call once at startup; trace time starts here
+void traceInit(void);
+// Writes every registered thread's ring; returns false if tracing is
+// compiled out or the file can't be written
+bool traceWriteJson(const char *path);
+
+#ifdef TRACE_ENABLED
+
+typedef struct
+{
+    const char *name; // Must be a string literal or otherwise outlive the trace
+    double start;
+} TraceScope;
+
+// Gives the calling thread a ring and a name in the trace; events from
+// threads that never register are dropped
+void traceRegisterThread(const char *name);
+void traceEnd(const TraceScope *scope);
+void traceInstant(const char *name);
+
+static inline TraceScope traceBegin(const char *name)
+{
+    TraceScope scope = {name, platformTimeSeconds()};
+    return scope;
+}
+
+#define TRACE_THREAD(name) traceRegisterThread(name)
+#define TRACE_BEGIN(scope, name) TraceScope scope = traceBegin(name)
+#define TRACE_END(scope) traceEnd(&scope)
+#define TRACE_INSTANT(name) traceInstant(name)
+
+#else
+
+#define TRACE_THREAD(name) ((void)0)
+#define TRACE_BEGIN(scope, name) ((void)0)
+#define TRACE_END(scope) ((void)0)
+#define TRACE_INSTANT(name) ((void)0)
+
+#endif // TRACE_ENABLED
+
+#endif // TRACE_H
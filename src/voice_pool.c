@@ -0,0 +1,156 @@
+#include "voice_pool.h"
+
+#include <string.h>
+
+#include "platform.h"
+
+const char *const VOICE_STEAL_POLICY_NAMES[VOICE_STEAL_POLICY_COUNT] = {"oldest", "quietest", "same-pitch"};
+
+void voicePoolInit(VoicePool *pool, int capacity, VoiceStealPolicy policy)
+{
+    memset(pool, 0, sizeof(*pool));
+    if (capacity < 1)
+        capacity = 1;
+    if (capacity > VOICE_POOL_MAX_VOICES)
+        capacity = VOICE_POOL_MAX_VOICES;
+    pool->capacity = capacity;
+    pool->slotCount = capacity + VOICE_POOL_FADE_SLOTS;
+    pool->policy = policy;
+
+    // Pushed in reverse so slots are handed out from 0 up
+    for (int slot = pool->slotCount - 1; slot >= 0; slot--)
+        pool->freeSlots[pool->freeCount++] = slot;
+}
+
+// Sequence numbers wrap, so compare by difference
+static bool isOlder(const VoiceSlot *a, const VoiceSlot *b)
+{
+    return (int32_t)(a->order - b->order) < 0;
+}
+
+// The oldest used slot that is (or is not) fading, or -1
+static int findOldest(const VoicePool *pool, bool fading)
+{
+    int found = -1;
+    for (int i = 0; i < pool->activeCount; i++)
+    {
+        int slot = pool->active[i];
+        if (pool->slots[slot].fading == fading && (found < 0 || isOlder(&pool->slots[slot], &pool->slots[found])))
+            found = slot;
+    }
+    return found;
+}
+
+static int findQuietest(const VoicePool *pool)
+{
+    int found = -1;
+    for (int i = 0; i < pool->activeCount; i++)
+    {
+        int slot = pool->active[i];
+        const VoiceSlot *candidate = &pool->slots[slot];
+        if (candidate->fading)
+            continue;
+        if (found < 0 || candidate->level < pool->slots[found].level ||
+            (candidate->level == pool->slots[found].level && isOlder(candidate, &pool->slots[found])))
+            found = slot;
+    }
+    return found;
+}
+
+static int findKey(const VoicePool *pool, uint64_t key)
+{
+    int found = -1;
+    for (int i = 0; i < pool->activeCount; i++)
+    {
+        int slot = pool->active[i];
+        const VoiceSlot *candidate = &pool->slots[slot];
+        if (!candidate->fading && candidate->key == key && (found < 0 || isOlder(candidate, &pool->slots[found])))
+            found = slot;
+    }
+    return found;
+}
+
+static void bump(volatile int32_t *counter)
+{
+    atomicStore32(counter, *counter + 1);
+}
+
+int voicePoolAlloc(VoicePool *pool, uint64_t key, int *fadeSlot)
+{
+    int victim = -1;
+    if (pool->policy == VOICE_STEAL_SAME_PITCH)
+        victim = findKey(pool, key);
+    if (victim >= 0)
+    {
+        bump(&pool->stats.retriggers);
+    }
+    else if (pool->playing >= pool->capacity)
+    {
+        victim = pool->policy == VOICE_STEAL_QUIETEST ? findQuietest(pool) : findOldest(pool, false);
+        bump(&pool->stats.steals);
+    }
+    if (victim >= 0)
+    {
+        pool->slots[victim].fading = true;
+        pool->playing--;
+    }
+
+    int slot;
+    if (pool->freeCount > 0)
+    {
+        slot = pool->freeSlots[--pool->freeCount];
+        pool->activeIndex[slot] = pool->activeCount;
+        pool->active[pool->activeCount++] = slot;
+    }
+    else
+    {
+        // Every spare slot holds a fade: cut the oldest one short. There
+        // is always one, as playing voices alone never fill the slots.
+        slot = findOldest(pool, true);
+        bump(&pool->stats.cutFades);
+    }
+    *fadeSlot = victim != slot ? victim : -1;
+
+    VoiceSlot *entry = &pool->slots[slot];
+    entry->key = key;
+    entry->order = pool->nextOrder++;
+    entry->level = 1.0f;
+    entry->fading = false;
+    pool->playing++;
+    if (pool->playing > pool->stats.peakVoices)
+        atomicStore32(&pool->stats.peakVoices, pool->playing);
+    return slot;
+}
+
+void voicePoolFree(VoicePool *pool, int slot)
+{
+    if (!pool->slots[slot].fading)
+        pool->playing--;
+
+    int index = pool->activeIndex[slot];
+    int last = pool->active[--pool->activeCount];
+    pool->active[index] = last;
+    pool->activeIndex[last] = index;
+    pool->freeSlots[pool->freeCount++] = slot;
+}
+
+void voicePoolPrint(VoicePool *pool, const char *label, FILE *out)
+{
+    VoicePoolStats *stats = &pool->stats;
+    fprintf(out, "  %s: peak %d of %d (%s stealing), steals %d, retriggers %d, cut fades %d\n",
+            label, atomicLoad32(&stats->peakVoices), pool->capacity, VOICE_STEAL_POLICY_NAMES[pool->policy],
+            atomicLoad32(&stats->steals), atomicLoad32(&stats->retriggers), atomicLoad32(&stats->cutFades));
+}
+
+bool voiceStealPolicyParse(const char *name, VoiceStealPolicy *policy)
+{
+    for (int i = 0; i < VOICE_STEAL_POLICY_COUNT; i++)
+    {
+        if (strcmp(name, VOICE_STEAL_POLICY_NAMES[i]) == 0)
+        {
+            *policy = (VoiceStealPolicy)i;
+            return true;
+        }
+    }
+    return false;
+}
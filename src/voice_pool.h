@@ -0,0 +1,88 @@
+#ifndef VOICE_POOL_H
+#define VOICE_POOL_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+// Slot bookkeeping for a fixed array of voices, kept beside the voices by
+// their owner (the synth, the sample mixer). Nothing is allocated after
+// init: a stack of free slots makes allocate and free O(1), and a dense
+// list of used slots is what the renderer walks. At most `capacity` voices
+// play at once; past that a note-on steals one by the pool's policy. The
+// stolen voice keeps its slot for a short fade-out, so the slot arrays
+// carry VOICE_POOL_FADE_SLOTS of headroom beyond the capacity for those
+// tails. Audio thread only, apart from reading the stats.
+
+#define VOICE_POOL_MAX_VOICES 256
+#define VOICE_POOL_DEFAULT_VOICES 64
+#define VOICE_POOL_FADE_SLOTS 32
+#define VOICE_POOL_MAX_SLOTS (VOICE_POOL_MAX_VOICES + VOICE_POOL_FADE_SLOTS)
+#define VOICE_POOL_FADE_SECONDS 0.005f // Ramp-out of a stolen voice
+
+typedef enum
+{
+    VOICE_STEAL_OLDEST,     // The earliest note-on
+    VOICE_STEAL_QUIETEST,   // The lowest current level; oldest on a tie
+    VOICE_STEAL_SAME_PITCH, // A new note replaces one of the same key even
+                            // with voices free; otherwise the oldest
+    VOICE_STEAL_POLICY_COUNT
+} VoiceStealPolicy;
+
+extern const char *const VOICE_STEAL_POLICY_NAMES[VOICE_STEAL_POLICY_COUNT];
+
+typedef struct
+{
+    uint64_t key;   // Same key = same pitch on the same sound
+    uint32_t order; // Note-on sequence number; lower is older
+    float level;    // Loudness estimate, kept current by the owner
+    bool fading;    // Stolen; sounding out its fade
+} VoiceSlot;
+
+typedef struct
+{
+    volatile int32_t peakVoices; // Most voices playing at once, fades excluded
+    volatile int32_t steals;     // Voices faded out because the pool was full
+    volatile int32_t retriggers; // Voices faded out for a new note of the same key
+    volatile int32_t cutFades;   // Fades cut short because the headroom ran out
+} VoicePoolStats;
+
+typedef struct
+{
+    int capacity;
+    int slotCount; // capacity + VOICE_POOL_FADE_SLOTS
+    VoiceStealPolicy policy;
+
+    VoiceSlot slots[VOICE_POOL_MAX_SLOTS];
+    int freeSlots[VOICE_POOL_MAX_SLOTS]; // Stack
+    int freeCount;
+    int active[VOICE_POOL_MAX_SLOTS]; // Used slots, in no particular order
+    int activeIndex[VOICE_POOL_MAX_SLOTS]; // Slot -> its place in active
+    int activeCount;
+    int playing; // Used slots not fading
+    uint32_t nextOrder;
+
+    VoicePoolStats stats;
+} VoicePool;
+
+// capacity is clamped to 1..VOICE_POOL_MAX_VOICES; empties the pool
+void voicePoolInit(VoicePool *pool, int capacity, VoiceStealPolicy policy);
+
+// Returns the slot for a new note of `key`, which the caller (re)starts.
+// *fadeSlot is set to a voice the caller must start fading out, or -1.
+// The returned slot may be a fade that had to be cut: the caller simply
+// overwrites it. O(1) unless a voice has to be chosen for stealing, which
+// scans the voices in use.
+int voicePoolAlloc(VoicePool *pool, uint64_t key, int *fadeSlot);
+
+// The voice in `slot` has finished. O(1); moves another slot into its
+// place in active.
+void voicePoolFree(VoicePool *pool, int slot);
+
+// One line of use and steal counts on `out`; safe while the pool is in use
+void voicePoolPrint(VoicePool *pool, const char *label, FILE *out);
+
+// Parses a VOICE_STEAL_POLICY_NAMES entry
+bool voiceStealPolicyParse(const char *name, VoiceStealPolicy *policy);
+
+#endif // VOICE_POOL_H
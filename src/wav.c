@@ -0,0 +1,225 @@
+#include "wav.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "mix_kernels.h"
+
+static uint32_t readLE32(const unsigned char *p)
+{
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static void writeLE32(unsigned char *p, uint32_t v)
+{
+    p[0] = (unsigned char)v;
+    p[1] = (unsigned char)(v >> 8);
+    p[2] = (unsigned char)(v >> 16);
+    p[3] = (unsigned char)(v >> 24);
+}
+
+static void writeLE16(unsigned char *p, uint16_t v)
+{
+    p[0] = (unsigned char)v;
+    p[1] = (unsigned char)(v >> 8);
+}
+
+static uint16_t readLE16(const unsigned char *p)
+{
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+bool wavReadInfo(FILE *file, WavInfo *info)
+{
+    unsigned char header[12];
+    if (fread(header, 1, sizeof(header), file) != sizeof(header))
+        return false;
+    if (memcmp(header, "RIFF", 4) != 0 || memcmp(header + 8, "WAVE", 4) != 0)
+        return false;
+
+    bool haveFormat = false;
+    memset(info, 0, sizeof(*info));
+
+    // Walk the chunk list until we reach "data"; "fmt " must come first
+    unsigned char chunk[8];
+    while (fread(chunk, 1, sizeof(chunk), file) == sizeof(chunk))
+    {
+        uint32_t size = readLE32(chunk + 4);
+        if (memcmp(chunk, "fmt ", 4) == 0)
+        {
+            unsigned char fmt[16];
+            if (size < sizeof(fmt) || fread(fmt, 1, sizeof(fmt), file) != sizeof(fmt))
+                return false;
+            if (readLE16(fmt) != 1) // PCM only
+                return false;
+            info->channels = readLE16(fmt + 2);
+            info->sampleRate = (int)readLE32(fmt + 4);
+            info->bitsPerSample = readLE16(fmt + 14);
+            haveFormat = true;
+            if (fseek(file, (long)(size - sizeof(fmt) + (size & 1)), SEEK_CUR) != 0)
+                return false;
+        }
+        else if (memcmp(chunk, "data", 4) == 0)
+        {
+            if (!haveFormat || info->bitsPerSample != 16 || info->channels < 1)
+                return false;
+            info->frames = (int32_t)(size / (uint32_t)(2 * info->channels));
+            info->dataOffset = ftell(file);
+            return true;
+        }
+        else if (fseek(file, (long)(size + (size & 1)), SEEK_CUR) != 0)
+        {
+            return false;
+        }
+    }
+    return false;
+}
+
+// Little-endian 16-bit frames to mono floats
+static void decodeFrames(const unsigned char *raw, int channels, float *dst, int32_t frames)
+{
+    const float scale = 1.0f / (32768.0f * channels);
+    for (int32_t i = 0; i < frames; i++)
+    {
+        int32_t sum = 0;
+        for (int c = 0; c < channels; c++)
+            sum += (int16_t)readLE16(raw + 2 * ((size_t)i * channels + c));
+        dst[i] = (float)sum * scale;
+    }
+}
+
+int32_t wavReadFrames(FILE *file, const WavInfo *info, float *dst, int32_t maxFrames)
+{
+    int16_t buffer[1024];
+    int32_t framesPerRead = (int32_t)(sizeof(buffer) / sizeof(buffer[0])) / info->channels;
+    int32_t done = 0;
+
+    while (done < maxFrames)
+    {
+        int32_t want = maxFrames - done;
+        if (want > framesPerRead)
+            want = framesPerRead;
+        size_t got = fread(buffer, (size_t)(2 * info->channels), (size_t)want, file);
+        if (got == 0)
+            break;
+
+        decodeFrames((const unsigned char *)buffer, info->channels, dst + done, (int32_t)got);
+        done += (int32_t)got;
+    }
+    return done;
+}
+
+void wavDecodeFrames(const WavInfo *info, const void *file, int32_t first, int32_t frames, float *dst)
+{
+    const unsigned char *data = (const unsigned char *)file + info->dataOffset;
+    decodeFrames(data + (size_t)first * 2 * (size_t)info->channels, info->channels, dst, frames);
+}
+
+bool wavLoad(const char *path, WavData *out)
+{
+    memset(out, 0, sizeof(*out));
+
+    FILE *file = fopen(path, "rb");
+    if (!file)
+        return false;
+
+    WavInfo info;
+    if (!wavReadInfo(file, &info))
+    {
+        fclose(file);
+        return false;
+    }
+
+    out->samples = malloc(sizeof(float) * (size_t)(info.frames > 0 ? info.frames : 1));
+    if (!out->samples)
+    {
+        fclose(file);
+        return false;
+    }
+    out->frames = wavReadFrames(file, &info, out->samples, info.frames);
+    out->sampleRate = info.sampleRate;
+    fclose(file);
+    return true;
+}
+
+void wavFree(WavData *wav)
+{
+    free(wav->samples);
+    wav->samples = NULL;
+    wav->frames = 0;
+}
+
+static bool writeHeader(FILE *file, int32_t frames, int sampleRate)
+{
+    uint32_t dataBytes = (uint32_t)frames * 2;
+    unsigned char header[44];
+    memcpy(header, "RIFF", 4);
+    writeLE32(header + 4, 36 + dataBytes);
+    memcpy(header + 8, "WAVEfmt ", 8);
+    writeLE32(header + 16, 16);
+    writeLE16(header + 20, 1); // PCM
+    writeLE16(header + 22, 1); // Mono
+    writeLE32(header + 24, (uint32_t)sampleRate);
+    writeLE32(header + 28, (uint32_t)sampleRate * 2);
+    writeLE16(header + 32, 2);
+    writeLE16(header + 34, 16);
+    memcpy(header + 36, "data", 4);
+    writeLE32(header + 40, dataBytes);
+    return fwrite(header, 1, sizeof(header), file) == sizeof(header);
+}
+
+bool wavWriterOpen(WavWriter *writer, const char *path, int sampleRate)
+{
+    writer->frames = 0;
+    writer->sampleRate = sampleRate;
+    writer->file = fopen(path, "wb");
+    if (!writer->file)
+        return false;
+    if (!writeHeader(writer->file, 0, sampleRate))
+    {
+        fclose(writer->file);
+        writer->file = NULL;
+        return false;
+    }
+    return true;
+}
+
+bool wavWriterWrite(WavWriter *writer, const float *samples, int32_t frames)
+{
+    // Every supported host is little-endian, so converted samples go to disk as-is
+    int16_t buffer[1024];
+    int32_t done = 0;
+    while (done < frames)
+    {
+        int32_t n = frames - done;
+        if (n > (int32_t)(sizeof(buffer) / sizeof(buffer[0])))
+            n = (int32_t)(sizeof(buffer) / sizeof(buffer[0]));
+        mixKernels()->toS16(buffer, samples + done, n);
+        if (fwrite(buffer, 2, (size_t)n, writer->file) != (size_t)n)
+            return false;
+        done += n;
+    }
+    writer->frames += frames;
+    return true;
+}
+
+bool wavWriterClose(WavWriter *writer)
+{
+    if (!writer->file)
+        return false;
+    bool ok = fseek(writer->file, 0, SEEK_SET) == 0 && writeHeader(writer->file, writer->frames, writer->sampleRate);
+    ok = fclose(writer->file) == 0 && ok;
+    writer->file = NULL;
+    return ok;
+}
+
+bool wavWriteFile(const char *path, const int16_t *samples, int32_t frames, int sampleRate)
+{
+    FILE *file = fopen(path, "wb");
+    if (!file)
+        return false;
+    // Little-endian hosts only, as above: the samples go out in one write
+    bool ok = writeHeader(file, frames, sampleRate) &&
+              fwrite(samples, 2, (size_t)frames, file) == (size_t)frames;
+    return fclose(file) == 0 && ok;
+}
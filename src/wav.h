@@ -0,0 +1,55 @@
+#ifndef WAV_H
+#define WAV_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+// Minimal RIFF/WAVE reader and writer for 16-bit PCM files like those in sounds/.
+
+typedef struct
+{
+    int sampleRate;
+    int channels;
+    int bitsPerSample;
+    int32_t frames;
+    long dataOffset; // Byte offset of the first sample in the file
+} WavInfo;
+
+typedef struct
+{
+    float *samples; // Mono, [-1, 1]
+    int32_t frames;
+    int sampleRate;
+} WavData;
+
+// Parses the header and leaves the stream positioned at the sample data
+bool wavReadInfo(FILE *file, WavInfo *info);
+
+// Decodes up to maxFrames frames into dst, downmixing to mono.
+// Returns the number of frames written.
+int32_t wavReadFrames(FILE *file, const WavInfo *info, float *dst, int32_t maxFrames);
+// The same from the whole file already in memory (e.g. mapped): frames
+// [first, first + frames), which must all be in the file
+void wavDecodeFrames(const WavInfo *info, const void *file, int32_t first, int32_t frames, float *dst);
+
+bool wavLoad(const char *path, WavData *out);
+void wavFree(WavData *wav);
+
+// Streams mono float blocks to a 16-bit PCM file; sizes are patched on close
+typedef struct
+{
+    FILE *file;
+    int32_t frames;
+    int sampleRate;
+} WavWriter;
+
+bool wavWriterOpen(WavWriter *writer, const char *path, int sampleRate);
+// Clips to [-1, 1]
+bool wavWriterWrite(WavWriter *writer, const float *samples, int32_t frames);
+bool wavWriterClose(WavWriter *writer);
+
+// A whole mono 16-bit file at once
+bool wavWriteFile(const char *path, const int16_t *samples, int32_t frames, int sampleRate);
+
+#endif // WAV_H